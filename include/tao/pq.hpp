@@ -7,6 +7,7 @@
 #include <tao/pq/null.hpp>
 
 #include <tao/pq/connection.hpp>
+#include <tao/pq/observer.hpp>
 #include <tao/pq/transaction.hpp>
 
 #include <tao/pq/field.hpp>
@@ -14,6 +15,7 @@
 #include <tao/pq/row.hpp>
 
 #include <tao/pq/parameter_traits.hpp>
+#include <tao/pq/type_catalog.hpp>
 
 #include <tao/pq/result_traits.hpp>
 #include <tao/pq/result_traits_optional.hpp>
@@ -8,15 +8,22 @@
 #include <set>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <libpq-fe.h>
 
+#include <tao/pq/internal/wire.hpp>
+#include <tao/pq/observer.hpp>
 #include <tao/pq/result.hpp>
 #include <tao/pq/transaction.hpp>
+#include <tao/pq/type_catalog.hpp>
+#include <tao/pq/wire_counters.hpp>
 
 namespace tao::pq
 {
    class connection_pool;
+   class job_queue;
+   class multiplexer;
    class table_writer;
 
    namespace internal
@@ -33,18 +40,39 @@ namespace tao::pq
    {
    private:
       friend class connection_pool;
+      friend class job_queue;
+      friend class multiplexer;
       friend class pq::transaction;
       friend class table_writer;
 
       const std::unique_ptr< PGconn, internal::deleter > m_pgconn;
       pq::transaction* m_current_transaction;
       std::set< std::string, std::less<> > m_prepared_statements;
+      std::shared_ptr< pq::observer > m_observer;
+      std::shared_ptr< const type_catalog > m_types;
+      std::string m_application_name;
+      internal::wire_recorder m_wire;
 
       [[nodiscard]] auto error_message() const -> std::string;
       static void check_prepared_name( const std::string& name );
       [[nodiscard]] auto is_prepared( const char* name ) const noexcept -> bool;
 
-      [[nodiscard]] auto execute_params( const char* statement,
+      void clear_results();
+
+      // returns the number of bytes sent
+      auto send_params( const char* statement,
+                        const int n_params,
+                        const Oid types[],
+                        const char* const values[],
+                        const int lengths[],
+                        const int formats[] ) -> std::size_t;
+
+      void set_application_name( const std::string& name ) noexcept;
+      void wait_for_result( statement_event& event );
+      [[nodiscard]] auto get_result() -> PGresult*;
+
+      [[nodiscard]] auto execute_params( const statement_event::time_point started,
+                                         const char* statement,
                                          const int n_params,
                                          const Oid types[],
                                          const char* const values[],
@@ -75,6 +103,26 @@ namespace tao::pq
 
       [[nodiscard]] auto is_open() const noexcept -> bool;
 
+      void set_observer( std::shared_ptr< pq::observer > observer ) noexcept;
+
+      [[nodiscard]] auto observer() const noexcept -> const std::shared_ptr< pq::observer >&
+      {
+         return m_observer;
+      }
+
+      [[nodiscard]] auto wire_counters() const noexcept -> pq::wire_counters
+      {
+         return m_wire.snapshot();
+      }
+
+      // looks up the types with a single query and replaces the type catalog
+      void load_types( const std::vector< std::string >& names );
+
+      void set_types( std::shared_ptr< const type_catalog > types ) noexcept;
+
+      // the type catalog is empty unless types were loaded or set
+      [[nodiscard]] auto types() const noexcept -> const type_catalog&;
+
       void prepare( const std::string& name, const std::string& statement );
       void deallocate( const std::string& name );
 
@@ -4,27 +4,106 @@
 #ifndef TAO_PQ_CONNECTION_POOL_HPP
 #define TAO_PQ_CONNECTION_POOL_HPP
 
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <tuple>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
+#include <tao/pq/internal/gen.hpp>
 #include <tao/pq/internal/pool.hpp>
 
 #include <tao/pq/connection.hpp>
+#include <tao/pq/observer.hpp>
+#include <tao/pq/pool_metrics.hpp>
 #include <tao/pq/result.hpp>
 
 namespace tao::pq
 {
+   class job_queue;
+   class result_cache;
+
    class connection_pool
       : public internal::pool< pq::connection >
    {
    private:
+      friend class job_queue;
+      friend class result_cache;
+
       const std::string m_connection_info;
+      std::shared_ptr< pq::observer > m_observer;
+      std::shared_ptr< const type_catalog > m_types;
+
+      // in-flight coalesced statements, keyed by statement and encoded parameters
+      std::mutex m_flights_mutex;
+      std::map< std::string, std::shared_future< result >, std::less<> > m_flights;
+      std::atomic< std::uint64_t > m_coalesced{ 0 };
 
       [[nodiscard]] auto v_create() const -> std::unique_ptr< pq::connection > override;
 
       [[nodiscard]] auto v_is_valid( pq::connection& c ) const noexcept -> bool override;
 
+      // the connection is only checked out when it is needed, i.e. when the
+      // parameters need one to be encoded or when the statement is executed
+      [[nodiscard]] auto execute_coalesced_params( std::shared_ptr< pq::connection >& c,
+                                                   const char* statement,
+                                                   const int n_params,
+                                                   const Oid types[],
+                                                   const char* const values[],
+                                                   const int lengths[],
+                                                   const int formats[] ) -> result;
+
+      template< std::size_t... Os, std::size_t... Is, typename... Ts >
+      [[nodiscard]] auto execute_coalesced_indexed( std::shared_ptr< pq::connection >& c,
+                                                    const char* statement,
+                                                    std::index_sequence< Os... > /*unused*/,
+                                                    std::index_sequence< Is... > /*unused*/,
+                                                    const std::tuple< Ts... >& tuple )
+      {
+         const Oid types[] = { std::get< Os >( tuple ).template type< Is >()... };
+         const char* const values[] = { std::get< Os >( tuple ).template value< Is >()... };
+         const int lengths[] = { std::get< Os >( tuple ).template length< Is >()... };
+         const int formats[] = { std::get< Os >( tuple ).template format< Is >()... };
+         return execute_coalesced_params( c, statement, sizeof...( Os ), types, values, lengths, formats );
+      }
+
+      template< typename... Ts >
+      [[nodiscard]] auto execute_coalesced_traits( std::shared_ptr< pq::connection >& c, const char* statement, const Ts&... ts )
+      {
+         using gen = internal::gen< Ts::columns... >;
+         return execute_coalesced_indexed( c, statement, typename gen::outer_sequence(), typename gen::inner_sequence(), std::tie( ts... ) );
+      }
+
+      template< template< typename... > class Traits, typename A >
+      auto to_traits( std::shared_ptr< pq::connection >& c, A&& a )
+      {
+         using T = Traits< std::decay_t< A > >;
+         if constexpr( std::is_constructible_v< T, decltype( std::forward< A >( a ) ) > ) {
+            return T( std::forward< A >( a ) );
+         }
+         else if constexpr( std::is_constructible_v< T, PGconn*, decltype( std::forward< A >( a ) ) > ) {
+            if( !c ) {
+               c = this->connection();
+            }
+            return T( c->underlying_raw_ptr(), std::forward< A >( a ) );
+         }
+         else if constexpr( std::is_constructible_v< T, const type_catalog&, decltype( std::forward< A >( a ) ) > ) {
+            if( !c ) {
+               c = this->connection();
+            }
+            return T( c->types(), std::forward< A >( a ) );
+         }
+         else {
+            static_assert( std::is_void_v< T >, "no valid conversion from A to Traits" );
+         }
+      }
+
    public:
       [[nodiscard]] static auto create( const std::string& connection_info ) -> std::shared_ptr< connection_pool >;
 
@@ -41,16 +120,53 @@ namespace tao::pq
          : m_connection_info( connection_info )
       {}
 
-      [[nodiscard]] auto connection()
-      {
-         return this->get();
-      }
+      // the observer is installed on all connections handed out afterwards
+      void set_observer( std::shared_ptr< pq::observer > observer ) noexcept;
+      [[nodiscard]] auto observer() const noexcept -> std::shared_ptr< pq::observer >;
+
+      // looks up the types with a single query, the type catalog is shared by
+      // all connections handed out afterwards, as the Oids are the same for all
+      // connections to a database. types created later require another load.
+      void load_types( const std::vector< std::string >& names );
+      [[nodiscard]] auto types() const noexcept -> std::shared_ptr< const type_catalog >;
+
+      [[nodiscard]] auto connection() -> std::shared_ptr< pq::connection >;
 
       template< template< typename... > class Traits = parameter_text_traits, typename... Ts >
       auto execute( Ts&&... ts )
       {
          return this->connection()->direct()->execute< Traits >( std::forward< Ts >( ts )... );
       }
+
+      // opt-in single-flight execution: concurrent calls with the same statement
+      // and the same encoded parameters share one execution and its result (or
+      // exception), only suitable for statements without side effects
+      template< template< typename... > class Traits = parameter_text_traits, typename... As >
+      [[nodiscard]] auto execute_coalesced( const char* statement, As&&... as ) -> result
+      {
+         std::shared_ptr< pq::connection > c;
+         return execute_coalesced_traits( c, statement, to_traits< Traits >( c, std::forward< As >( as ) )... );
+      }
+
+      // short-cut for no-arguments invocations
+      template< template< typename... > class Traits = parameter_text_traits >
+      [[nodiscard]] auto execute_coalesced( const char* statement ) -> result
+      {
+         std::shared_ptr< pq::connection > c;
+         return execute_coalesced_params( c, statement, 0, nullptr, nullptr, nullptr, nullptr );
+      }
+
+      template< template< typename... > class Traits = parameter_text_traits, typename... As >
+      [[nodiscard]] auto execute_coalesced( const std::string& statement, As&&... as ) -> result
+      {
+         return execute_coalesced< Traits >( statement.c_str(), std::forward< As >( as )... );
+      }
+
+      // the number of calls to execute_coalesced() which shared the execution of another call
+      [[nodiscard]] auto coalesced() const noexcept -> std::uint64_t
+      {
+         return m_coalesced.load( std::memory_order_relaxed );
+      }
    };
 
 }  // namespace tao::pq
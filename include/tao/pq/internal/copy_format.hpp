@@ -0,0 +1,41 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#ifndef TAO_PQ_INTERNAL_COPY_FORMAT_HPP
+#define TAO_PQ_INTERNAL_COPY_FORMAT_HPP
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+namespace tao::pq::internal
+{
+   // the size of the COPY data sent at once
+   inline constexpr std::size_t copy_chunk_size = 64 * 1024;
+
+   // a field in the text format, escaped, or \N for nullptr
+   void append_copy_text( std::string& data, const char* value );
+
+   // a row in the text format, the fields of the parameter traits are separated by tabs
+   template< typename T, std::size_t... Is >
+   void append_copy_row( std::string& data, const T& t, std::index_sequence< Is... > /*unused*/ )
+   {
+      ( ( ( Is == 0 ) ? void() : void( data += '\t' ), append_copy_text( data, t.template value< Is >() ) ), ... );
+      data += '\n';
+   }
+
+   template< typename T >
+   void append_copy_row( std::string& data, const T& t )
+   {
+      append_copy_row( data, t, std::make_index_sequence< T::columns >() );
+   }
+
+   // the binary format, a row is the number of its fields followed by the fields
+   void append_copy_binary_header( std::string& data );
+   void append_copy_binary_row( std::string& data, const int fields );
+   void append_copy_binary_field( std::string& data, const char* value, const int length );
+   void append_copy_binary_trailer( std::string& data );
+
+}  // namespace tao::pq::internal
+
+#endif
@@ -0,0 +1,18 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#ifndef TAO_PQ_INTERNAL_FINGERPRINT_HPP
+#define TAO_PQ_INTERNAL_FINGERPRINT_HPP
+
+#include <string>
+#include <string_view>
+
+namespace tao::pq::internal
+{
+   // normalises a statement: literals are replaced by '?', comments are
+   // removed and runs of whitespace are collapsed into a single space
+   [[nodiscard]] auto fingerprint( const std::string_view statement ) -> std::string;
+
+}  // namespace tao::pq::internal
+
+#endif
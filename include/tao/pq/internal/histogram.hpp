@@ -0,0 +1,116 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#ifndef TAO_PQ_INTERNAL_HISTOGRAM_HPP
+#define TAO_PQ_INTERNAL_HISTOGRAM_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace tao::pq::internal
+{
+   // log-linear buckets in the spirit of HDR histograms: values below 32 are
+   // exact, above that each power of two is split into 16 buckets, giving a
+   // relative error of at most 1/16. values from 2^49 on are clamped.
+   struct histogram_buckets
+   {
+      static constexpr std::size_t linear = 32;
+      static constexpr std::size_t sub_buckets = 16;
+      static constexpr std::size_t max_exponent = 48;
+      static constexpr std::size_t size = linear + ( max_exponent - 4 ) * sub_buckets;
+
+      [[nodiscard]] static constexpr auto index( const std::uint64_t value ) noexcept -> std::size_t
+      {
+         if( value < linear ) {
+            return static_cast< std::size_t >( value );
+         }
+         std::size_t exponent = 5;
+         while( ( exponent < max_exponent ) && ( ( value >> ( exponent + 1 ) ) != 0 ) ) {
+            ++exponent;
+         }
+         if( ( value >> exponent ) > 1 ) {
+            return size - 1;
+         }
+         const auto top = static_cast< std::size_t >( value >> ( exponent - 4 ) );
+         return linear + ( exponent - 5 ) * sub_buckets + ( top - sub_buckets );
+      }
+
+      // the smallest value which is mapped to the given bucket
+      [[nodiscard]] static constexpr auto lower_bound( const std::size_t index ) noexcept -> std::uint64_t
+      {
+         if( index < linear ) {
+            return index;
+         }
+         const std::size_t exponent = 5 + ( index - linear ) / sub_buckets;
+         const std::size_t top = sub_buckets + ( index - linear ) % sub_buckets;
+         return static_cast< std::uint64_t >( top ) << ( exponent - 4 );
+      }
+   };
+
+   class histogram_snapshot
+   {
+   private:
+      std::array< std::uint64_t, histogram_buckets::size > m_counts{};
+      std::uint64_t m_count = 0;
+      std::uint64_t m_sum = 0;
+      std::uint64_t m_max = 0;
+
+      friend class histogram;
+
+   public:
+      auto operator+=( const histogram_snapshot& other ) noexcept -> histogram_snapshot&;
+
+      [[nodiscard]] auto count() const noexcept -> std::uint64_t
+      {
+         return m_count;
+      }
+
+      [[nodiscard]] auto sum() const noexcept -> std::uint64_t
+      {
+         return m_sum;
+      }
+
+      [[nodiscard]] auto max() const noexcept -> std::uint64_t
+      {
+         return m_max;
+      }
+
+      [[nodiscard]] auto mean() const noexcept -> std::uint64_t
+      {
+         return ( m_count != 0 ) ? ( m_sum / m_count ) : 0;
+      }
+
+      // the value below which the given fraction (0.0 - 1.0) of the recorded values lie
+      [[nodiscard]] auto percentile( const double fraction ) const noexcept -> std::uint64_t;
+
+      // number of recorded values in buckets which lie entirely below or at the
+      // given bound, values sharing a bucket with the bound are not counted
+      [[nodiscard]] auto count_below( const std::uint64_t bound ) const noexcept -> std::uint64_t;
+   };
+
+   // recording is lock-free, all counters are updated with relaxed atomics
+   class histogram
+   {
+   private:
+      std::array< std::atomic< std::uint64_t >, histogram_buckets::size > m_counts{};
+      std::atomic< std::uint64_t > m_sum{ 0 };
+      std::atomic< std::uint64_t > m_max{ 0 };
+
+   public:
+      void record( const std::uint64_t value ) noexcept
+      {
+         m_counts[ histogram_buckets::index( value ) ].fetch_add( 1, std::memory_order_relaxed );
+         m_sum.fetch_add( value, std::memory_order_relaxed );
+         auto max = m_max.load( std::memory_order_relaxed );
+         while( ( value > max ) && !m_max.compare_exchange_weak( max, value, std::memory_order_relaxed ) ) {
+         }
+      }
+
+      [[nodiscard]] auto snapshot() const noexcept -> histogram_snapshot;
+   };
+
+}  // namespace tao::pq::internal
+
+#endif
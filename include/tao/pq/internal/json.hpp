@@ -0,0 +1,17 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#ifndef TAO_PQ_INTERNAL_JSON_HPP
+#define TAO_PQ_INTERNAL_JSON_HPP
+
+#include <string>
+#include <string_view>
+
+namespace tao::pq::internal
+{
+   // appends the value as a quoted and escaped JSON string
+   void json_string( std::string& out, const std::string_view value );
+
+}  // namespace tao::pq::internal
+
+#endif
@@ -0,0 +1,78 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#ifndef TAO_PQ_INTERNAL_NOTIFICATION_LISTENER_HPP
+#define TAO_PQ_INTERNAL_NOTIFICATION_LISTENER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace tao::pq
+{
+   class connection;
+
+   namespace internal
+   {
+      // listens on a channel with a dedicated connection and passes the payload
+      // of each notification to a callback on its own thread. the connection is
+      // established by the constructor, if it fails later, the listener connects
+      // again after the reconnect interval. notifications sent in the meantime
+      // are lost, the connected callback is called after each (re)connect and
+      // the disconnected callback after each failure.
+      class notification_listener final
+      {
+      public:
+         struct callbacks
+         {
+            std::function< void( const std::string& payload ) > notification;
+            std::function< void() > connected;
+            std::function< void() > disconnected;
+         };
+
+      private:
+         const std::string m_connection_info;
+         const std::string m_channel;
+         const std::chrono::milliseconds m_reconnect_interval;
+         const callbacks m_callbacks;
+
+         std::shared_ptr< connection > m_connection;
+         std::atomic< bool > m_listening{ false };
+
+         std::mutex m_mutex;
+         std::condition_variable m_condition;
+         bool m_stop = false;
+         int m_wakeup[ 2 ] = { -1, -1 };
+         std::thread m_thread;
+
+         void connect();
+         void listen() noexcept;
+         void receive();
+         [[nodiscard]] auto stopped() -> bool;
+
+      public:
+         notification_listener( const std::string& connection_info, const std::string& channel, const std::chrono::milliseconds reconnect_interval, callbacks cb );
+
+         notification_listener( const notification_listener& ) = delete;
+         notification_listener( notification_listener&& ) = delete;
+         void operator=( const notification_listener& ) = delete;
+         void operator=( notification_listener&& ) = delete;
+
+         ~notification_listener();
+
+         [[nodiscard]] auto listening() const noexcept -> bool
+         {
+            return m_listening.load( std::memory_order_relaxed );
+         }
+      };
+
+   }  // namespace internal
+
+}  // namespace tao::pq
+
+#endif
@@ -15,7 +15,9 @@
 
 #include <tao/pq/internal/endian.hpp>
 #include <tao/pq/internal/is_bytea_parameter.hpp>
+#include <tao/pq/internal/parameter_traits_helper.hpp>
 #include <tao/pq/span.hpp>
+#include <tao/pq/type_catalog.hpp>
 
 namespace tao::pq::internal
 {
@@ -437,6 +439,27 @@ namespace tao::pq::internal
       }
    };
 
+   // the binary format of enums, citext and domains over text is their text
+   template<>
+   struct parameter_binary_traits< typed_text >
+      : catalog_type_helper
+   {
+      parameter_binary_traits( const type_catalog& types, const typed_text& v )
+         : catalog_type_helper( types.oid( v.type ), v.value, 1 )
+      {}
+   };
+
+   [[nodiscard]] auto hstore_binary( const hstore& v ) -> std::string;
+
+   template<>
+   struct parameter_binary_traits< hstore >
+      : catalog_type_helper
+   {
+      parameter_binary_traits( const type_catalog& types, const hstore& v )
+         : catalog_type_helper( types.oid( "hstore" ), hstore_binary( v ), 1 )
+      {}
+   };
+
 }  // namespace tao::pq::internal
 
 #endif
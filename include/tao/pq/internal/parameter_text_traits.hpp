@@ -14,6 +14,7 @@
 #include <tao/pq/internal/parameter_traits_helper.hpp>
 #include <tao/pq/internal/printf.hpp>
 #include <tao/pq/span.hpp>
+#include <tao/pq/type_catalog.hpp>
 
 #include <libpq-fe.h>
 
@@ -254,6 +255,26 @@ namespace tao::pq::internal
       }
    };
 
+   template<>
+   struct parameter_text_traits< typed_text >
+      : catalog_type_helper
+   {
+      parameter_text_traits( const type_catalog& types, const typed_text& v )
+         : catalog_type_helper( types.oid( v.type ), v.value, 0 )
+      {}
+   };
+
+   [[nodiscard]] auto hstore_text( const hstore& v ) -> std::string;
+
+   template<>
+   struct parameter_text_traits< hstore >
+      : catalog_type_helper
+   {
+      parameter_text_traits( const type_catalog& types, const hstore& v )
+         : catalog_type_helper( types.oid( "hstore" ), hstore_text( v ), 0 )
+      {}
+   };
+
 }  // namespace tao::pq::internal
 
 #endif
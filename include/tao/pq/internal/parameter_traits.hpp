@@ -6,15 +6,19 @@
 
 #include <cstddef>
 #include <optional>
+#include <string>
 #include <tuple>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include <libpq-fe.h>
 
 #include <tao/pq/internal/gen.hpp>
+#include <tao/pq/internal/parameter_text_traits.hpp>
 #include <tao/pq/internal/parameter_traits_helper.hpp>
 #include <tao/pq/null.hpp>
+#include <tao/pq/type_catalog.hpp>
 
 namespace tao::pq::internal
 {
@@ -67,6 +71,14 @@ namespace tao::pq::internal
       {}
    };
 
+   // the predefined traits have a static type, traits of types from the type
+   // catalog only know their type when constructed
+   template< typename T, std::size_t I, typename = void >
+   inline constexpr Oid static_type = 0;
+
+   template< typename T, std::size_t I >
+   inline constexpr Oid static_type< T, I, std::void_t< std::integral_constant< Oid, T::template type< I >() > > > = T::template type< I >();
+
    template< template< typename... > class Traits, typename T >
    struct parameter_traits< Traits, std::optional< T > >
    {
@@ -75,6 +87,7 @@ namespace tao::pq::internal
       std::optional< U > m_forwarder;
 
    public:
+      template< typename V = U, typename = std::enable_if_t< std::is_constructible_v< V, const T& > > >
       explicit parameter_traits( const std::optional< T >& v )
       {
          if( v ) {
@@ -82,6 +95,7 @@ namespace tao::pq::internal
          }
       }
 
+      template< typename V = U, typename = std::enable_if_t< std::is_constructible_v< V, T&& > > >
       explicit parameter_traits( std::optional< T >&& v )
       {
          if( v ) {
@@ -89,12 +103,26 @@ namespace tao::pq::internal
          }
       }
 
+      template< typename V = U, typename = std::enable_if_t< std::is_constructible_v< V, const type_catalog&, const T& > > >
+      parameter_traits( const type_catalog& types, const std::optional< T >& v )
+      {
+         if( v ) {
+            m_forwarder.emplace( types, *v );
+         }
+      }
+
       static constexpr std::size_t columns = U::columns;
 
+      // a null of a type from the type catalog is sent without a type
       template< std::size_t I >
-      [[nodiscard]] static constexpr auto type() noexcept -> Oid
+      [[nodiscard]] constexpr auto type() const noexcept -> Oid
       {
-         return U::template type< I >();
+         if constexpr( static_type< U, I > != 0 ) {
+            return static_type< U, I >;
+         }
+         else {
+            return m_forwarder ? m_forwarder->template type< I >() : 0;
+         }
       }
 
       template< std::size_t I >
@@ -110,9 +138,14 @@ namespace tao::pq::internal
       }
 
       template< std::size_t I >
-      [[nodiscard]] static constexpr auto format() noexcept -> int
+      [[nodiscard]] constexpr auto format() const noexcept -> int
       {
-         return U::template format< I >();
+         if constexpr( static_type< U, I > != 0 ) {
+            return U::template format< I >();
+         }
+         else {
+            return m_forwarder ? m_forwarder->template format< I >() : 0;
+         }
       }
    };
 
@@ -192,6 +225,53 @@ namespace tao::pq::internal
       {}
    };
 
+   // appends an element of an array literal, always quoted
+   template< typename T >
+   void append_array_element( std::string& s, const T& t )
+   {
+      const parameter_traits< parameter_text_traits, T > element( t );
+      static_assert( decltype( element )::columns == 1, "array elements must be a single column" );
+      const char* p = element.template value< 0 >();
+      if( p == nullptr ) {
+         s += "NULL";
+         return;
+      }
+      s += '"';
+      for( ; *p != '\0'; ++p ) {
+         if( ( *p == '"' ) || ( *p == '\\' ) ) {
+            s += '\\';
+         }
+         s += *p;
+      }
+      s += '"';
+   }
+
+   // one-dimensional arrays, e.g. for "WHERE id = ANY( $1 )", are always sent
+   // in the text format, the server infers the array's type from the statement
+   template< template< typename... > class Traits, typename T, typename A >
+   struct parameter_traits< Traits, std::vector< T, A > >
+      : string_helper
+   {
+   private:
+      [[nodiscard]] static auto literal( const std::vector< T, A >& v ) -> std::string
+      {
+         std::string nrv = "{";
+         for( const auto& e : v ) {
+            if( nrv.size() > 1 ) {
+               nrv += ',';
+            }
+            append_array_element( nrv, e );
+         }
+         nrv += '}';
+         return nrv;
+      }
+
+   public:
+      explicit parameter_traits( const std::vector< T, A >& v )
+         : string_helper( literal( v ) )
+      {}
+   };
+
 }  // namespace tao::pq::internal
 
 #endif
@@ -89,6 +89,49 @@ namespace tao::pq::internal
       }
    };
 
+   // a single value of a type which is only known at run-time
+   class catalog_type_helper
+   {
+   private:
+      const Oid m_type;
+      const std::string m_s;
+      const int m_format;
+
+   protected:
+      catalog_type_helper( const Oid type, std::string s, const int format ) noexcept
+         : m_type( type ),
+           m_s( std::move( s ) ),
+           m_format( format )
+      {}
+
+   public:
+      static constexpr std::size_t columns = 1;
+
+      template< std::size_t I >
+      [[nodiscard]] auto type() const noexcept -> Oid
+      {
+         return m_type;
+      }
+
+      template< std::size_t I >
+      [[nodiscard]] auto value() const noexcept -> const char*
+      {
+         return m_s.data();
+      }
+
+      template< std::size_t I >
+      [[nodiscard]] auto length() const noexcept -> int
+      {
+         return static_cast< int >( m_s.size() );
+      }
+
+      template< std::size_t I >
+      [[nodiscard]] auto format() const noexcept -> int
+      {
+         return m_format;
+      }
+   };
+
 }  // namespace tao::pq::internal
 
 #endif
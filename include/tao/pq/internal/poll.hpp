@@ -0,0 +1,19 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#ifndef TAO_PQ_INTERNAL_POLL_HPP
+#define TAO_PQ_INTERNAL_POLL_HPP
+
+namespace tao::pq::internal
+{
+   // waits until the socket is readable (or writable, if requested),
+   // returns false on timeout, a negative timeout waits indefinitely
+   [[nodiscard]] auto poll( const int socket, const bool wait_for_write, const int timeout_ms = -1 ) -> bool;
+
+   // waits until the socket is readable (and writable, if requested), or
+   // until the wakeup file descriptor is readable, a negative wakeup is ignored
+   [[nodiscard]] auto poll( const int socket, const bool wait_for_write, const int wakeup, const int timeout_ms ) -> bool;
+
+}  // namespace tao::pq::internal
+
+#endif
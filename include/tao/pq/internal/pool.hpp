@@ -4,37 +4,59 @@
 #ifndef TAO_PQ_INTERNAL_POOL_HPP
 #define TAO_PQ_INTERNAL_POOL_HPP
 
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cstdint>
 #include <list>
 #include <memory>
 #include <mutex>
 #include <utility>
 
+#include <tao/pq/internal/histogram.hpp>
+#include <tao/pq/pool_metrics.hpp>
+
 namespace tao::pq::internal
 {
-   template< typename T >
+   // Mutex is only replaced to instrument the lock, e.g. in benchmarks
+   template< typename T, typename Mutex = std::mutex >
    class pool
-      : public std::enable_shared_from_this< pool< T > >
+      : public std::enable_shared_from_this< pool< T, Mutex > >
    {
    private:
+      using clock = std::chrono::steady_clock;
+
       std::list< std::shared_ptr< T > > m_items;
-      std::mutex m_mutex;
+      Mutex m_mutex;
+
+      // metrics, all updated with relaxed atomics
+      std::atomic< std::size_t > m_idle{ 0 };
+      std::atomic< std::size_t > m_in_use{ 0 };
+      std::atomic< std::uint64_t > m_checkouts{ 0 };
+      std::atomic< std::uint64_t > m_creations{ 0 };
+      std::atomic< std::uint64_t > m_creation_failures{ 0 };
+      std::atomic< std::uint64_t > m_invalidated{ 0 };
+      histogram m_checkout_latency;  // in nanoseconds
+      histogram m_connection_age;    // in milliseconds, at checkout
 
       struct deleter
       {
          std::weak_ptr< pool > m_pool;
+         clock::time_point m_created;
 
          deleter() = default;
 
-         explicit deleter( std::weak_ptr< pool >&& p ) noexcept
-            : m_pool( std::move( p ) )
+         deleter( std::weak_ptr< pool >&& p, const clock::time_point created ) noexcept
+            : m_pool( std::move( p ) ),
+              m_created( created )
          {}
 
          void operator()( T* item ) const noexcept
          {
             std::unique_ptr< T > up( item );
             if( const auto p = m_pool.lock() ) {
-               p->push( up );
+               p->m_in_use.fetch_sub( 1, std::memory_order_relaxed );
+               p->push( up, m_created );
             }
          }
       };
@@ -47,13 +69,17 @@ namespace tao::pq::internal
       [[nodiscard]] virtual auto v_create() const -> std::unique_ptr< T > = 0;
       [[nodiscard]] virtual auto v_is_valid( T& ) const noexcept -> bool = 0;
 
-      void push( std::unique_ptr< T >& up ) noexcept
+      void push( std::unique_ptr< T >& up, const clock::time_point created ) noexcept
       {
          if( v_is_valid( *up ) ) {
-            std::shared_ptr< T > sp( up.release(), deleter() );
+            std::shared_ptr< T > sp( up.release(), deleter( std::weak_ptr< pool >(), created ) );
             const std::lock_guard lock( m_mutex );
             // potentially throws -> calls abort() due to noexcept!
             m_items.emplace_back( std::move( sp ) );
+            m_idle.store( m_items.size(), std::memory_order_relaxed );
+         }
+         else {
+            m_invalidated.fetch_add( 1, std::memory_order_relaxed );
          }
       }
 
@@ -64,6 +90,7 @@ namespace tao::pq::internal
          if( !m_items.empty() ) {
             nrv = std::move( m_items.back() );
             m_items.pop_back();
+            m_idle.store( m_items.size(), std::memory_order_relaxed );
          }
          return nrv;
       }
@@ -78,32 +105,65 @@ namespace tao::pq::internal
       {
          deleter* d = std::get_deleter< deleter >( sp );
          assert( d );
+         if( const auto pp = p.lock() ) {
+            pp->m_in_use.fetch_add( 1, std::memory_order_relaxed );
+         }
          d->m_pool = std::move( p );
       }
 
+      [[nodiscard]] static auto created( const std::shared_ptr< T >& sp ) noexcept -> clock::time_point
+      {
+         const deleter* d = std::get_deleter< deleter >( sp );
+         assert( d );
+         return d->m_created;
+      }
+
       static void detach( const std::shared_ptr< T >& sp ) noexcept
       {
          deleter* d = std::get_deleter< deleter >( sp );
          assert( d );
+         if( const auto p = d->m_pool.lock() ) {
+            p->m_in_use.fetch_sub( 1, std::memory_order_relaxed );
+         }
          d->m_pool.reset();
       }
 
       // create a new T which is put into the pool when no longer used
       [[nodiscard]] auto create() -> std::shared_ptr< T >
       {
-         return { v_create().release(), deleter( this->weak_from_this() ) };
+         std::unique_ptr< T > up;
+         try {
+            up = v_create();
+         }
+         catch( ... ) {
+            m_creation_failures.fetch_add( 1, std::memory_order_relaxed );
+            throw;
+         }
+         m_creations.fetch_add( 1, std::memory_order_relaxed );
+         m_in_use.fetch_add( 1, std::memory_order_relaxed );
+         return { up.release(), deleter( this->weak_from_this(), clock::now() ) };
       }
 
       // get an instance from the pool or create a new one if necessary
       [[nodiscard]] auto get() -> std::shared_ptr< T >
       {
+         const auto start = clock::now();
          while( const auto sp = pull() ) {
             if( v_is_valid( *sp ) ) {
                attach( sp, this->weak_from_this() );
+               m_checkouts.fetch_add( 1, std::memory_order_relaxed );
+               const auto now = clock::now();
+               m_checkout_latency.record( std::chrono::duration_cast< std::chrono::nanoseconds >( now - start ).count() );
+               m_connection_age.record( std::chrono::duration_cast< std::chrono::milliseconds >( now - created( sp ) ).count() );
                return sp;
             }
+            m_invalidated.fetch_add( 1, std::memory_order_relaxed );
          }
-         return create();
+         auto nrv = create();
+         m_checkouts.fetch_add( 1, std::memory_order_relaxed );
+         m_checkout_latency.record( std::chrono::duration_cast< std::chrono::nanoseconds >( clock::now() - start ).count() );
+         m_connection_age.record( 0 );
+         return nrv;
       }
 
       void erase_invalid()
@@ -114,11 +174,27 @@ namespace tao::pq::internal
          while( it != m_items.end() ) {
             if( !v_is_valid( **it ) ) {
                deferred_delete.splice( deferred_delete.end(), m_items, it++ );
+               m_invalidated.fetch_add( 1, std::memory_order_relaxed );
             }
             else {
                ++it;
             }
          }
+         m_idle.store( m_items.size(), std::memory_order_relaxed );
+      }
+
+      [[nodiscard]] auto metrics() const noexcept -> pool_metrics
+      {
+         pool_metrics nrv;
+         nrv.idle = m_idle.load( std::memory_order_relaxed );
+         nrv.in_use = m_in_use.load( std::memory_order_relaxed );
+         nrv.checkouts = m_checkouts.load( std::memory_order_relaxed );
+         nrv.creations = m_creations.load( std::memory_order_relaxed );
+         nrv.creation_failures = m_creation_failures.load( std::memory_order_relaxed );
+         nrv.invalidated = m_invalidated.load( std::memory_order_relaxed );
+         nrv.checkout_latency = m_checkout_latency.snapshot();
+         nrv.connection_age = m_connection_age.snapshot();
+         return nrv;
       }
    };
 
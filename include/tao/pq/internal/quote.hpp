@@ -0,0 +1,22 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#ifndef TAO_PQ_INTERNAL_QUOTE_HPP
+#define TAO_PQ_INTERNAL_QUOTE_HPP
+
+#include <string>
+
+namespace tao::pq::internal
+{
+   // for names and values which can not be passed as parameters, e.g. of
+   // LISTEN or of the replication commands
+
+   // a double-quoted identifier, e.g. "taopq_jobs"
+   [[nodiscard]] auto quote_identifier( const std::string& identifier ) -> std::string;
+
+   // a single-quoted string literal, e.g. 'abc'
+   [[nodiscard]] auto quote_literal( const std::string& literal ) -> std::string;
+
+}  // namespace tao::pq::internal
+
+#endif
@@ -0,0 +1,113 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#ifndef TAO_PQ_INTERNAL_RING_BUFFER_HPP
+#define TAO_PQ_INTERNAL_RING_BUFFER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace tao::pq::internal
+{
+   // bounded lock-free multi-producer/multi-consumer queue (Dmitry Vyukov's
+   // design), the capacity is rounded up to a power of two. elements are
+   // moved in and out, T must be default constructible.
+   template< typename T >
+   class ring_buffer
+   {
+   private:
+      struct cell
+      {
+         std::atomic< std::size_t > sequence;
+         T value;
+      };
+
+      const std::size_t m_mask;
+      const std::unique_ptr< cell[] > m_cells;
+
+      alignas( 64 ) std::atomic< std::size_t > m_head{ 0 };
+      alignas( 64 ) std::atomic< std::size_t > m_tail{ 0 };
+
+      [[nodiscard]] static auto round_up( const std::size_t capacity ) noexcept -> std::size_t
+      {
+         std::size_t nrv = 2;
+         while( nrv < capacity ) {
+            nrv *= 2;
+         }
+         return nrv;
+      }
+
+   public:
+      explicit ring_buffer( const std::size_t capacity )
+         : m_mask( round_up( capacity ) - 1 ),
+           m_cells( new cell[ m_mask + 1 ] )
+      {
+         for( std::size_t i = 0; i <= m_mask; ++i ) {
+            m_cells[ i ].sequence.store( i, std::memory_order_relaxed );
+         }
+      }
+
+      ring_buffer( const ring_buffer& ) = delete;
+      ring_buffer( ring_buffer&& ) = delete;
+      void operator=( const ring_buffer& ) = delete;
+      void operator=( ring_buffer&& ) = delete;
+
+      ~ring_buffer() = default;
+
+      [[nodiscard]] auto capacity() const noexcept -> std::size_t
+      {
+         return m_mask + 1;
+      }
+
+      // returns false if the buffer is full
+      [[nodiscard]] auto try_push( T&& value ) -> bool
+      {
+         auto pos = m_tail.load( std::memory_order_relaxed );
+         while( true ) {
+            cell& c = m_cells[ pos & m_mask ];
+            const auto diff = static_cast< std::ptrdiff_t >( c.sequence.load( std::memory_order_acquire ) - pos );
+            if( diff == 0 ) {
+               if( m_tail.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) ) {
+                  c.value = std::move( value );
+                  c.sequence.store( pos + 1, std::memory_order_release );
+                  return true;
+               }
+            }
+            else if( diff < 0 ) {
+               return false;
+            }
+            else {
+               pos = m_tail.load( std::memory_order_relaxed );
+            }
+         }
+      }
+
+      // returns false if the buffer is empty
+      [[nodiscard]] auto try_pop( T& value ) -> bool
+      {
+         auto pos = m_head.load( std::memory_order_relaxed );
+         while( true ) {
+            cell& c = m_cells[ pos & m_mask ];
+            const auto diff = static_cast< std::ptrdiff_t >( c.sequence.load( std::memory_order_acquire ) - ( pos + 1 ) );
+            if( diff == 0 ) {
+               if( m_head.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) ) {
+                  value = std::move( c.value );
+                  c.sequence.store( pos + m_mask + 1, std::memory_order_release );
+                  return true;
+               }
+            }
+            else if( diff < 0 ) {
+               return false;
+            }
+            else {
+               pos = m_head.load( std::memory_order_relaxed );
+            }
+         }
+      }
+   };
+
+}  // namespace tao::pq::internal
+
+#endif
@@ -0,0 +1,25 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#ifndef TAO_PQ_INTERNAL_STATEMENT_KEY_HPP
+#define TAO_PQ_INTERNAL_STATEMENT_KEY_HPP
+
+#include <string>
+
+#include <libpq-fe.h>
+
+namespace tao::pq::internal
+{
+   // identifies a statement together with its encoded parameters, the key
+   // includes the parameter types and formats, so that the same values
+   // encoded differently are not mistaken for each other
+   [[nodiscard]] auto statement_key( const char* statement,
+                                     const int n_params,
+                                     const Oid types[],
+                                     const char* const values[],
+                                     const int lengths[],
+                                     const int formats[] ) -> std::string;
+
+}  // namespace tao::pq::internal
+
+#endif
@@ -0,0 +1,88 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#ifndef TAO_PQ_INTERNAL_WIRE_HPP
+#define TAO_PQ_INTERNAL_WIRE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <libpq-fe.h>
+
+#include <tao/pq/wire_counters.hpp>
+
+namespace tao::pq::internal
+{
+   // size of the Parse/Bind/Describe/Execute/Sync messages libpq sends for a statement
+   [[nodiscard]] auto statement_wire_size( const char* statement,
+                                           const bool prepared,
+                                           const int n_params,
+                                           const char* const values[],
+                                           const int lengths[],
+                                           const int formats[] ) noexcept -> std::size_t;
+
+   // size of the messages the server sent to produce the result, i.e.
+   // RowDescription, DataRow and CommandComplete or ErrorResponse, etc.
+   [[nodiscard]] auto result_wire_size( const PGresult* result ) noexcept -> std::size_t;
+
+   // size of the ParseComplete/BindComplete and ReadyForQuery messages
+   [[nodiscard]] constexpr auto response_overhead( const bool prepared ) noexcept -> std::size_t
+   {
+      return ( prepared ? 5 : 10 ) + 6;
+   }
+
+   // updated by the connection's thread, may be read from any thread. the byte
+   // counts are estimated from the message sizes, round-trips are counted where
+   // the client waits for a response, independent of how much was sent before.
+   class wire_recorder
+   {
+   private:
+      std::atomic< std::uint64_t > m_round_trips{ 0 };
+      std::atomic< std::uint64_t > m_bytes_sent{ 0 };
+      std::atomic< std::uint64_t > m_bytes_received{ 0 };
+      std::atomic< std::uint64_t > m_results{ 0 };
+
+   public:
+      void round_trip() noexcept
+      {
+         m_round_trips.fetch_add( 1, std::memory_order_relaxed );
+      }
+
+      // the messages sent and the responses to them which are not part of a result
+      void exchanged( const std::size_t bytes_sent, const std::size_t bytes_received ) noexcept
+      {
+         sent( bytes_sent );
+         received( bytes_received );
+      }
+
+      void sent( const std::size_t bytes ) noexcept
+      {
+         m_bytes_sent.fetch_add( bytes, std::memory_order_relaxed );
+      }
+
+      void received( const std::size_t bytes ) noexcept
+      {
+         m_bytes_received.fetch_add( bytes, std::memory_order_relaxed );
+      }
+
+      void result( const PGresult* r ) noexcept
+      {
+         m_results.fetch_add( 1, std::memory_order_relaxed );
+         received( result_wire_size( r ) );
+      }
+
+      [[nodiscard]] auto snapshot() const noexcept -> wire_counters
+      {
+         wire_counters nrv;
+         nrv.round_trips = m_round_trips.load( std::memory_order_relaxed );
+         nrv.estimated_bytes_sent = m_bytes_sent.load( std::memory_order_relaxed );
+         nrv.estimated_bytes_received = m_bytes_received.load( std::memory_order_relaxed );
+         nrv.results = m_results.load( std::memory_order_relaxed );
+         return nrv;
+      }
+   };
+
+}  // namespace tao::pq::internal
+
+#endif
@@ -0,0 +1,188 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#ifndef TAO_PQ_JOB_QUEUE_HPP
+#define TAO_PQ_JOB_QUEUE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <tao/pq/connection.hpp>
+#include <tao/pq/connection_pool.hpp>
+#include <tao/pq/internal/notification_listener.hpp>
+#include <tao/pq/transaction.hpp>
+
+namespace tao::pq
+{
+   struct job_queue_options
+   {
+      // the table, created with
+      //
+      //    CREATE TABLE taopq_jobs ( id BIGSERIAL PRIMARY KEY, payload TEXT NOT NULL )
+      std::string table = "taopq_jobs";
+
+      // enqueue() notifies this channel, waiting workers listen on it.
+      // an empty channel disables the listener, workers then only poll.
+      std::string channel = "taopq_jobs";
+
+      // the maximum number of jobs dequeued at once
+      std::size_t batch_size = 100;
+
+      // waiting workers look for jobs at least this often, e.g. for jobs
+      // enqueued while the listener was disconnected
+      std::chrono::milliseconds poll_interval = std::chrono::seconds( 1 );
+      std::chrono::milliseconds reconnect_interval = std::chrono::seconds( 1 );
+   };
+
+   struct job
+   {
+      std::int64_t id = 0;
+      std::string payload;
+   };
+
+   // jobs locked by a worker in an open transaction, other workers skip them.
+   // jobs which are not acknowledged when the batch is released or destroyed
+   // become available again.
+   class job_batch final
+   {
+   private:
+      friend class job_queue;
+
+      std::shared_ptr< transaction > m_transaction;
+      std::vector< job > m_jobs;
+      std::string m_acknowledge;
+
+      job_batch( const std::shared_ptr< transaction >& tr, std::vector< job >&& jobs, const std::string& acknowledge );
+
+   public:
+      job_batch() = default;
+
+      [[nodiscard]] auto jobs() const noexcept -> const std::vector< job >&
+      {
+         return m_jobs;
+      }
+
+      [[nodiscard]] auto size() const noexcept -> std::size_t
+      {
+         return m_jobs.size();
+      }
+
+      [[nodiscard]] auto empty() const noexcept -> bool
+      {
+         return m_jobs.empty();
+      }
+
+      [[nodiscard]] auto begin() const noexcept
+      {
+         return m_jobs.begin();
+      }
+
+      [[nodiscard]] auto end() const noexcept
+      {
+         return m_jobs.end();
+      }
+
+      // deletes all jobs of the batch and commits
+      void acknowledge();
+
+      // deletes the given jobs and commits, the other jobs become available again
+      void acknowledge( const std::vector< std::int64_t >& ids );
+
+      // rolls back, all jobs become available again
+      void release();
+   };
+
+   // a queue of jobs in a table, shared by any number of producers and workers.
+   // jobs are enqueued with COPY, dequeued in batches with FOR UPDATE SKIP LOCKED
+   // and deleted when acknowledged, with prepared statements. waiting workers
+   // are woken by notifications, received on a dedicated connection.
+   class job_queue final
+   {
+   private:
+      const std::shared_ptr< connection_pool > m_pool;
+      const job_queue_options m_options;
+
+      // unique per queue, the prefix of its prepared statements
+      const std::string m_name;
+      const std::string m_dequeue;
+      const std::string m_acknowledge;
+      const std::string m_insert;
+
+      std::mutex m_mutex;
+      std::condition_variable m_condition;
+      std::uint64_t m_notifications = 0;
+
+      std::atomic< std::uint64_t > m_enqueued{ 0 };
+      std::atomic< std::uint64_t > m_dequeued{ 0 };
+
+      // last, so it is stopped before the members it uses are destroyed
+      std::unique_ptr< internal::notification_listener > m_listener;
+
+      void prepare( pq::connection& c );
+      void notify( const std::shared_ptr< transaction >& tr );
+      [[nodiscard]] auto try_dequeue() -> job_batch;
+
+      void wake();
+
+   public:
+      [[nodiscard]] static auto create( const std::shared_ptr< connection_pool >& pool, const job_queue_options& options = job_queue_options() ) -> std::shared_ptr< job_queue >;
+
+   private:
+      // pass-key idiom
+      class private_key
+      {
+         private_key() = default;
+         friend auto job_queue::create( const std::shared_ptr< connection_pool >& pool, const job_queue_options& options ) -> std::shared_ptr< job_queue >;
+      };
+
+   public:
+      job_queue( const private_key& /*unused*/, const std::shared_ptr< connection_pool >& pool, const job_queue_options& options );
+
+      job_queue( const job_queue& ) = delete;
+      job_queue( job_queue&& ) = delete;
+      void operator=( const job_queue& ) = delete;
+      void operator=( job_queue&& ) = delete;
+
+      ~job_queue();
+
+      // enqueues a single job, with a prepared statement
+      void enqueue( const std::string& payload );
+
+      // enqueues the jobs with a single COPY
+      void enqueue( const std::vector< std::string >& payloads );
+
+      // enqueues the jobs as part of the transaction, they become visible
+      // to the workers when the transaction commits
+      void enqueue( const std::shared_ptr< transaction >& tr, const std::vector< std::string >& payloads );
+
+      // returns up to batch_size jobs, waits for up to the timeout if there
+      // are none, and returns an empty batch if there are still none
+      [[nodiscard]] auto dequeue( const std::chrono::milliseconds timeout = std::chrono::milliseconds( 0 ) ) -> job_batch;
+
+      // the number of jobs enqueued and dequeued through this queue
+      [[nodiscard]] auto enqueued() const noexcept -> std::uint64_t
+      {
+         return m_enqueued.load( std::memory_order_relaxed );
+      }
+
+      [[nodiscard]] auto dequeued() const noexcept -> std::uint64_t
+      {
+         return m_dequeued.load( std::memory_order_relaxed );
+      }
+
+      [[nodiscard]] auto listening() const noexcept -> bool
+      {
+         return m_listener && m_listener->listening();
+      }
+   };
+
+}  // namespace tao::pq
+
+#endif
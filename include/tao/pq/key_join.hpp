@@ -0,0 +1,136 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#ifndef TAO_PQ_KEY_JOIN_HPP
+#define TAO_PQ_KEY_JOIN_HPP
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <libpq-fe.h>
+
+#include <tao/pq/internal/copy_format.hpp>
+#include <tao/pq/internal/quote.hpp>
+
+#include <tao/pq/parameter_traits.hpp>
+#include <tao/pq/result.hpp>
+#include <tao/pq/table_writer.hpp>
+#include <tao/pq/transaction.hpp>
+
+namespace tao::pq
+{
+   struct key_join_options
+   {
+      // up to this many keys are passed as an array parameter, more keys
+      // are copied into a temporary table
+      std::size_t array_threshold = 1000;
+
+      // the SQL type of the keys, derived from the key's C++ type if empty,
+      // i.e. for bool, short, int, long, long long, float, double and std::string.
+      // it is inserted into the statements as is and therefore restricted to
+      // names and modifiers, e.g. "NUMERIC( 10, 2 )" or "public.my_type"
+      std::string type;
+
+      // the temporary table, with a single column "key", the name is quoted
+      std::string table = "taopq_keys";
+      bool analyze = true;
+   };
+
+   namespace internal
+   {
+      // the name of a type the binary format of which is sent by the binary traits, or nullptr
+      [[nodiscard]] auto key_type_name( const Oid oid ) noexcept -> const char*;
+
+      // throws std::invalid_argument unless the type consists of letters, digits,
+      // underscores, spaces, dots, commas and balanced parentheses
+      void check_key_type( const std::string& type );
+
+      // replaces "{keys}" in the statement with the relation
+      [[nodiscard]] auto replace_keys( const std::string& statement, const std::string& relation ) -> std::string;
+
+      template< typename Key >
+      void append_copy_key( std::string& data, const Key& key, const bool binary )
+      {
+         if constexpr( static_type< pq::parameter_binary_traits< Key >, 0 > != 0 ) {
+            if( binary ) {
+               const pq::parameter_binary_traits< Key > t( key );
+               append_copy_binary_row( data, 1 );
+               append_copy_binary_field( data, t.template value< 0 >(), t.template length< 0 >() );
+               return;
+            }
+         }
+         if constexpr( std::is_constructible_v< pq::parameter_text_traits< Key >, const Key& > ) {
+            append_copy_row( data, pq::parameter_text_traits< Key >( key ) );
+         }
+         else {
+            throw std::invalid_argument( "keys of this type can only be copied in the binary format" );
+         }
+      }
+
+   }  // namespace internal
+
+   // executes a statement which joins a set of keys, the statement refers to the
+   // keys as the relation "{keys}" with a single column "key", e.g.
+   //
+   //    SELECT u.* FROM users u JOIN {keys} k ON u.id = k.key
+   //
+   // small key sets are passed as an array parameter, large key sets are copied
+   // into a temporary table, which is dropped afterwards. the binary format is
+   // used for the COPY when the type of the keys is derived from their C++ type.
+   template< typename Key >
+   [[nodiscard]] auto key_join( const std::shared_ptr< transaction >& tr, const std::string& statement, const std::vector< Key >& keys, const key_join_options& options = key_join_options() ) -> result
+   {
+      constexpr Oid oid = internal::static_type< parameter_binary_traits< Key >, 0 >;
+      const char* derived = internal::key_type_name( oid );
+      if( options.type.empty() && ( derived == nullptr ) ) {
+         throw std::invalid_argument( "unable to derive the SQL type of the keys, set key_join_options::type" );
+      }
+      internal::check_key_type( options.type );
+      const std::string type = options.type.empty() ? derived : options.type;
+
+      if( keys.size() <= options.array_threshold ) {
+         return tr->execute( internal::replace_keys( statement, "( SELECT unnest( $1::" + type + "[] ) AS key )" ), keys );
+      }
+
+      const std::string table = internal::quote_identifier( options.table );
+      const auto sub = tr->subtransaction();
+      sub->execute( "CREATE TEMPORARY TABLE " + table + " ( key " + type + " )" );
+      const bool binary = options.type.empty();
+      {
+         table_writer tw( sub, "COPY " + table + " ( key ) FROM STDIN" + ( binary ? " WITH ( FORMAT binary )" : "" ) );
+         std::string data;
+         data.reserve( internal::copy_chunk_size + 256 );
+         if( binary ) {
+            internal::append_copy_binary_header( data );
+         }
+         for( const auto& key : keys ) {
+            internal::append_copy_key( data, key, binary );
+            if( data.size() >= internal::copy_chunk_size ) {
+               tw.insert( data );
+               data.clear();
+            }
+         }
+         if( binary ) {
+            internal::append_copy_binary_trailer( data );
+         }
+         if( !data.empty() ) {
+            tw.insert( data );
+         }
+         (void)tw.finish();
+      }
+      if( options.analyze ) {
+         sub->execute( "ANALYZE " + table );
+      }
+      auto nrv = sub->execute( internal::replace_keys( statement, table ) );
+      sub->execute( "DROP TABLE " + table );
+      sub->commit();
+      return nrv;
+   }
+
+}  // namespace tao::pq
+
+#endif
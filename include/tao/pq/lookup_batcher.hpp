@@ -0,0 +1,172 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#ifndef TAO_PQ_LOOKUP_BATCHER_HPP
+#define TAO_PQ_LOOKUP_BATCHER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <tao/pq/connection_pool.hpp>
+#include <tao/pq/parameter_traits.hpp>
+#include <tao/pq/result.hpp>
+
+namespace tao::pq
+{
+   struct lookup_batcher_options
+   {
+      // how long the first lookup of a batch waits for more keys
+      std::chrono::microseconds window = std::chrono::microseconds( 200 );
+
+      // a batch is executed immediately when it has this many distinct keys
+      std::size_t max_keys = 500;
+   };
+
+   // collects concurrent point lookups into batches, each batch is a single
+   // statement with all its distinct keys as an array parameter, e.g.
+   //
+   //    SELECT id, name FROM users WHERE id = ANY( $1 )
+   //
+   // the first column of the result is the key, the remaining columns are
+   // decoded as the value. the first lookup of a batch executes it on a
+   // connection of the pool, the other lookups wait for it.
+   template< typename Key, typename Value >
+   class lookup_batcher final
+   {
+   private:
+      struct batch
+      {
+         std::vector< Key > keys;
+         std::map< Key, std::optional< Value > > values;
+         std::exception_ptr error;
+         std::promise< void > promise;
+         std::shared_future< void > done = promise.get_future().share();
+      };
+
+      const std::shared_ptr< connection_pool > m_pool;
+      const std::string m_statement;
+      const lookup_batcher_options m_options;
+
+      std::mutex m_mutex;
+      std::condition_variable m_closed;
+      std::shared_ptr< batch > m_open;
+
+      std::atomic< std::uint64_t > m_lookups{ 0 };
+      std::atomic< std::uint64_t > m_batches{ 0 };
+
+      void execute( batch& b )
+      {
+         try {
+            const auto r = m_pool->connection()->direct()->execute( m_statement, b.keys );
+            const auto columns = r.columns();
+            for( const auto& row : r ) {
+               const auto it = b.values.find( row.template get< Key >( 0 ) );
+               if( ( it != b.values.end() ) && !it->second ) {
+                  it->second = row.slice( 1, columns - 1 ).template as< Value >();
+               }
+            }
+         }
+         catch( ... ) {
+            b.error = std::current_exception();
+         }
+         m_batches.fetch_add( 1, std::memory_order_relaxed );
+         b.promise.set_value();
+      }
+
+      [[nodiscard]] static auto lookup( const batch& b, const Key& key ) -> std::optional< Value >
+      {
+         if( b.error ) {
+            std::rethrow_exception( b.error );
+         }
+         return b.values.at( key );
+      }
+
+   public:
+      // the statement has a single parameter, the array of keys
+      [[nodiscard]] static auto create( const std::shared_ptr< connection_pool >& pool, const std::string& statement, const lookup_batcher_options& options = lookup_batcher_options() ) -> std::shared_ptr< lookup_batcher >
+      {
+         return std::make_shared< lookup_batcher >( private_key(), pool, statement, options );
+      }
+
+   private:
+      // pass-key idiom
+      class private_key
+      {
+         private_key() = default;
+         friend auto lookup_batcher::create( const std::shared_ptr< connection_pool >& pool, const std::string& statement, const lookup_batcher_options& options ) -> std::shared_ptr< lookup_batcher >;
+      };
+
+   public:
+      lookup_batcher( const private_key& /*unused*/, const std::shared_ptr< connection_pool >& pool, const std::string& statement, const lookup_batcher_options& options )  // NOLINT(modernize-pass-by-value)
+         : m_pool( pool ),
+           m_statement( statement ),
+           m_options( options )
+      {}
+
+      lookup_batcher( const lookup_batcher& ) = delete;
+      lookup_batcher( lookup_batcher&& ) = delete;
+      void operator=( const lookup_batcher& ) = delete;
+      void operator=( lookup_batcher&& ) = delete;
+
+      ~lookup_batcher() = default;
+
+      // returns the value for the key, or an empty optional if there is no row for it,
+      // if several rows have the same key, the first one is used
+      [[nodiscard]] auto get( const Key& key ) -> std::optional< Value >
+      {
+         m_lookups.fetch_add( 1, std::memory_order_relaxed );
+         std::unique_lock lock( m_mutex );
+         const bool leader = !m_open;
+         if( leader ) {
+            m_open = std::make_shared< batch >();
+         }
+         const auto b = m_open;
+         if( b->values.emplace( key, std::nullopt ).second ) {
+            b->keys.push_back( key );
+            if( b->keys.size() >= m_options.max_keys ) {
+               m_open.reset();
+               m_closed.notify_all();
+            }
+         }
+         if( !leader ) {
+            lock.unlock();
+            b->done.wait();
+            return lookup( *b, key );
+         }
+         m_closed.wait_for( lock, m_options.window, [ & ] { return m_open != b; } );
+         if( m_open == b ) {
+            m_open.reset();
+         }
+         lock.unlock();
+         execute( *b );
+         return lookup( *b, key );
+      }
+
+      // the number of calls to get()
+      [[nodiscard]] auto lookups() const noexcept -> std::uint64_t
+      {
+         return m_lookups.load( std::memory_order_relaxed );
+      }
+
+      // the number of executed statements
+      [[nodiscard]] auto batches() const noexcept -> std::uint64_t
+      {
+         return m_batches.load( std::memory_order_relaxed );
+      }
+   };
+
+}  // namespace tao::pq
+
+#endif
@@ -0,0 +1,164 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#ifndef TAO_PQ_MULTIPLEXER_HPP
+#define TAO_PQ_MULTIPLEXER_HPP
+
+#include <libpq-fe.h>
+
+#if defined( LIBPQ_HAS_PIPELINING )
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <tao/pq/connection.hpp>
+#include <tao/pq/internal/gen.hpp>
+#include <tao/pq/parameter_traits.hpp>
+#include <tao/pq/result.hpp>
+
+namespace tao::pq
+{
+   namespace internal
+   {
+      struct multiplexed_statement;
+
+   }  // namespace internal
+
+   // shares a single connection between many threads: autocommit statements
+   // are queued and sent by a driver thread in pipeline mode, each statement
+   // is followed by its own sync, so an error only affects its own statement
+   class multiplexer final
+   {
+   private:
+      const std::shared_ptr< pq::connection > m_connection;
+
+      std::mutex m_mutex;
+      std::deque< std::unique_ptr< internal::multiplexed_statement > > m_queue;
+      bool m_stopped = false;
+      std::atomic< std::size_t > m_pending{ 0 };
+
+      // owned by the driver thread
+      std::deque< std::unique_ptr< internal::multiplexed_statement > > m_in_flight;
+      std::set< std::string, std::less<> > m_prepared_statements;
+
+      int m_wakeup[ 2 ] = { -1, -1 };
+      std::thread m_driver;
+
+      [[nodiscard]] auto submit( std::unique_ptr< internal::multiplexed_statement > s ) -> std::future< result >;
+      [[nodiscard]] auto submit( const char* statement,
+                                 const int n_params,
+                                 const Oid types[],
+                                 const char* const values[],
+                                 const int lengths[],
+                                 const int formats[] ) -> std::future< result >;
+
+      void wakeup() noexcept;
+      void drive() noexcept;
+      [[nodiscard]] auto send() -> bool;
+      void receive();
+      void complete( internal::multiplexed_statement& s ) noexcept;
+      void fail( const std::exception_ptr& e ) noexcept;
+
+      template< std::size_t... Os, std::size_t... Is, typename... Ts >
+      [[nodiscard]] auto execute_indexed( const char* statement,
+                                          std::index_sequence< Os... > /*unused*/,
+                                          std::index_sequence< Is... > /*unused*/,
+                                          const std::tuple< Ts... >& tuple )
+      {
+         const Oid types[] = { std::get< Os >( tuple ).template type< Is >()... };
+         const char* const values[] = { std::get< Os >( tuple ).template value< Is >()... };
+         const int lengths[] = { std::get< Os >( tuple ).template length< Is >()... };
+         const int formats[] = { std::get< Os >( tuple ).template format< Is >()... };
+         return submit( statement, sizeof...( Os ), types, values, lengths, formats );
+      }
+
+      template< typename... Ts >
+      [[nodiscard]] auto execute_traits( const char* statement, const Ts&... ts )
+      {
+         using gen = internal::gen< Ts::columns... >;
+         return execute_indexed( statement, typename gen::outer_sequence(), typename gen::inner_sequence(), std::tie( ts... ) );
+      }
+
+      // escaping bytea in the text format only reads the settings of the connection
+      template< template< typename... > class Traits, typename A >
+      auto to_traits( A&& a ) const
+      {
+         using T = Traits< std::decay_t< A > >;
+         if constexpr( std::is_constructible_v< T, decltype( std::forward< A >( a ) ) > ) {
+            return T( std::forward< A >( a ) );
+         }
+         else if constexpr( std::is_constructible_v< T, PGconn*, decltype( std::forward< A >( a ) ) > ) {
+            return T( m_connection->underlying_raw_ptr(), std::forward< A >( a ) );
+         }
+         else {
+            static_assert( std::is_void_v< T >, "no valid conversion from A to Traits" );
+         }
+      }
+
+   public:
+      [[nodiscard]] static auto create( const std::string& connection_info ) -> std::shared_ptr< multiplexer >;
+
+   private:
+      // pass-key idiom
+      class private_key
+      {
+         private_key() = default;
+         friend auto multiplexer::create( const std::string& connection_info ) -> std::shared_ptr< multiplexer >;
+      };
+
+   public:
+      multiplexer( const private_key& /*unused*/, const std::string& connection_info );
+
+      multiplexer( const multiplexer& ) = delete;
+      multiplexer( multiplexer&& ) = delete;
+      void operator=( const multiplexer& ) = delete;
+      void operator=( multiplexer&& ) = delete;
+
+      // completes all statements submitted before
+      ~multiplexer();
+
+      // waits until the statement is prepared, afterwards it can be executed by its name
+      void prepare( const std::string& name, const std::string& statement );
+
+      // the parameters are copied, the arguments need not outlive the call
+      template< template< typename... > class Traits = parameter_text_traits, typename... As >
+      [[nodiscard]] auto execute( const char* statement, As&&... as ) -> std::future< result >
+      {
+         return execute_traits( statement, to_traits< Traits >( std::forward< As >( as ) )... );
+      }
+
+      // short-cut for no-arguments invocations
+      template< template< typename... > class Traits = parameter_text_traits >
+      [[nodiscard]] auto execute( const char* statement ) -> std::future< result >
+      {
+         return submit( statement, 0, nullptr, nullptr, nullptr, nullptr );
+      }
+
+      template< template< typename... > class Traits = parameter_text_traits, typename... As >
+      [[nodiscard]] auto execute( const std::string& statement, As&&... as ) -> std::future< result >
+      {
+         return execute< Traits >( statement.c_str(), std::forward< As >( as )... );
+      }
+
+      // the number of statements submitted but not yet completed
+      [[nodiscard]] auto pending() const noexcept -> std::size_t
+      {
+         return m_pending.load( std::memory_order_relaxed );
+      }
+   };
+
+}  // namespace tao::pq
+
+#endif
+
+#endif
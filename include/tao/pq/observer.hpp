@@ -0,0 +1,146 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#ifndef TAO_PQ_OBSERVER_HPP
+#define TAO_PQ_OBSERVER_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tao::pq
+{
+   class connection;
+   class transaction;
+
+   struct statement_event
+   {
+      using clock = std::chrono::steady_clock;
+      using time_point = clock::time_point;
+
+      const pq::connection* connection = nullptr;
+      const char* statement = nullptr;
+      bool prepared = false;
+      int parameters = 0;
+
+      // the parameters as passed to libpq, only valid during the call
+      const char* const* values = nullptr;
+      const int* lengths = nullptr;
+      const int* formats = nullptr;
+
+      std::size_t bytes_sent = 0;  // estimated from the size of the messages
+      std::size_t rows = 0;
+
+      // nullptr if the statement succeeded
+      const char* error = nullptr;
+
+      time_point started;    // before the parameters are encoded
+      time_point encoded;    // parameters encoded, before sending
+      time_point sent;       // statement sent to the server
+      time_point responded;  // first response from the server available
+      time_point received;   // complete result received
+      time_point decoded;    // result checked and wrapped into tao::pq::result
+
+      [[nodiscard]] auto encoding() const noexcept -> clock::duration
+      {
+         return encoded - started;
+      }
+
+      [[nodiscard]] auto sending() const noexcept -> clock::duration
+      {
+         return sent - encoded;
+      }
+
+      [[nodiscard]] auto waiting() const noexcept -> clock::duration
+      {
+         return responded - sent;
+      }
+
+      [[nodiscard]] auto receiving() const noexcept -> clock::duration
+      {
+         return received - responded;
+      }
+
+      [[nodiscard]] auto decoding() const noexcept -> clock::duration
+      {
+         return decoded - received;
+      }
+
+      [[nodiscard]] auto total() const noexcept -> clock::duration
+      {
+         return decoded - started;
+      }
+   };
+
+   struct transaction_event
+   {
+      enum class kind
+      {
+         begin,
+         commit,
+         rollback
+      };
+
+      const pq::connection* connection = nullptr;
+      const pq::transaction* transaction = nullptr;
+      kind what = kind::begin;
+      bool nested = false;
+   };
+
+   // returned by an observer before a statement is sent
+   struct statement_annotation
+   {
+      // prepended as an SQL comment to statements which are not prepared
+      std::string comment;
+
+      // set as the connection's application_name if it differs from the
+      // previous one, note that this requires an additional round-trip
+      std::string application_name;
+   };
+
+   class observer
+   {
+   public:
+      observer() = default;
+
+      observer( const observer& ) = delete;
+      observer( observer&& ) = delete;
+      void operator=( const observer& ) = delete;
+      void operator=( observer&& ) = delete;
+
+      virtual ~observer() = default;
+
+      // called once for each statement executed by a connection, must not throw
+      virtual void on_statement( const statement_event& event ) noexcept = 0;
+
+      // called when a transaction or a nested transaction begins and ends, must not throw
+      virtual void on_transaction( const transaction_event& /*unused*/ ) noexcept
+      {}
+
+      // called on the executing thread before a statement is sent
+      [[nodiscard]] virtual auto annotate( const pq::connection& /*unused*/, const char* /*unused*/ ) -> statement_annotation
+      {
+         return {};
+      }
+   };
+
+   // forwards to several observers, the first non-empty annotations are used
+   class observer_list final
+      : public observer
+   {
+   private:
+      const std::vector< std::shared_ptr< observer > > m_observers;
+
+   public:
+      explicit observer_list( std::vector< std::shared_ptr< observer > > observers ) noexcept;
+
+      void on_statement( const statement_event& event ) noexcept override;
+      void on_transaction( const transaction_event& event ) noexcept override;
+      [[nodiscard]] auto annotate( const pq::connection& c, const char* statement ) -> statement_annotation override;
+   };
+
+}  // namespace tao::pq
+
+#endif
@@ -0,0 +1,86 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#ifndef TAO_PQ_PARALLEL_SCAN_HPP
+#define TAO_PQ_PARALLEL_SCAN_HPP
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <tao/pq/connection_pool.hpp>
+#include <tao/pq/result.hpp>
+#include <tao/pq/transaction.hpp>
+
+namespace tao::pq
+{
+   struct parallel_scan_options
+   {
+      // the number of connections scanning partitions at the same time
+      std::size_t workers = 4;
+
+      // the number of rows fetched from a partition's cursor at a time
+      std::size_t fetch_rows = 10000;
+   };
+
+   namespace internal
+   {
+      // calls the task for each partition, on up to "workers" threads, each with
+      // a repeatable read transaction on a connection of the pool which imported
+      // the snapshot of a coordinating transaction, rethrows the first exception
+      void parallel_for_each( const std::shared_ptr< connection_pool >& pool,
+                              const std::size_t partitions,
+                              const std::size_t workers,
+                              const std::function< void( const std::shared_ptr< transaction >&, const std::size_t ) >& task );
+
+      // a statement which declares the cursor of a partition for the given statement
+      [[nodiscard]] auto declare_scan_cursor( const std::string& statement ) -> std::string;
+
+      // fetches the declared cursor in chunks of up to "rows" rows until a chunk
+      // is short, calls the function for each non-empty chunk and closes the cursor
+      void fetch_scan_cursor( const std::shared_ptr< transaction >& tr, const std::size_t rows, const std::function< void( const result& ) >& f );
+
+   }  // namespace internal
+
+   // executes the statement once per partition, with the bounds of the partition
+   // as $1 and $2, e.g.
+   //
+   //    SELECT * FROM events WHERE id >= $1 AND id < $2
+   //
+   // all partitions see the same snapshot of the database. each partition is read
+   // through a cursor, the callback receives the index of the partition and a
+   // chunk of up to "fetch_rows" rows, it is called for each non-empty chunk in
+   // order, and concurrently from the worker threads for different partitions.
+   template< typename Bound, typename F >
+   void parallel_scan( const std::shared_ptr< connection_pool >& pool,
+                       const std::string& statement,
+                       const std::vector< std::pair< Bound, Bound > >& partitions,
+                       F&& f,
+                       const parallel_scan_options& options = parallel_scan_options() )
+   {
+      if( options.fetch_rows == 0 ) {
+         throw std::invalid_argument( "parallel scan without rows to fetch" );
+      }
+      const auto declare = internal::declare_scan_cursor( statement );
+      internal::parallel_for_each( pool, partitions.size(), options.workers, [ & ]( const std::shared_ptr< transaction >& tr, const std::size_t i ) {
+         tr->execute( declare, partitions[ i ].first, partitions[ i ].second );
+         internal::fetch_scan_cursor( tr, options.fetch_rows, [ & ]( const result& r ) { f( i, r ); } );
+      } );
+   }
+
+   // splits the pages of a table into ranges of ctids, to be used as
+   //
+   //    SELECT * FROM events WHERE ctid >= $1::tid AND ctid < $2::tid
+   //
+   // the last range is open-ended, so it includes pages added in the meantime.
+   // tid range scans need PostgreSQL 14, older servers scan the whole table
+   // for each partition.
+   [[nodiscard]] auto ctid_partitions( const std::shared_ptr< transaction >& tr, const std::string& table, const std::size_t n ) -> std::vector< std::pair< std::string, std::string > >;
+
+}  // namespace tao::pq
+
+#endif
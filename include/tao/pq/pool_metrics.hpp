@@ -0,0 +1,34 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#ifndef TAO_PQ_POOL_METRICS_HPP
+#define TAO_PQ_POOL_METRICS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <tao/pq/internal/histogram.hpp>
+
+namespace tao::pq
+{
+   struct pool_metrics
+   {
+      std::size_t idle = 0;
+      std::size_t in_use = 0;
+
+      std::uint64_t checkouts = 0;  // successful ones only
+      std::uint64_t creations = 0;
+      std::uint64_t creation_failures = 0;
+      std::uint64_t invalidated = 0;  // dropped when found to be invalid
+
+      internal::histogram_snapshot checkout_latency;  // in nanoseconds
+      internal::histogram_snapshot connection_age;    // in milliseconds, at checkout
+
+      // Prometheus text exposition format, all metric names start with the given prefix
+      [[nodiscard]] auto to_prometheus( const std::string& prefix = "taopq_pool" ) const -> std::string;
+   };
+
+}  // namespace tao::pq
+
+#endif
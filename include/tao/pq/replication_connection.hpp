@@ -0,0 +1,170 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#ifndef TAO_PQ_REPLICATION_CONNECTION_HPP
+#define TAO_PQ_REPLICATION_CONNECTION_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <libpq-fe.h>
+
+#include <tao/pq/connection.hpp>
+
+namespace tao::pq
+{
+   // formats a position in the write-ahead log as e.g. "16/B374D848"
+   [[nodiscard]] auto format_lsn( const std::uint64_t lsn ) -> std::string;
+   [[nodiscard]] auto parse_lsn( const std::string& lsn ) -> std::uint64_t;
+
+   struct replication_options
+   {
+      std::string slot = "taopq";
+
+      // "pgoutput" or "test_decoding"
+      std::string plugin = "pgoutput";
+
+      // the publications streamed by pgoutput
+      std::vector< std::string > publications;
+
+      // the slot is created unless it exists already
+      bool create_slot = true;
+      bool temporary_slot = false;
+
+      // where to start streaming, 0 continues after the slot's confirmed position
+      std::uint64_t start = 0;
+
+      // how often a standby status update is sent, if not requested by the server before
+      std::chrono::milliseconds status_interval = std::chrono::seconds( 10 );
+   };
+
+   struct change_event
+   {
+      enum class kind
+      {
+         begin,
+         commit,
+         insert,
+         update,
+         delete_,
+         truncate
+      };
+
+      kind type = kind::begin;
+
+      // the position of the change, acknowledge the position of a commit
+      // after the transaction was processed
+      std::uint64_t lsn = 0;
+
+      // the transaction, if known
+      std::uint32_t xid = 0;
+
+      // the table of an insert, update, delete or truncate
+      std::string schema;
+      std::string table;
+
+      // the values are in the text format, SQL NULL is nullopt; the old values of
+      // an update are only known for the replica identity, or with REPLICA
+      // IDENTITY FULL, and empty otherwise; a delete has old values
+      std::vector< std::string > columns;
+      std::vector< std::optional< std::string > > values;
+      std::vector< std::optional< std::string > > old_values;
+
+      // one flag per value, set for a TOASTed value which an update did not
+      // change and which is therefore not sent, its value is nullopt and must
+      // not be applied as NULL
+      std::vector< bool > unchanged;
+   };
+
+   // a connection in the logical replication mode, streaming the changes of a
+   // replication slot. positions which were processed are acknowledged to the
+   // server with the next standby status update, after which it may recycle
+   // the write-ahead log up to there.
+   class replication_connection final
+   {
+   private:
+      using clock = std::chrono::steady_clock;
+
+      struct relation
+      {
+         std::string schema;
+         std::string table;
+         std::vector< std::string > columns;
+      };
+
+      const std::unique_ptr< PGconn, internal::deleter > m_pgconn;
+      const replication_options m_options;
+
+      std::deque< change_event > m_events;
+      std::map< std::uint32_t, relation > m_relations;
+      std::uint32_t m_xid = 0;
+
+      std::uint64_t m_received = 0;
+      std::uint64_t m_acknowledged = 0;
+      clock::time_point m_last_status;
+
+      [[nodiscard]] auto error_message() const -> std::string;
+
+      void start();
+      void receive( const char* data, const std::size_t size );
+      void decode_pgoutput( const char* data, const std::size_t size, const std::uint64_t lsn );
+      void decode_test_decoding( const std::string& line, const std::uint64_t lsn );
+
+   public:
+      [[nodiscard]] static auto create( const std::string& connection_info, const replication_options& options = replication_options() ) -> std::shared_ptr< replication_connection >;
+
+   private:
+      // pass-key idiom
+      class private_key
+      {
+         private_key() = default;
+         friend auto replication_connection::create( const std::string& connection_info, const replication_options& options ) -> std::shared_ptr< replication_connection >;
+      };
+
+   public:
+      replication_connection( const private_key& /*unused*/, const std::string& connection_info, const replication_options& options );
+
+      replication_connection( const replication_connection& ) = delete;
+      replication_connection( replication_connection&& ) = delete;
+      void operator=( const replication_connection& ) = delete;
+      void operator=( replication_connection&& ) = delete;
+
+      // sends a final standby status update
+      ~replication_connection();
+
+      // waits for the next change, returns nullopt on timeout
+      [[nodiscard]] auto next( const std::chrono::milliseconds timeout ) -> std::optional< change_event >;
+
+      // the changes up to lsn were processed, reported with the next status update
+      void acknowledge( const std::uint64_t lsn ) noexcept;
+
+      // sends a standby status update now
+      void send_status( const bool reply_requested = false );
+
+      // the position of the last received change
+      [[nodiscard]] auto received() const noexcept -> std::uint64_t
+      {
+         return m_received;
+      }
+
+      [[nodiscard]] auto acknowledged() const noexcept -> std::uint64_t
+      {
+         return m_acknowledged;
+      }
+
+      [[nodiscard]] auto underlying_raw_ptr() noexcept -> PGconn*
+      {
+         return m_pgconn.get();
+      }
+   };
+
+}  // namespace tao::pq
+
+#endif
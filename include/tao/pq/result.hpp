@@ -25,6 +25,7 @@
 namespace tao::pq
 {
    class connection;
+   class result_cache;
    class table_writer;
 
    namespace internal
@@ -41,6 +42,8 @@ namespace tao::pq
    {
    private:
       friend class connection;
+      friend class replication_connection;
+      friend class result_cache;
       friend class table_writer;
 
       const std::shared_ptr< PGresult > m_pgresult;
@@ -53,11 +56,15 @@ namespace tao::pq
       enum class mode_t
       {
          expect_ok,
-         expect_copy_in
+         expect_copy_in,
+         expect_copy_both
       };
-      result( PGresult* pgresult, const mode_t mode = mode_t::expect_ok );
+      result( PGresult* pgresult, const mode_t mode );
 
    public:
+      // takes ownership of the PGresult, e.g. one obtained from libpq directly
+      explicit result( PGresult* pgresult );
+
       [[nodiscard]] auto has_rows_affected() const noexcept -> bool;
       [[nodiscard]] auto rows_affected() const -> std::size_t;
 
@@ -0,0 +1,210 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#ifndef TAO_PQ_RESULT_CACHE_HPP
+#define TAO_PQ_RESULT_CACHE_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <tao/pq/connection.hpp>
+#include <tao/pq/connection_pool.hpp>
+#include <tao/pq/internal/gen.hpp>
+#include <tao/pq/internal/notification_listener.hpp>
+#include <tao/pq/parameter_traits.hpp>
+#include <tao/pq/result.hpp>
+
+namespace tao::pq
+{
+   struct result_cache_options
+   {
+      // of all cached results, as reported by PQresultMemorySize(), plus their keys
+      std::size_t max_bytes = 64 * 1024 * 1024;
+
+      // of entries whose policy does not specify a time to live
+      std::chrono::milliseconds ttl = std::chrono::seconds( 60 );
+
+      // the dedicated connection listens on this channel, each notification
+      // invalidates the tag given as its payload, or all entries if the payload
+      // is empty. an empty channel disables the listener.
+      std::string channel = "taopq_result_cache";
+      std::chrono::milliseconds reconnect_interval = std::chrono::seconds( 1 );
+   };
+
+   // how a single result is cached
+   struct cache_policy
+   {
+      std::chrono::milliseconds ttl{ 0 };  // zero uses the cache's default
+      std::vector< std::string > tags;     // invalidating one of them drops the result
+   };
+
+   struct result_cache_metrics
+   {
+      std::size_t entries = 0;
+      std::size_t bytes = 0;
+
+      std::uint64_t hits = 0;
+      std::uint64_t misses = 0;
+      std::uint64_t evicted = 0;      // dropped to stay within max_bytes
+      std::uint64_t expired = 0;      // dropped when found to be older than their ttl
+      std::uint64_t invalidated = 0;  // dropped by invalidate(), clear() or a notification
+      std::uint64_t notifications = 0;
+   };
+
+   // a read-through cache of autocommit statements executed on a pool, keyed by
+   // statement and encoded parameters. misses are coalesced, see
+   // connection_pool::execute_coalesced(). while the listener is disconnected,
+   // invalidations could be missed, therefore the cache is bypassed.
+   class result_cache final
+   {
+   private:
+      const std::shared_ptr< connection_pool > m_pool;
+      const result_cache_options m_options;
+
+      struct entry
+      {
+         std::string key;
+         pq::result result;
+         std::size_t bytes;
+         std::chrono::steady_clock::time_point expires;
+         std::vector< std::string > tags;
+      };
+
+      mutable std::mutex m_mutex;
+      std::list< entry > m_entries;  // the most recently used first
+      std::unordered_map< std::string_view, std::list< entry >::iterator > m_index;
+      std::map< std::string, std::set< std::string_view >, std::less<> > m_tags;
+      std::size_t m_bytes = 0;
+      std::uint64_t m_generation = 0;  // incremented by each invalidation
+
+      std::uint64_t m_hits = 0;
+      std::uint64_t m_misses = 0;
+      std::uint64_t m_evicted = 0;
+      std::uint64_t m_expired = 0;
+      std::uint64_t m_invalidated = 0;
+      std::uint64_t m_notifications = 0;
+
+      // last, so it is stopped before the members it uses are destroyed
+      std::unique_ptr< internal::notification_listener > m_listener;
+
+      void erase( const std::list< entry >::iterator it );
+      void store( std::string key, const cache_policy& policy, const result& r, const std::uint64_t generation );
+
+      void receive( const std::string& tag );
+
+      [[nodiscard]] auto execute_params( std::shared_ptr< pq::connection >& c,
+                                         const cache_policy& policy,
+                                         const char* statement,
+                                         const int n_params,
+                                         const Oid types[],
+                                         const char* const values[],
+                                         const int lengths[],
+                                         const int formats[] ) -> result;
+
+      template< std::size_t... Os, std::size_t... Is, typename... Ts >
+      [[nodiscard]] auto execute_indexed( std::shared_ptr< pq::connection >& c,
+                                          const cache_policy& policy,
+                                          const char* statement,
+                                          std::index_sequence< Os... > /*unused*/,
+                                          std::index_sequence< Is... > /*unused*/,
+                                          const std::tuple< Ts... >& tuple )
+      {
+         const Oid types[] = { std::get< Os >( tuple ).template type< Is >()... };
+         const char* const values[] = { std::get< Os >( tuple ).template value< Is >()... };
+         const int lengths[] = { std::get< Os >( tuple ).template length< Is >()... };
+         const int formats[] = { std::get< Os >( tuple ).template format< Is >()... };
+         return execute_params( c, policy, statement, sizeof...( Os ), types, values, lengths, formats );
+      }
+
+      template< typename... Ts >
+      [[nodiscard]] auto execute_traits( std::shared_ptr< pq::connection >& c, const cache_policy& policy, const char* statement, const Ts&... ts )
+      {
+         using gen = internal::gen< Ts::columns... >;
+         return execute_indexed( c, policy, statement, typename gen::outer_sequence(), typename gen::inner_sequence(), std::tie( ts... ) );
+      }
+
+   public:
+      [[nodiscard]] static auto create( const std::shared_ptr< connection_pool >& pool, const result_cache_options& options = result_cache_options() ) -> std::shared_ptr< result_cache >;
+
+   private:
+      // pass-key idiom
+      class private_key
+      {
+         private_key() = default;
+         friend auto result_cache::create( const std::shared_ptr< connection_pool >& pool, const result_cache_options& options ) -> std::shared_ptr< result_cache >;
+      };
+
+   public:
+      result_cache( const private_key& /*unused*/, const std::shared_ptr< connection_pool >& pool, const result_cache_options& options );
+
+      result_cache( const result_cache& ) = delete;
+      result_cache( result_cache&& ) = delete;
+      void operator=( const result_cache& ) = delete;
+      void operator=( result_cache&& ) = delete;
+
+      ~result_cache();
+
+      template< template< typename... > class Traits = parameter_text_traits, typename... As >
+      [[nodiscard]] auto execute( const cache_policy& policy, const char* statement, As&&... as ) -> result
+      {
+         std::shared_ptr< pq::connection > c;
+         return execute_traits( c, policy, statement, m_pool->to_traits< Traits >( c, std::forward< As >( as ) )... );
+      }
+
+      // short-cut for no-arguments invocations
+      template< template< typename... > class Traits = parameter_text_traits >
+      [[nodiscard]] auto execute( const cache_policy& policy, const char* statement ) -> result
+      {
+         std::shared_ptr< pq::connection > c;
+         return execute_params( c, policy, statement, 0, nullptr, nullptr, nullptr, nullptr );
+      }
+
+      template< template< typename... > class Traits = parameter_text_traits, typename... As >
+      [[nodiscard]] auto execute( const cache_policy& policy, const std::string& statement, As&&... as ) -> result
+      {
+         return execute< Traits >( policy, statement.c_str(), std::forward< As >( as )... );
+      }
+
+      // with the default policy, i.e. the default time to live and no tags
+      template< template< typename... > class Traits = parameter_text_traits, typename... As >
+      [[nodiscard]] auto execute( const char* statement, As&&... as ) -> result
+      {
+         return execute< Traits >( cache_policy(), statement, std::forward< As >( as )... );
+      }
+
+      template< template< typename... > class Traits = parameter_text_traits, typename... As >
+      [[nodiscard]] auto execute( const std::string& statement, As&&... as ) -> result
+      {
+         return execute< Traits >( cache_policy(), statement.c_str(), std::forward< As >( as )... );
+      }
+
+      // drops the entries locally, use notify() to drop them from all caches
+      void invalidate( const std::string& tag );
+      void clear();
+
+      // sends a notification on the cache's channel, an empty tag invalidates all entries
+      void notify( const std::string& tag = std::string() );
+
+      [[nodiscard]] auto listening() const noexcept -> bool
+      {
+         return m_listener && m_listener->listening();
+      }
+
+      [[nodiscard]] auto metrics() const -> result_cache_metrics;
+   };
+
+}  // namespace tao::pq
+
+#endif
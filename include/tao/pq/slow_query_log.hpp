@@ -0,0 +1,107 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#ifndef TAO_PQ_SLOW_QUERY_LOG_HPP
+#define TAO_PQ_SLOW_QUERY_LOG_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <tao/pq/internal/ring_buffer.hpp>
+#include <tao/pq/observer.hpp>
+
+namespace tao::pq
+{
+   struct slow_query
+   {
+      std::chrono::system_clock::time_point time;  // when the statement finished
+      std::string statement;
+      bool prepared = false;
+      std::size_t rows = 0;
+      std::size_t bytes_sent = 0;
+      std::string error;  // empty on success
+
+      std::chrono::nanoseconds encoding{ 0 };
+      std::chrono::nanoseconds sending{ 0 };
+      std::chrono::nanoseconds waiting{ 0 };
+      std::chrono::nanoseconds receiving{ 0 };
+      std::chrono::nanoseconds decoding{ 0 };
+      std::chrono::nanoseconds total{ 0 };
+
+      // the first parameters, truncated, "NULL" for null values and
+      // hex-encoded as "\x..." for binary values
+      std::vector< std::string > parameters;
+      int omitted_parameters = 0;
+
+      [[nodiscard]] auto to_text() const -> std::string;
+      [[nodiscard]] auto to_json() const -> std::string;
+   };
+
+   struct slow_query_options
+   {
+      std::chrono::nanoseconds threshold = std::chrono::milliseconds( 100 );
+      std::size_t max_parameters = 8;
+      std::size_t max_parameter_length = 64;
+
+      // entries are dropped when the buffer is full
+      std::size_t buffer_size = 1024;
+      std::chrono::milliseconds flush_interval = std::chrono::milliseconds( 100 );
+   };
+
+   // records statements slower than a threshold. the executing thread only
+   // renders the entry and pushes it into a lock-free ring buffer, a
+   // background thread passes the entries on to the sink.
+   class slow_query_log final
+      : public observer
+   {
+   public:
+      using sink = std::function< void( const slow_query& ) >;
+
+   private:
+      const slow_query_options m_options;
+      const sink m_sink;
+
+      internal::ring_buffer< slow_query > m_buffer;
+      std::atomic< std::uint64_t > m_dropped{ 0 };
+
+      std::mutex m_sink_mutex;
+      std::mutex m_mutex;
+      std::condition_variable m_condition;
+      bool m_stop = false;
+      std::thread m_thread;
+
+      void run();
+
+   public:
+      explicit slow_query_log( sink s, const slow_query_options& options = slow_query_options() );
+
+      slow_query_log( const slow_query_log& ) = delete;
+      slow_query_log( slow_query_log&& ) = delete;
+      void operator=( const slow_query_log& ) = delete;
+      void operator=( slow_query_log&& ) = delete;
+
+      // drains the remaining entries before returning
+      ~slow_query_log() override;
+
+      void on_statement( const statement_event& event ) noexcept override;
+
+      // passes all buffered entries to the sink on the calling thread
+      void flush();
+
+      [[nodiscard]] auto dropped() const noexcept -> std::uint64_t
+      {
+         return m_dropped.load( std::memory_order_relaxed );
+      }
+   };
+
+}  // namespace tao::pq
+
+#endif
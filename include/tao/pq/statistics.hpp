@@ -0,0 +1,74 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#ifndef TAO_PQ_STATISTICS_HPP
+#define TAO_PQ_STATISTICS_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <tao/pq/observer.hpp>
+
+namespace tao::pq
+{
+   // client-side per statement statistics, statements are grouped by their
+   // fingerprint, i.e. with literals replaced by '?'. each thread records into
+   // its own shard without taking locks, shards are merged when reading.
+   class statistics final
+      : public observer
+   {
+   public:
+      struct entry
+      {
+         std::string statement;
+         std::uint64_t calls = 0;
+         std::uint64_t errors = 0;
+         std::uint64_t rows = 0;
+         std::uint64_t bytes_sent = 0;
+         std::chrono::nanoseconds total{ 0 };
+         std::chrono::nanoseconds mean{ 0 };
+         std::chrono::nanoseconds p50{ 0 };
+         std::chrono::nanoseconds p99{ 0 };
+         std::chrono::nanoseconds p999{ 0 };
+         std::chrono::nanoseconds max{ 0 };
+      };
+
+   private:
+      struct shard;
+
+      const std::uint64_t m_id;
+      const std::size_t m_max_statements;
+
+      mutable std::mutex m_mutex;
+      std::vector< std::shared_ptr< shard > > m_shards;
+
+      [[nodiscard]] auto local_shard() -> shard&;
+
+   public:
+      // statements beyond max_statements distinct fingerprints (per thread) are accounted as "?"
+      explicit statistics( const std::size_t max_statements = 1000 );
+
+      statistics( const statistics& ) = delete;
+      statistics( statistics&& ) = delete;
+      void operator=( const statistics& ) = delete;
+      void operator=( statistics&& ) = delete;
+
+      ~statistics() override;
+
+      void on_statement( const statement_event& event ) noexcept override;
+
+      // sorted by total time, descending
+      [[nodiscard]] auto snapshot() const -> std::vector< entry >;
+
+      [[nodiscard]] auto to_text() const -> std::string;
+      [[nodiscard]] auto to_json() const -> std::string;
+   };
+
+}  // namespace tao::pq
+
+#endif
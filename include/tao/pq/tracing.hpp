@@ -0,0 +1,144 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#ifndef TAO_PQ_TRACING_HPP
+#define TAO_PQ_TRACING_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <tao/pq/observer.hpp>
+
+namespace tao::pq
+{
+   // W3C trace context, ids are lower-case hex strings
+   struct trace_context
+   {
+      std::string trace_id;  // 32 hex digits
+      std::string span_id;   // 16 hex digits
+
+      [[nodiscard]] static auto generate() -> trace_context;
+
+      // parses a W3C traceparent header, e.g. "00-<trace_id>-<span_id>-01"
+      [[nodiscard]] static auto from_traceparent( const std::string& traceparent ) -> trace_context;
+      [[nodiscard]] auto traceparent() const -> std::string;
+   };
+
+   // makes a trace context the parent of all spans created by the current thread while in scope
+   class trace_scope
+   {
+   private:
+      const trace_context m_context;
+      const trace_scope* const m_previous;
+
+   public:
+      explicit trace_scope( trace_context context ) noexcept;
+      ~trace_scope();
+
+      trace_scope( const trace_scope& ) = delete;
+      trace_scope( trace_scope&& ) = delete;
+      void operator=( const trace_scope& ) = delete;
+      void operator=( trace_scope&& ) = delete;
+
+      [[nodiscard]] static auto current() noexcept -> const trace_context*;
+   };
+
+   struct span
+   {
+      std::string name;  // "transaction", "savepoint" or "statement"
+      std::string trace_id;
+      std::string span_id;
+      std::string parent_span_id;
+      std::chrono::system_clock::time_point start;
+      std::chrono::system_clock::time_point end;
+      std::string statement;  // fingerprint of the statement
+      int backend_pid = 0;
+      std::size_t rows = 0;
+      std::string error;  // empty on success, "rollback" for rolled back transactions
+
+      [[nodiscard]] auto to_json() const -> std::string;
+   };
+
+   class span_sink
+   {
+   public:
+      span_sink() = default;
+
+      span_sink( const span_sink& ) = delete;
+      span_sink( span_sink&& ) = delete;
+      void operator=( const span_sink& ) = delete;
+      void operator=( span_sink&& ) = delete;
+
+      virtual ~span_sink() = default;
+
+      // called from the threads executing statements, must not throw
+      virtual void export_span( const span& s ) noexcept = 0;
+   };
+
+   class memory_span_sink final
+      : public span_sink
+   {
+   private:
+      mutable std::mutex m_mutex;
+      std::vector< span > m_spans;
+
+   public:
+      void export_span( const span& s ) noexcept override;
+
+      [[nodiscard]] auto spans() const -> std::vector< span >;
+      void clear() noexcept;
+   };
+
+   // writes one JSON object per line
+   class file_span_sink final
+      : public span_sink
+   {
+   private:
+      std::mutex m_mutex;
+      std::ofstream m_stream;
+
+   public:
+      explicit file_span_sink( const std::string& filename );
+
+      void export_span( const span& s ) noexcept override;
+   };
+
+   // creates spans for transactions and statements and optionally
+   // propagates the trace context to the server
+   class tracer final
+      : public observer
+   {
+   public:
+      enum class propagation
+      {
+         none,
+         comment,          // as /* traceparent='...' */ in front of statements
+         application_name  // as the connection's application_name
+      };
+
+   private:
+      const std::shared_ptr< span_sink > m_sink;
+      const propagation m_propagation;
+
+      std::mutex m_mutex;
+      std::unordered_map< const pq::connection*, std::vector< span > > m_open;
+
+      [[nodiscard]] auto parent( const pq::connection* c ) -> trace_context;
+
+   public:
+      explicit tracer( std::shared_ptr< span_sink > sink, const propagation p = propagation::none ) noexcept;
+
+      void on_statement( const statement_event& event ) noexcept override;
+      void on_transaction( const transaction_event& event ) noexcept override;
+      [[nodiscard]] auto annotate( const pq::connection& c, const char* statement ) -> statement_annotation override;
+   };
+
+}  // namespace tao::pq
+
+#endif
@@ -11,8 +11,10 @@
 #include <utility>
 
 #include <tao/pq/internal/gen.hpp>
+#include <tao/pq/observer.hpp>
 #include <tao/pq/parameter_traits.hpp>
 #include <tao/pq/result.hpp>
+#include <tao/pq/type_catalog.hpp>
 
 namespace tao::pq
 {
@@ -49,8 +51,14 @@ namespace tao::pq
       [[nodiscard]] auto current_transaction() const noexcept -> transaction*&;
       void check_current_transaction() const;
 
+      void notify_observer( const transaction_event::kind what, const bool nested = false ) const noexcept;
+
    private:
-      [[nodiscard]] auto execute_params( const char* statement,
+      // returns a default constructed time_point unless an observer is installed
+      [[nodiscard]] auto observed_now() const noexcept -> statement_event::time_point;
+
+      [[nodiscard]] auto execute_params( const statement_event::time_point started,
+                                         const char* statement,
                                          const int n_params,
                                          const Oid types[],
                                          const char* const values[],
@@ -58,7 +66,8 @@ namespace tao::pq
                                          const int formats[] ) -> result;
 
       template< std::size_t... Os, std::size_t... Is, typename... Ts >
-      [[nodiscard]] auto execute_indexed( const char* statement,
+      [[nodiscard]] auto execute_indexed( const statement_event::time_point started,
+                                          const char* statement,
                                           std::index_sequence< Os... > /*unused*/,
                                           std::index_sequence< Is... > /*unused*/,
                                           const std::tuple< Ts... >& tuple )
@@ -67,17 +76,18 @@ namespace tao::pq
          const char* const values[] = { std::get< Os >( tuple ).template value< Is >()... };
          const int lengths[] = { std::get< Os >( tuple ).template length< Is >()... };
          const int formats[] = { std::get< Os >( tuple ).template format< Is >()... };
-         return execute_params( statement, sizeof...( Os ), types, values, lengths, formats );
+         return execute_params( started, statement, sizeof...( Os ), types, values, lengths, formats );
       }
 
       template< typename... Ts >
-      [[nodiscard]] auto execute_traits( const char* statement, const Ts&... ts )
+      [[nodiscard]] auto execute_traits( const statement_event::time_point started, const char* statement, const Ts&... ts )
       {
          using gen = internal::gen< Ts::columns... >;
-         return execute_indexed( statement, typename gen::outer_sequence(), typename gen::inner_sequence(), std::tie( ts... ) );
+         return execute_indexed( started, statement, typename gen::outer_sequence(), typename gen::inner_sequence(), std::tie( ts... ) );
       }
 
       [[nodiscard]] auto underlying_raw_ptr() const noexcept -> PGconn*;
+      [[nodiscard]] auto types() const noexcept -> const type_catalog&;
 
       template< template< typename... > class Traits, typename A >
       auto to_traits( A&& a ) const
@@ -89,6 +99,9 @@ namespace tao::pq
          else if constexpr( std::is_constructible_v< T, PGconn*, decltype( std::forward< A >( a ) ) > ) {
             return T( underlying_raw_ptr(), std::forward< A >( a ) );
          }
+         else if constexpr( std::is_constructible_v< T, const type_catalog&, decltype( std::forward< A >( a ) ) > ) {
+            return T( types(), std::forward< A >( a ) );
+         }
          else {
             static_assert( std::is_void_v< T >, "no valid conversion from A to Traits" );
          }
@@ -108,14 +121,15 @@ namespace tao::pq
       template< template< typename... > class Traits = parameter_text_traits, typename... As >
       auto execute( const char* statement, As&&... as )
       {
-         return execute_traits( statement, to_traits< Traits >( std::forward< As >( as ) )... );
+         const auto started = observed_now();
+         return execute_traits( started, statement, to_traits< Traits >( std::forward< As >( as ) )... );
       }
 
       // short-cut for no-arguments invocations
       template< template< typename... > class Traits = parameter_text_traits >
       auto execute( const char* statement )
       {
-         return execute_params( statement, 0, nullptr, nullptr, nullptr, nullptr );
+         return execute_params( observed_now(), statement, 0, nullptr, nullptr, nullptr, nullptr );
       }
 
       template< template< typename... > class Traits = parameter_text_traits, typename... As >
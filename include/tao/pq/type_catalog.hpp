@@ -0,0 +1,78 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#ifndef TAO_PQ_TYPE_CATALOG_HPP
+#define TAO_PQ_TYPE_CATALOG_HPP
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <libpq-fe.h>
+
+namespace tao::pq
+{
+   class transaction;
+
+   // the Oids of types which are only known at run-time, i.e. enums, composites,
+   // domains and the types of extensions like hstore or citext. parameter traits
+   // constructible from a type catalog and a value are given the catalog of the
+   // connection, they can send these types in the binary format.
+   class type_catalog final
+   {
+   private:
+      struct entry
+      {
+         Oid oid = 0;
+         Oid array = 0;
+      };
+
+      std::map< std::string, entry, std::less<> > m_types;
+
+      [[nodiscard]] auto at( const std::string_view name ) const -> const entry&;
+
+   public:
+      // looks up the types with a single query, the names are resolved like in
+      // SQL, e.g. "mood" with the search path or "public.hstore". types which do
+      // not exist, e.g. of extensions which are not installed, are left out.
+      [[nodiscard]] static auto load( const std::shared_ptr< transaction >& tr, const std::vector< std::string >& names ) -> std::shared_ptr< const type_catalog >;
+
+      [[nodiscard]] auto size() const noexcept -> std::size_t
+      {
+         return m_types.size();
+      }
+
+      [[nodiscard]] auto empty() const noexcept -> bool
+      {
+         return m_types.empty();
+      }
+
+      [[nodiscard]] auto contains( const std::string_view name ) const -> bool;
+
+      // throws std::out_of_range for types which were not loaded
+      [[nodiscard]] auto oid( const std::string_view name ) const -> Oid;
+      [[nodiscard]] auto array_oid( const std::string_view name ) const -> Oid;
+   };
+
+   // a value of a named type whose binary format is its text, e.g. the label of
+   // an enum, a citext or a domain over text
+   struct typed_text
+   {
+      std::string type;
+      std::string value;
+   };
+
+   // the keys and values of an hstore, the type named "hstore" must be loaded
+   struct hstore
+   {
+      std::map< std::string, std::optional< std::string > > values;
+   };
+
+}  // namespace tao::pq
+
+#endif
@@ -0,0 +1,52 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#ifndef TAO_PQ_WIRE_COUNTERS_HPP
+#define TAO_PQ_WIRE_COUNTERS_HPP
+
+#include <cstdint>
+
+namespace tao::pq
+{
+   // protocol level traffic of a connection. the byte counts are estimated from
+   // the sizes of the protocol messages, they are not measured on the socket and
+   // exclude TLS and TCP overhead.
+   struct wire_counters
+   {
+      std::uint64_t round_trips = 0;  // times the client waited for the server to respond
+      std::uint64_t estimated_bytes_sent = 0;
+      std::uint64_t estimated_bytes_received = 0;
+      std::uint64_t results = 0;
+
+      auto operator+=( const wire_counters& rhs ) noexcept -> wire_counters&
+      {
+         round_trips += rhs.round_trips;
+         estimated_bytes_sent += rhs.estimated_bytes_sent;
+         estimated_bytes_received += rhs.estimated_bytes_received;
+         results += rhs.results;
+         return *this;
+      }
+
+      auto operator-=( const wire_counters& rhs ) noexcept -> wire_counters&
+      {
+         round_trips -= rhs.round_trips;
+         estimated_bytes_sent -= rhs.estimated_bytes_sent;
+         estimated_bytes_received -= rhs.estimated_bytes_received;
+         results -= rhs.results;
+         return *this;
+      }
+   };
+
+   [[nodiscard]] inline auto operator+( wire_counters lhs, const wire_counters& rhs ) noexcept -> wire_counters
+   {
+      return lhs += rhs;
+   }
+
+   [[nodiscard]] inline auto operator-( wire_counters lhs, const wire_counters& rhs ) noexcept -> wire_counters
+   {
+      return lhs -= rhs;
+   }
+
+}  // namespace tao::pq
+
+#endif
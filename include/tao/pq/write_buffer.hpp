@@ -0,0 +1,262 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#ifndef TAO_PQ_WRITE_BUFFER_HPP
+#define TAO_PQ_WRITE_BUFFER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#include <tao/pq/internal/copy_format.hpp>
+
+#include <tao/pq/connection_pool.hpp>
+#include <tao/pq/parameter_traits.hpp>
+#include <tao/pq/table_writer.hpp>
+#include <tao/pq/transaction.hpp>
+
+namespace tao::pq
+{
+   struct write_buffer_options
+   {
+      // a flush is started when a batch has this many rows...
+      std::size_t flush_rows = 1000;
+
+      // ...or when its first row was appended this long ago
+      std::chrono::milliseconds flush_interval = std::chrono::milliseconds( 100 );
+
+      // append() blocks while the buffered and the flushing rows take this many
+      // bytes of COPY data, a single row is always accepted
+      std::size_t max_bytes = 16 * 1024 * 1024;
+   };
+
+   // collects rows appended by many threads and writes them in batches to a
+   // table with COPY, each batch in its own transaction on a connection of the
+   // pool. the rows are encoded with the text parameter traits, a row is any
+   // type supported by them, e.g. a std::tuple<> with a field per column.
+   template< typename Row >
+   class write_buffer final
+   {
+   private:
+      static_assert( std::is_constructible_v< parameter_text_traits< Row >, const Row& >, "rows must be encodable without a connection" );
+
+      using clock = std::chrono::steady_clock;
+
+      struct batch
+      {
+         std::string data;
+         std::size_t rows = 0;
+         clock::time_point opened = clock::now();
+         std::promise< void > promise;
+         std::shared_future< void > done = promise.get_future().share();
+      };
+
+      const std::shared_ptr< connection_pool > m_pool;
+      const std::string m_statement;
+      const write_buffer_options m_options;
+
+      std::mutex m_mutex;
+      std::condition_variable m_wakeup;
+      std::condition_variable m_space;
+      std::shared_ptr< batch > m_open;
+      std::deque< std::shared_ptr< batch > > m_closed;
+      std::shared_ptr< batch > m_flushing;
+      std::size_t m_bytes = 0;
+      bool m_stop = false;
+
+      std::atomic< std::uint64_t > m_rows{ 0 };
+      std::atomic< std::uint64_t > m_flushes{ 0 };
+      std::atomic< std::uint64_t > m_failures{ 0 };
+
+      std::thread m_thread;
+
+      // requires the lock
+      void close()
+      {
+         m_closed.emplace_back( std::move( m_open ) );
+         m_open.reset();
+         m_wakeup.notify_one();
+      }
+
+      // the batch is settled by the caller once its bytes were released
+      [[nodiscard]] auto write( const batch& b ) -> std::exception_ptr
+      {
+         try {
+            const auto tr = m_pool->connection()->transaction();
+            {
+               table_writer tw( tr, m_statement );
+               for( std::size_t pos = 0; pos < b.data.size(); pos += internal::copy_chunk_size ) {
+                  tw.insert( b.data.substr( pos, internal::copy_chunk_size ) );
+               }
+               (void)tw.finish();
+            }
+            tr->commit();
+            m_flushes.fetch_add( 1, std::memory_order_relaxed );
+            return nullptr;
+         }
+         catch( ... ) {
+            m_failures.fetch_add( 1, std::memory_order_relaxed );
+            return std::current_exception();
+         }
+      }
+
+      void run()
+      {
+         std::unique_lock lock( m_mutex );
+         while( true ) {
+            if( m_closed.empty() ) {
+               if( !m_open ) {
+                  if( m_stop ) {
+                     return;
+                  }
+                  m_wakeup.wait( lock );
+                  continue;
+               }
+               const auto deadline = m_open->opened + m_options.flush_interval;
+               if( !m_stop && ( clock::now() < deadline ) ) {
+                  m_wakeup.wait_until( lock, deadline );
+                  continue;
+               }
+               close();
+            }
+            m_flushing = std::move( m_closed.front() );
+            m_closed.pop_front();
+            lock.unlock();
+            const auto error = write( *m_flushing );
+            lock.lock();
+            m_bytes -= m_flushing->data.size();
+            const auto b = std::move( m_flushing );
+            m_space.notify_all();
+            if( error ) {
+               b->promise.set_exception( error );
+            }
+            else {
+               b->promise.set_value();
+            }
+         }
+      }
+
+   public:
+      // the table is inserted verbatim as SQL into "COPY <table> FROM STDIN", it is
+      // not quoted and may include a schema and a column list, e.g.
+      // "audit.log ( ts, action )", so it must not come from untrusted input
+      [[nodiscard]] static auto create( const std::shared_ptr< connection_pool >& pool, const std::string& table, const write_buffer_options& options = write_buffer_options() ) -> std::shared_ptr< write_buffer >
+      {
+         return std::make_shared< write_buffer >( private_key(), pool, table, options );
+      }
+
+   private:
+      // pass-key idiom
+      class private_key
+      {
+         private_key() = default;
+         friend auto write_buffer::create( const std::shared_ptr< connection_pool >& pool, const std::string& table, const write_buffer_options& options ) -> std::shared_ptr< write_buffer >;
+      };
+
+   public:
+      write_buffer( const private_key& /*unused*/, const std::shared_ptr< connection_pool >& pool, const std::string& table, const write_buffer_options& options )  // NOLINT(modernize-pass-by-value)
+         : m_pool( pool ),
+           m_statement( "COPY " + table + " FROM STDIN" ),
+           m_options( options ),
+           m_thread( [ this ] { run(); } )
+      {}
+
+      write_buffer( const write_buffer& ) = delete;
+      write_buffer( write_buffer&& ) = delete;
+      void operator=( const write_buffer& ) = delete;
+      void operator=( write_buffer&& ) = delete;
+
+      // flushes the remaining rows
+      ~write_buffer()
+      {
+         {
+            const std::lock_guard lock( m_mutex );
+            m_stop = true;
+         }
+         m_wakeup.notify_one();
+         m_thread.join();
+      }
+
+      // the returned future becomes ready when the row was committed, or holds
+      // the exception when writing its batch failed, the rows of a failed batch
+      // are not written again
+      auto append( const Row& row ) -> std::shared_future< void >
+      {
+         std::string line;
+         internal::append_copy_row( line, parameter_text_traits< Row >( row ) );
+         std::unique_lock lock( m_mutex );
+         m_space.wait( lock, [ & ] { return ( m_bytes == 0 ) || ( m_bytes + line.size() <= m_options.max_bytes ); } );
+         m_bytes += line.size();
+         if( !m_open ) {
+            m_open = std::make_shared< batch >();
+            m_wakeup.notify_one();
+         }
+         const auto b = m_open;
+         b->data += line;
+         m_rows.fetch_add( 1, std::memory_order_relaxed );
+         if( ++b->rows >= m_options.flush_rows ) {
+            close();
+         }
+         return b->done;
+      }
+
+      // starts a flush of the buffered rows, the returned future becomes ready
+      // when all rows appended so far were written
+      auto flush() -> std::shared_future< void >
+      {
+         const std::lock_guard lock( m_mutex );
+         if( m_open ) {
+            const auto b = m_open;
+            close();
+            return b->done;
+         }
+         if( !m_closed.empty() ) {
+            return m_closed.back()->done;
+         }
+         if( m_flushing ) {
+            return m_flushing->done;
+         }
+         std::promise< void > p;
+         p.set_value();
+         return p.get_future().share();
+      }
+
+      // the number of calls to append()
+      [[nodiscard]] auto rows() const noexcept -> std::uint64_t
+      {
+         return m_rows.load( std::memory_order_relaxed );
+      }
+
+      // the number of batches written successfully
+      [[nodiscard]] auto flushes() const noexcept -> std::uint64_t
+      {
+         return m_flushes.load( std::memory_order_relaxed );
+      }
+
+      // the number of batches which failed
+      [[nodiscard]] auto failures() const noexcept -> std::uint64_t
+      {
+         return m_failures.load( std::memory_order_relaxed );
+      }
+
+      // the size of the buffered and the flushing rows
+      [[nodiscard]] auto buffered_bytes() -> std::size_t
+      {
+         const std::lock_guard lock( m_mutex );
+         return m_bytes;
+      }
+   };
+
+}  // namespace tao::pq
+
+#endif
@@ -0,0 +1,607 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#ifndef SRC_BENCH_BENCH_HPP  // NOLINT(llvm-header-guard)
+#define SRC_BENCH_BENCH_HPP
+
+// This is an internal header used for benchmarks. It replaces the global
+// operator new/delete to count allocations, so it must be included by
+// exactly one translation unit of each benchmark program.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <tao/pq/internal/histogram.hpp>
+#include <tao/pq/internal/json.hpp>
+#include <tao/pq/internal/printf.hpp>
+
+namespace tao::pq::bench
+{
+   inline std::atomic< std::uint64_t > allocations{ 0 };
+
+}  // namespace tao::pq::bench
+
+auto operator new( std::size_t size ) -> void*
+{
+   tao::pq::bench::allocations.fetch_add( 1, std::memory_order_relaxed );
+   if( void* p = std::malloc( ( size == 0 ) ? 1 : size ) ) {
+      return p;
+   }
+   throw std::bad_alloc();
+}
+
+// when inlined, GCC does not see that the replaced operator new uses malloc()
+#if defined( __GNUC__ ) && !defined( __clang__ ) && ( __GNUC__ >= 11 )
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete( void* p ) noexcept
+{
+   std::free( p );
+}
+
+void operator delete( void* p, std::size_t /*unused*/ ) noexcept
+{
+   std::free( p );
+}
+
+#if defined( __GNUC__ ) && !defined( __clang__ ) && ( __GNUC__ >= 11 )
+#pragma GCC diagnostic pop
+#endif
+
+namespace tao::pq::bench
+{
+   // prevents the compiler from optimizing away a computed value
+   template< typename T >
+   void do_not_optimize( const T& value ) noexcept
+   {
+#if defined( __GNUC__ ) || defined( __clang__ )
+      asm volatile( ""
+                    :
+                    : "r,m"( value )
+                    : "memory" );
+#else
+      static volatile const void* sink;
+      sink = &value;
+#endif
+   }
+
+   struct result
+   {
+      std::string name;
+      std::uint64_t iterations = 0;     // per sample
+      double ns_per_op = 0;             // median of the samples
+      double cpu_ns_per_op = 0;         // median of the process CPU time of the samples, excludes waiting for a server
+      double mad = 0;                   // median absolute deviation of the samples
+      double allocations_per_op = 0;
+   };
+
+   // result of a load benchmark, latencies in nanoseconds
+   struct load_result
+   {
+      std::string name;
+      std::size_t threads = 0;
+      std::uint64_t operations = 0;
+      double seconds = 0;
+      double ops_per_second = 0;
+      double items_per_second = 0;  // ops_per_second times the items per operation, e.g. rows
+      std::uint64_t p50 = 0;
+      std::uint64_t p90 = 0;
+      std::uint64_t p99 = 0;
+      std::uint64_t p999 = 0;
+      std::uint64_t max = 0;
+      double allocations_per_op = 0;
+      std::vector< std::pair< std::string, double > > metrics;  // added by the benchmark program
+   };
+
+   // difference of a candidate to a baseline benchmark
+   struct comparison
+   {
+      std::string name;
+      std::string baseline;
+      std::string candidate;
+      double overhead_ns = 0;
+      double overhead_cpu_ns = 0;
+      double overhead_allocations = 0;
+   };
+
+   // a stored result to detect regressions
+   struct baseline
+   {
+      double ns_per_op = 0;
+      double mad = 0;
+      double allocations_per_op = 0;
+   };
+
+   [[nodiscard]] inline auto median( std::vector< double > v ) -> double
+   {
+      if( v.empty() ) {
+         return 0;
+      }
+      std::sort( v.begin(), v.end() );
+      const auto n = v.size();
+      return ( n % 2 == 1 ) ? v[ n / 2 ] : ( v[ n / 2 - 1 ] + v[ n / 2 ] ) / 2;
+   }
+
+   // reads the "benchmarks" of the JSON output of a previous run, only the
+   // format written by runner::finish() is supported
+   [[nodiscard]] inline auto read_baselines( const std::string& filename ) -> std::map< std::string, baseline, std::less<> >
+   {
+      std::ifstream in( filename );
+      if( !in ) {
+         throw std::runtime_error( "unable to read baseline file: " + filename );
+      }
+      const auto number = []( const std::string& line, const std::string& key ) {
+         const auto pos = line.find( ",\"" + key + "\":" );
+         if( pos == std::string::npos ) {
+            throw std::runtime_error( "invalid baseline: " + line );
+         }
+         return std::strtod( line.c_str() + pos + key.size() + 4, nullptr );
+      };
+      std::map< std::string, baseline, std::less<> > nrv;
+      std::string line;
+      while( std::getline( in, line ) ) {
+         if( line.compare( 0, 3, "],\"" ) == 0 ) {
+            break;  // end of the "benchmarks"
+         }
+         if( line.compare( 0, 9, "{\"name\":\"" ) != 0 ) {
+            continue;
+         }
+         std::string name;
+         std::size_t pos = 9;
+         while( ( pos < line.size() ) && ( line[ pos ] != '"' ) ) {
+            if( ( line[ pos ] == '\\' ) && ( pos + 1 < line.size() ) ) {
+               ++pos;
+            }
+            name += line[ pos++ ];
+         }
+         nrv[ name ] = baseline{ number( line, "ns_per_op" ), number( line, "mad" ), number( line, "allocations_per_op" ) };
+      }
+      return nrv;
+   }
+
+   // usage: <program> [--json] [--filter=<substring>] [--samples=<n>] [--min-time=<ms>] [--duration=<ms>]
+   //                  [--baseline=<file>] [--tolerance=<fraction>] [--noise=<n>] [--retries=<n>] [--<option>=<value>...]
+   class runner
+   {
+   private:
+      bool m_json = false;
+      std::string m_filter;
+      std::size_t m_samples = 7;
+      std::chrono::nanoseconds m_min_time = std::chrono::milliseconds( 20 );
+      std::chrono::nanoseconds m_duration = std::chrono::seconds( 1 );
+      std::map< std::string, std::string, std::less<> > m_options;
+      std::vector< result > m_results;
+      std::vector< load_result > m_load_results;
+      std::vector< comparison > m_comparisons;
+      std::map< std::string, baseline, std::less<> > m_baselines;
+      double m_tolerance = 0.1;
+      double m_noise = 3;
+      std::size_t m_retries = 2;
+      std::vector< std::string > m_regressions;
+
+      template< typename F >
+      [[nodiscard]] static auto measure( F& f, const std::uint64_t iterations ) -> std::chrono::nanoseconds
+      {
+         const auto start = std::chrono::steady_clock::now();
+         for( std::uint64_t i = 0; i < iterations; ++i ) {
+            f();
+         }
+         return std::chrono::steady_clock::now() - start;
+      }
+
+      template< typename F >
+      [[nodiscard]] auto sample( const std::string& name, F& f, const std::uint64_t iterations ) const -> result
+      {
+         std::vector< double > samples;
+         samples.reserve( m_samples );
+         std::vector< double > cpu_samples;
+         cpu_samples.reserve( m_samples );
+         const auto before = allocations.load( std::memory_order_relaxed );
+         for( std::size_t i = 0; i < m_samples; ++i ) {
+            const auto cpu_start = std::clock();
+            samples.push_back( static_cast< double >( measure( f, iterations ).count() ) / static_cast< double >( iterations ) );
+            cpu_samples.push_back( static_cast< double >( std::clock() - cpu_start ) * ( 1e9 / CLOCKS_PER_SEC ) / static_cast< double >( iterations ) );
+         }
+         const auto after = allocations.load( std::memory_order_relaxed );
+
+         result r;
+         r.name = name;
+         r.iterations = iterations;
+         r.ns_per_op = median( samples );
+         r.cpu_ns_per_op = median( cpu_samples );
+         for( auto& s : samples ) {
+            s = std::fabs( s - r.ns_per_op );
+         }
+         r.mad = median( samples );
+         r.allocations_per_op = static_cast< double >( after - before ) / static_cast< double >( iterations * m_samples );
+         return r;
+      }
+
+      // a result is a regression if it is slower than the baseline by more
+      // than the tolerance plus the noise of both measurements and at least
+      // 1ns, or if it allocates more, returns an empty string otherwise
+      [[nodiscard]] auto regression( const result& r ) const -> std::string
+      {
+         const auto it = m_baselines.find( r.name );
+         if( it == m_baselines.end() ) {
+            return std::string();
+         }
+         const auto& b = it->second;
+         if( r.ns_per_op > b.ns_per_op + std::max( 1.0, b.ns_per_op * m_tolerance + m_noise * ( b.mad + r.mad ) ) ) {
+            return internal::printf( "%s: %.1f ns/op, baseline %.1f ns/op (%+.1f%%)", r.name.c_str(), r.ns_per_op, b.ns_per_op, 100 * ( r.ns_per_op / b.ns_per_op - 1 ) );
+         }
+         if( r.allocations_per_op > b.allocations_per_op + 0.01 ) {
+            return internal::printf( "%s: %.2f allocs/op, baseline %.2f allocs/op", r.name.c_str(), r.allocations_per_op, b.allocations_per_op );
+         }
+         return std::string();
+      }
+
+   public:
+      runner( const int argc, char** argv )
+      {
+         for( int i = 1; i < argc; ++i ) {
+            const std::string arg = argv[ i ];
+            if( arg == "--json" ) {
+               m_json = true;
+            }
+            else if( arg.compare( 0, 9, "--filter=" ) == 0 ) {
+               m_filter = arg.substr( 9 );
+            }
+            else if( arg.compare( 0, 10, "--samples=" ) == 0 ) {
+               m_samples = std::max( std::stoul( arg.substr( 10 ) ), 1UL );
+            }
+            else if( arg.compare( 0, 11, "--min-time=" ) == 0 ) {
+               m_min_time = std::chrono::milliseconds( std::stoul( arg.substr( 11 ) ) );
+            }
+            else if( arg.compare( 0, 11, "--duration=" ) == 0 ) {
+               m_duration = std::chrono::milliseconds( std::stoul( arg.substr( 11 ) ) );
+            }
+            else if( arg.compare( 0, 11, "--baseline=" ) == 0 ) {
+               m_baselines = read_baselines( arg.substr( 11 ) );
+            }
+            else if( arg.compare( 0, 12, "--tolerance=" ) == 0 ) {
+               m_tolerance = std::stod( arg.substr( 12 ) );
+            }
+            else if( arg.compare( 0, 8, "--noise=" ) == 0 ) {
+               m_noise = std::stod( arg.substr( 8 ) );
+            }
+            else if( arg.compare( 0, 10, "--retries=" ) == 0 ) {
+               m_retries = std::stoul( arg.substr( 10 ) );
+            }
+            else if( const auto pos = arg.find( '=' ); ( arg.compare( 0, 2, "--" ) == 0 ) && ( pos != std::string::npos ) && ( pos > 2 ) ) {
+               m_options[ arg.substr( 2, pos - 2 ) ] = arg.substr( pos + 1 );
+            }
+            else {
+               throw std::invalid_argument( "unknown argument: " + arg );
+            }
+         }
+      }
+
+      runner( const runner& ) = delete;
+      runner( runner&& ) = delete;
+      void operator=( const runner& ) = delete;
+      void operator=( runner&& ) = delete;
+
+      ~runner() = default;
+
+      [[nodiscard]] auto json() const noexcept -> bool
+      {
+         return m_json;
+      }
+
+      // program specific options, given as --<name>=<value>
+      [[nodiscard]] auto option( const std::string& name, const std::string& default_value ) const -> std::string
+      {
+         const auto it = m_options.find( name );
+         return ( it != m_options.end() ) ? it->second : default_value;
+      }
+
+      // a comma separated program specific option, e.g. --threads=1,2,4
+      [[nodiscard]] auto list_option( const std::string& name, const std::string& default_value ) const -> std::vector< std::string >
+      {
+         const auto list = option( name, default_value );
+         std::vector< std::string > nrv;
+         std::size_t pos = 0;
+         while( pos <= list.size() ) {
+            const auto end = std::min( list.find( ',', pos ), list.size() );
+            nrv.push_back( list.substr( pos, end - pos ) );
+            pos = end + 1;
+         }
+         return nrv;
+      }
+
+      // runs f repeatedly, f should pass its results to do_not_optimize()
+      template< typename F >
+      void run( const std::string& name, F&& f )
+      {
+         if( name.find( m_filter ) == std::string::npos ) {
+            return;
+         }
+
+         // warm up and find the number of iterations per sample
+         std::uint64_t iterations = 1;
+         while( true ) {
+            const auto elapsed = measure( f, iterations );
+            if( ( elapsed >= m_min_time ) || ( iterations >= ( std::uint64_t( 1 ) << 40 ) ) ) {
+               break;
+            }
+            const auto factor = ( elapsed.count() > 0 ) ? std::min( 10.0, 1.2 * static_cast< double >( m_min_time.count() ) / static_cast< double >( elapsed.count() ) ) : 10.0;
+            iterations = std::max( iterations + 1, static_cast< std::uint64_t >( static_cast< double >( iterations ) * factor ) );
+         }
+
+         auto r = sample( name, f, iterations );
+
+         // other load on the machine only makes a benchmark slower, a regression
+         // is therefore measured again and the fastest measurement is kept
+         auto message = regression( r );
+         for( std::size_t i = 0; ( i < m_retries ) && !message.empty(); ++i ) {
+            auto retry = sample( name, f, iterations );
+            if( retry.ns_per_op < r.ns_per_op ) {
+               r = std::move( retry );
+               message = regression( r );
+            }
+         }
+         if( !m_json ) {
+            std::cout << internal::printf( "%-60s %12.1f ns/op %8.1f mad %12.1f cpu ns/op %8.2f allocs/op\n", r.name.c_str(), r.ns_per_op, r.mad, r.cpu_ns_per_op, r.allocations_per_op ) << std::flush;
+         }
+         if( !message.empty() ) {
+            std::cerr << "regression: " << message << std::endl;
+            m_regressions.push_back( std::move( message ) );
+         }
+         m_results.push_back( std::move( r ) );
+      }
+
+      // runs make_worker( thread ) on each of the given number of threads, the
+      // returned worker is then called repeatedly for the configured duration,
+      // each call is one operation which processes items_per_op items
+      template< typename F >
+      void load( const std::string& name, const std::size_t threads, const std::size_t items_per_op, F&& make_worker )
+      {
+         load( name, threads, items_per_op, std::forward< F >( make_worker ), []( load_result& /*unused*/ ) {} );
+      }
+
+      // same as above, complete( result ) is called after the threads finished, e.g. to add metrics
+      template< typename F, typename G >
+      void load( const std::string& name, const std::size_t threads, const std::size_t items_per_op, F&& make_worker, G&& complete )
+      {
+         if( name.find( m_filter ) == std::string::npos ) {
+            return;
+         }
+
+         std::vector< internal::histogram > latencies( threads );
+         std::vector< std::exception_ptr > errors( threads );
+         std::atomic< std::size_t > ready{ 0 };
+         std::atomic< bool > started{ false };
+         std::atomic< bool > stopped{ false };
+
+         std::vector< std::thread > workers;
+         workers.reserve( threads );
+         for( std::size_t i = 0; i < threads; ++i ) {
+            workers.emplace_back( [ &, i ] {
+               try {
+                  auto worker = make_worker( i );
+                  ready.fetch_add( 1 );
+                  while( !started.load() ) {
+                     std::this_thread::yield();
+                  }
+                  while( !stopped.load( std::memory_order_relaxed ) ) {
+                     const auto start = std::chrono::steady_clock::now();
+                     worker();
+                     latencies[ i ].record( static_cast< std::uint64_t >( std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now() - start ).count() ) );
+                  }
+               }
+               catch( ... ) {
+                  errors[ i ] = std::current_exception();
+                  ready.fetch_add( 1 );
+                  stopped.store( true );
+               }
+            } );
+         }
+
+         while( ready.load() < threads ) {
+            std::this_thread::yield();
+         }
+         const auto before = allocations.load( std::memory_order_relaxed );
+         const auto start = std::chrono::steady_clock::now();
+         started.store( true );
+         while( !stopped.load() && ( std::chrono::steady_clock::now() - start < m_duration ) ) {
+            std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+         }
+         stopped.store( true );
+         for( auto& t : workers ) {
+            t.join();
+         }
+         const auto elapsed = std::chrono::steady_clock::now() - start;
+         const auto after = allocations.load( std::memory_order_relaxed );
+         for( const auto& e : errors ) {
+            if( e ) {
+               std::rethrow_exception( e );
+            }
+         }
+
+         internal::histogram_snapshot total;
+         for( const auto& h : latencies ) {
+            total += h.snapshot();
+         }
+
+         load_result r;
+         r.name = name;
+         r.threads = threads;
+         r.operations = total.count();
+         r.seconds = std::chrono::duration< double >( elapsed ).count();
+         r.ops_per_second = static_cast< double >( r.operations ) / r.seconds;
+         r.items_per_second = r.ops_per_second * static_cast< double >( items_per_op );
+         r.p50 = total.percentile( 0.5 );
+         r.p90 = total.percentile( 0.9 );
+         r.p99 = total.percentile( 0.99 );
+         r.p999 = total.percentile( 0.999 );
+         r.max = total.max();
+         r.allocations_per_op = ( r.operations != 0 ) ? ( static_cast< double >( after - before ) / static_cast< double >( r.operations ) ) : 0;
+         complete( r );
+         if( !m_json ) {
+            std::string line = internal::printf( "%-40s %3zu threads %12.0f ops/s %10.1f us p50 %10.1f us p99 %10.1f us max %8.2f allocs/op", r.name.c_str(), r.threads, r.ops_per_second, static_cast< double >( r.p50 ) / 1000, static_cast< double >( r.p99 ) / 1000, static_cast< double >( r.max ) / 1000, r.allocations_per_op );
+            for( const auto& [ key, value ] : r.metrics ) {
+               line += internal::printf( " %s=%.0f", key.c_str(), value );
+            }
+            std::cout << line << std::endl;
+         }
+         m_load_results.push_back( std::move( r ) );
+      }
+
+      // compares the results of two benchmarks that were run before, does nothing if one was filtered out
+      void compare( const std::string& name, const std::string& baseline, const std::string& candidate )
+      {
+         const auto find = [ this ]( const std::string& n ) -> const result* {
+            for( const auto& r : m_results ) {
+               if( r.name == n ) {
+                  return &r;
+               }
+            }
+            return nullptr;
+         };
+         const auto* b = find( baseline );
+         const auto* c = find( candidate );
+         if( ( b == nullptr ) || ( c == nullptr ) ) {
+            return;
+         }
+         comparison r;
+         r.name = name;
+         r.baseline = baseline;
+         r.candidate = candidate;
+         r.overhead_ns = c->ns_per_op - b->ns_per_op;
+         r.overhead_cpu_ns = c->cpu_ns_per_op - b->cpu_ns_per_op;
+         r.overhead_allocations = c->allocations_per_op - b->allocations_per_op;
+         if( !m_json ) {
+            std::cout << internal::printf( "%-60s %+12.1f ns/op %+21.1f cpu ns/op %+8.2f allocs/op overhead\n", r.name.c_str(), r.overhead_ns, r.overhead_cpu_ns, r.overhead_allocations ) << std::flush;
+         }
+         m_comparisons.push_back( std::move( r ) );
+      }
+
+      [[nodiscard]] auto results() const noexcept -> const std::vector< result >&
+      {
+         return m_results;
+      }
+
+      [[nodiscard]] auto load_results() const noexcept -> const std::vector< load_result >&
+      {
+         return m_load_results;
+      }
+
+      [[nodiscard]] auto comparisons() const noexcept -> const std::vector< comparison >&
+      {
+         return m_comparisons;
+      }
+
+      // the results that are slower than their baseline, given with --baseline
+      [[nodiscard]] auto regressions() const noexcept -> const std::vector< std::string >&
+      {
+         return m_regressions;
+      }
+
+      // prints the results in JSON format, if requested
+      void finish() const
+      {
+         if( !m_json ) {
+            return;
+         }
+         std::string out = "{\"benchmarks\":[";
+         for( const auto& r : m_results ) {
+            if( &r != &m_results.front() ) {
+               out += ',';
+            }
+            out += "\n{\"name\":";
+            internal::json_string( out, r.name );
+            out += internal::printf( ",\"iterations\":%llu,\"ns_per_op\":%.3f,\"mad\":%.3f,\"cpu_ns_per_op\":%.3f,\"allocations_per_op\":%.3f}", static_cast< unsigned long long >( r.iterations ), r.ns_per_op, r.mad, r.cpu_ns_per_op, r.allocations_per_op );
+         }
+         out += "\n]";
+         if( !m_load_results.empty() ) {
+            out += ",\"load\":[";
+            for( const auto& r : m_load_results ) {
+               if( &r != &m_load_results.front() ) {
+                  out += ',';
+               }
+               out += "\n{\"name\":";
+               internal::json_string( out, r.name );
+               out += internal::printf( ",\"threads\":%zu,\"operations\":%llu,\"seconds\":%.3f,\"ops_per_second\":%.1f,\"items_per_second\":%.1f", r.threads, static_cast< unsigned long long >( r.operations ), r.seconds, r.ops_per_second, r.items_per_second );
+               out += internal::printf( ",\"latency_ns\":{\"p50\":%llu,\"p90\":%llu,\"p99\":%llu,\"p999\":%llu,\"max\":%llu}", static_cast< unsigned long long >( r.p50 ), static_cast< unsigned long long >( r.p90 ), static_cast< unsigned long long >( r.p99 ), static_cast< unsigned long long >( r.p999 ), static_cast< unsigned long long >( r.max ) );
+               out += internal::printf( ",\"allocations_per_op\":%.3f", r.allocations_per_op );
+               if( !r.metrics.empty() ) {
+                  out += ",\"metrics\":{";
+                  for( const auto& [ key, value ] : r.metrics ) {
+                     if( &key != &r.metrics.front().first ) {
+                        out += ',';
+                     }
+                     internal::json_string( out, key );
+                     out += internal::printf( ":%.3f", value );
+                  }
+                  out += '}';
+               }
+               out += '}';
+            }
+            out += "\n]";
+         }
+         if( !m_comparisons.empty() ) {
+            out += ",\"comparisons\":[";
+            for( const auto& r : m_comparisons ) {
+               if( &r != &m_comparisons.front() ) {
+                  out += ',';
+               }
+               out += "\n{\"name\":";
+               internal::json_string( out, r.name );
+               out += ",\"baseline\":";
+               internal::json_string( out, r.baseline );
+               out += ",\"candidate\":";
+               internal::json_string( out, r.candidate );
+               out += internal::printf( ",\"overhead_ns\":%.3f,\"overhead_cpu_ns\":%.3f,\"overhead_allocations\":%.3f}", r.overhead_ns, r.overhead_cpu_ns, r.overhead_allocations );
+            }
+            out += "\n]";
+         }
+         out += "}\n";
+         std::cout << out;
+      }
+   };
+
+   // common main() for benchmark programs, calls register_benchmarks( runner& )
+   template< typename F >
+   auto main( const int argc, char** argv, F&& register_benchmarks ) -> int
+   {
+      try {
+         runner r( argc, argv );
+         register_benchmarks( r );
+         r.finish();
+         if( !r.regressions().empty() ) {
+            std::cerr << r.regressions().size() << " regression(s) compared to the baseline" << std::endl;
+            return 1;
+         }
+         return 0;
+      }
+      catch( const std::exception& e ) {
+         std::cerr << "exception: " << e.what() << std::endl;
+      }
+      catch( ... ) {
+         std::cerr << "unknown exception" << std::endl;
+      }
+      return 1;
+   }
+
+}  // namespace tao::pq::bench
+
+#endif
@@ -0,0 +1,63 @@
+#!/bin/sh
+# Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+# Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+# Runs a command against a temporary PostgreSQL server, e.g.
+#
+#   src/bench/postgres.sh build/src/bench/pq/taopq-bench-end_to_end --json
+#
+# The server is initialised in a fresh data directory and only listens on a
+# Unix domain socket in that directory, it is stopped and removed afterwards.
+# The connection string is passed in TAOPQ_BENCHMARK_DATABASE (and also in
+# TAOPQ_TEST_DATABASE, so the tests can be run the same way).
+#
+# Durability is switched off, the numbers are meant to show the costs on the
+# client and the server, not those of the disk. The binaries are taken from
+# PG_BINDIR, from pg_config, or from PATH, in that order.
+
+set -eu
+
+if [ $# -eq 0 ]; then
+   echo "usage: $0 <command> [<arguments>...]" >&2
+   exit 2
+fi
+
+if [ -z "${PG_BINDIR:-}" ] && command -v pg_config >/dev/null 2>&1; then
+   PG_BINDIR=$(pg_config --bindir)
+fi
+if [ -n "${PG_BINDIR:-}" ]; then
+   PATH="$PG_BINDIR:$PATH"
+fi
+
+for tool in initdb pg_ctl; do
+   if ! command -v $tool >/dev/null 2>&1; then
+      echo "$0: $tool not found, set PG_BINDIR" >&2
+      exit 1
+   fi
+done
+
+DATADIR=$(mktemp -d "${TMPDIR:-/tmp}/taopq-bench.XXXXXX")
+PORT=${TAOPQ_BENCHMARK_PORT:-54329}
+
+cleanup() {
+   pg_ctl -D "$DATADIR/data" -m immediate stop >/dev/null 2>&1 || true
+   rm -rf "$DATADIR"
+}
+trap cleanup EXIT
+trap 'exit 1' INT TERM
+
+initdb -D "$DATADIR/data" -U postgres -A trust -E UTF8 --locale=C --no-sync >"$DATADIR/initdb.log" 2>&1 || {
+   cat "$DATADIR/initdb.log" >&2
+   exit 1
+}
+
+pg_ctl -D "$DATADIR/data" -l "$DATADIR/server.log" -w -o "-k $DATADIR -p $PORT -c listen_addresses= -c fsync=off -c synchronous_commit=off -c full_page_writes=off -c max_connections=200" start >/dev/null || {
+   cat "$DATADIR/server.log" >&2
+   exit 1
+}
+
+TAOPQ_BENCHMARK_DATABASE="host=$DATADIR port=$PORT user=postgres dbname=postgres"
+TAOPQ_TEST_DATABASE=$TAOPQ_BENCHMARK_DATABASE
+export TAOPQ_BENCHMARK_DATABASE TAOPQ_TEST_DATABASE
+
+"$@"
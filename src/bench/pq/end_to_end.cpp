@@ -0,0 +1,215 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include "../../test/getenv.hpp"
+#include "../bench.hpp"
+
+#include <cstddef>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <tao/pq.hpp>
+#include <tao/pq/connection_pool.hpp>
+#include <tao/pq/lookup_batcher.hpp>
+#include <tao/pq/multiplexer.hpp>
+#include <tao/pq/table_writer.hpp>
+
+// usage: taopq-bench-end_to_end [--database=<connection string>] [--threads=<n>,...] [--table-rows=<n>]
+//                               [--statements=<n>] [--copy-rows=<n>] [<common arguments>]
+//
+// requires a server, see src/bench/postgres.sh to run it against a temporary one
+
+namespace
+{
+   using tao::pq::bench::do_not_optimize;
+
+   const char* const select_statement = "SELECT a, b FROM taopq_bench_select WHERE id = $1";
+   const char* const insert_statement = "INSERT INTO taopq_bench_insert ( a, b ) VALUES ( $1, $2 )";
+
+   struct options
+   {
+      std::string database;
+      std::vector< std::size_t > threads;
+      int table_rows = 0;
+      std::size_t statements = 0;
+      std::size_t copy_rows = 0;
+   };
+
+   void setup( tao::pq::connection& c, const options& o )
+   {
+      c.execute( "DROP TABLE IF EXISTS taopq_bench_select" );
+      c.execute( "CREATE TABLE taopq_bench_select ( id INTEGER PRIMARY KEY, a INTEGER NOT NULL, b TEXT NOT NULL )" );
+      c.execute( "DROP TABLE IF EXISTS taopq_bench_insert" );
+      c.execute( "CREATE TABLE taopq_bench_insert ( id BIGSERIAL PRIMARY KEY, a INTEGER NOT NULL, b TEXT NOT NULL )" );
+
+      const auto tr = c.transaction();
+      tao::pq::table_writer tw( tr, "COPY taopq_bench_select ( id, a, b ) FROM STDIN" );
+      for( int i = 1; i <= o.table_rows; ++i ) {
+         tw.insert( std::to_string( i ) + '\t' + std::to_string( i * 7 ) + "\tvalue " + std::to_string( i ) + '\n' );
+      }
+      tw.finish();
+      tr->commit();
+      c.execute( "ANALYZE taopq_bench_select" );
+   }
+
+   void teardown( tao::pq::connection& c )
+   {
+      c.execute( "DROP TABLE taopq_bench_insert" );
+      c.execute( "DROP TABLE taopq_bench_select" );
+   }
+
+   // runs a workload for each thread count, each run uses a new pool so that
+   // prepared statements and connections do not leak from one run into the next
+   template< typename F >
+   void workload( tao::pq::bench::runner& r, const options& o, const std::string& name, const std::size_t items_per_op, const F& f )
+   {
+      for( const auto threads : o.threads ) {
+         const auto pool = tao::pq::connection_pool::create( o.database );
+         r.load( name, threads, items_per_op, [ & ]( const std::size_t thread ) {
+            return f( *pool, std::make_shared< std::mt19937 >( static_cast< std::mt19937::result_type >( thread ) ) );
+         } );
+      }
+   }
+
+   void select( tao::pq::bench::runner& r, const options& o )
+   {
+      const auto make_id = [ & ]( std::mt19937& rng ) {
+         return std::uniform_int_distribution< int >( 1, o.table_rows )( rng );
+      };
+
+      workload( r, o, "select/unprepared/text", 1, [ & ]( tao::pq::connection_pool& pool, const std::shared_ptr< std::mt19937 >& rng ) {
+         const auto c = pool.connection();
+         return [ =, &make_id ] { do_not_optimize( c->execute( select_statement, make_id( *rng ) ).tuple< int, std::string >() ); };
+      } );
+      workload( r, o, "select/unprepared/binary", 1, [ & ]( tao::pq::connection_pool& pool, const std::shared_ptr< std::mt19937 >& rng ) {
+         const auto c = pool.connection();
+         return [ =, &make_id ] { do_not_optimize( c->execute< tao::pq::parameter_binary_traits >( select_statement, make_id( *rng ) ).tuple< int, std::string >() ); };
+      } );
+      workload( r, o, "select/prepared/text", 1, [ & ]( tao::pq::connection_pool& pool, const std::shared_ptr< std::mt19937 >& rng ) {
+         const auto c = pool.connection();
+         c->prepare( "select", select_statement );
+         return [ =, &make_id ] { do_not_optimize( c->execute( "select", make_id( *rng ) ).tuple< int, std::string >() ); };
+      } );
+      workload( r, o, "select/prepared/binary", 1, [ & ]( tao::pq::connection_pool& pool, const std::shared_ptr< std::mt19937 >& rng ) {
+         const auto c = pool.connection();
+         c->prepare( "select", select_statement );
+         return [ =, &make_id ] { do_not_optimize( c->execute< tao::pq::parameter_binary_traits >( "select", make_id( *rng ) ).tuple< int, std::string >() ); };
+      } );
+
+      // checks out a connection from the pool for each statement
+      workload( r, o, "select/pool", 1, [ & ]( tao::pq::connection_pool& pool, const std::shared_ptr< std::mt19937 >& rng ) {
+         return [ =, &pool, &make_id ] { do_not_optimize( pool.execute( select_statement, make_id( *rng ) ).tuple< int, std::string >() ); };
+      } );
+
+#if defined( LIBPQ_HAS_PIPELINING )
+      // all threads share a single pipelined connection
+      for( const auto threads : o.threads ) {
+         const auto multiplexer = tao::pq::multiplexer::create( o.database );
+         multiplexer->prepare( "select", select_statement );
+         r.load( "select/multiplexer", threads, 1, [ & ]( const std::size_t thread ) {
+            const auto rng = std::make_shared< std::mt19937 >( static_cast< std::mt19937::result_type >( thread ) );
+            return [ =, &multiplexer, &make_id ] { do_not_optimize( multiplexer->execute( "select", make_id( *rng ) ).get().tuple< int, std::string >() ); };
+         } );
+      }
+#endif
+
+      // concurrent lookups are collected into batches of "id = ANY( $1 )"
+      for( const auto threads : o.threads ) {
+         const auto pool = tao::pq::connection_pool::create( o.database );
+         const auto batcher = tao::pq::lookup_batcher< int, std::tuple< int, std::string > >::create( pool, "SELECT id, a, b FROM taopq_bench_select WHERE id = ANY( $1 )" );
+         r.load( "select/batched", threads, 1, [ & ]( const std::size_t thread ) {
+            const auto rng = std::make_shared< std::mt19937 >( static_cast< std::mt19937::result_type >( thread ) );
+            return [ =, &batcher, &make_id ] { do_not_optimize( batcher->get( make_id( *rng ) ) ); };
+         } );
+      }
+
+      const std::string prefix = "transaction/" + std::to_string( o.statements ) + "/select";
+      workload( r, o, prefix, o.statements, [ & ]( tao::pq::connection_pool& pool, const std::shared_ptr< std::mt19937 >& rng ) {
+         const auto c = pool.connection();
+         c->prepare( "select", select_statement );
+         return [ =, &o, &make_id ] {
+            const auto tr = c->transaction();
+            for( std::size_t i = 0; i < o.statements; ++i ) {
+               do_not_optimize( tr->execute( "select", make_id( *rng ) ).tuple< int, std::string >() );
+            }
+            tr->commit();
+         };
+      } );
+   }
+
+   void insert( tao::pq::bench::runner& r, const options& o )
+   {
+      const std::string b = "inserted value";
+
+      workload( r, o, "insert/unprepared", 1, [ & ]( tao::pq::connection_pool& pool, const std::shared_ptr< std::mt19937 >& rng ) {
+         const auto c = pool.connection();
+         return [ =, &b ] { do_not_optimize( c->execute( insert_statement, static_cast< int >( ( *rng )() ), b ).rows_affected() ); };
+      } );
+      workload( r, o, "insert/prepared", 1, [ & ]( tao::pq::connection_pool& pool, const std::shared_ptr< std::mt19937 >& rng ) {
+         const auto c = pool.connection();
+         c->prepare( "insert", insert_statement );
+         return [ =, &b ] { do_not_optimize( c->execute( "insert", static_cast< int >( ( *rng )() ), b ).rows_affected() ); };
+      } );
+
+      const std::string prefix = "transaction/" + std::to_string( o.statements ) + "/insert";
+      workload( r, o, prefix, o.statements, [ & ]( tao::pq::connection_pool& pool, const std::shared_ptr< std::mt19937 >& rng ) {
+         const auto c = pool.connection();
+         c->prepare( "insert", insert_statement );
+         return [ =, &o, &b ] {
+            const auto tr = c->transaction();
+            for( std::size_t i = 0; i < o.statements; ++i ) {
+               do_not_optimize( tr->execute( "insert", static_cast< int >( ( *rng )() ), b ).rows_affected() );
+            }
+            tr->commit();
+         };
+      } );
+
+      workload( r, o, "copy/" + std::to_string( o.copy_rows ), o.copy_rows, [ & ]( tao::pq::connection_pool& pool, const std::shared_ptr< std::mt19937 >& rng ) {
+         const auto c = pool.connection();
+         return [ =, &o ] {
+            const auto tr = c->transaction();
+            tao::pq::table_writer tw( tr, "COPY taopq_bench_insert ( a, b ) FROM STDIN" );
+            for( std::size_t i = 0; i < o.copy_rows; ++i ) {
+               tw.insert( std::to_string( static_cast< int >( ( *rng )() ) ) + "\tcopied value\n" );
+            }
+            do_not_optimize( tw.finish() );
+            tr->commit();
+         };
+      } );
+   }
+
+}  // namespace
+
+auto main( int argc, char** argv ) -> int
+{
+   return tao::pq::bench::main( argc, argv, []( tao::pq::bench::runner& r ) {
+      options o;
+      o.database = r.option( "database", tao::pq::internal::getenv( "TAOPQ_BENCHMARK_DATABASE", "dbname=postgres" ) );
+      for( const auto& t : r.list_option( "threads", "1,2,4,8" ) ) {
+         o.threads.push_back( std::stoul( t ) );
+      }
+      o.table_rows = std::stoi( r.option( "table-rows", "10000" ) );
+      o.statements = std::stoul( r.option( "statements", "10" ) );
+      o.copy_rows = std::stoul( r.option( "copy-rows", "1000" ) );
+
+      std::shared_ptr< tao::pq::connection > c;
+      try {
+         c = tao::pq::connection::create( o.database );
+      }
+      catch( const std::exception& e ) {
+         // allows running all benchmarks without a server
+         std::cerr << "skipping end-to-end benchmarks, no server: " << e.what() << std::endl;
+         return;
+      }
+
+      setup( *c, o );
+      select( r, o );
+      insert( r, o );
+      teardown( *c );
+   } );
+}
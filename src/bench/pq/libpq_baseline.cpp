@@ -0,0 +1,156 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include "../../test/getenv.hpp"
+#include "../bench.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <libpq-fe.h>
+
+#include <tao/pq.hpp>
+
+// usage: taopq-bench-libpq_baseline [--database=<connection string>] [--rows=<n>] [<common arguments>]
+//
+// requires a server, see src/bench/postgres.sh to run it against a temporary one
+
+namespace
+{
+   using tao::pq::bench::do_not_optimize;
+
+   const char* const select_statement = "SELECT $1::INTEGER";
+   const char* const series_statement = "SELECT * FROM generate_series( $1::INTEGER, $2::INTEGER )";
+
+   // hand-written libpq code, as an application without a wrapper would use it
+   class raw
+   {
+   private:
+      PGconn* m_pgconn;
+
+      [[nodiscard]] static auto check( PGresult* r, const ExecStatusType expected ) -> PGresult*
+      {
+         if( PQresultStatus( r ) != expected ) {
+            const std::string message = PQresultErrorMessage( r );
+            PQclear( r );
+            throw std::runtime_error( "libpq: " + message );
+         }
+         return r;
+      }
+
+   public:
+      explicit raw( PGconn* pgconn ) noexcept
+         : m_pgconn( pgconn )
+      {}
+
+      void prepare( const char* name, const char* statement, const int n_params )
+      {
+         PQclear( check( PQprepare( m_pgconn, name, statement, n_params, nullptr ), PGRES_COMMAND_OK ) );
+      }
+
+      void command( const char* statement )
+      {
+         PQclear( check( PQexec( m_pgconn, statement ), PGRES_COMMAND_OK ) );
+      }
+
+      [[nodiscard]] auto select( const bool prepared, const int value ) -> int
+      {
+         char buffer[ 16 ];
+         std::snprintf( buffer, sizeof( buffer ), "%d", value );
+         const char* const values[] = { buffer };
+         PGresult* r = check( prepared ? PQexecPrepared( m_pgconn, "select", 1, values, nullptr, nullptr, 0 )
+                                       : PQexecParams( m_pgconn, select_statement, 1, nullptr, values, nullptr, nullptr, 0 ),
+                              PGRES_TUPLES_OK );
+         const int nrv = std::atoi( PQgetvalue( r, 0, 0 ) );
+         PQclear( r );
+         return nrv;
+      }
+
+      [[nodiscard]] auto series( const int from, const int to ) -> std::vector< int >
+      {
+         char buffer[ 2 ][ 16 ];
+         std::snprintf( buffer[ 0 ], sizeof( buffer[ 0 ] ), "%d", from );
+         std::snprintf( buffer[ 1 ], sizeof( buffer[ 1 ] ), "%d", to );
+         const char* const values[] = { buffer[ 0 ], buffer[ 1 ] };
+         PGresult* r = check( PQexecParams( m_pgconn, series_statement, 2, nullptr, values, nullptr, nullptr, 0 ), PGRES_TUPLES_OK );
+         std::vector< int > nrv;
+         const int rows = PQntuples( r );
+         nrv.reserve( rows );
+         for( int row = 0; row < rows; ++row ) {
+            nrv.push_back( std::atoi( PQgetvalue( r, row, 0 ) ) );
+         }
+         PQclear( r );
+         return nrv;
+      }
+   };
+
+   void compare( tao::pq::bench::runner& r, const std::string& name )
+   {
+      r.compare( name, "libpq/" + name, "taopq/" + name );
+   }
+
+}  // namespace
+
+auto main( int argc, char** argv ) -> int
+{
+   return tao::pq::bench::main( argc, argv, []( tao::pq::bench::runner& r ) {
+      const auto database = r.option( "database", tao::pq::internal::getenv( "TAOPQ_BENCHMARK_DATABASE", "dbname=postgres" ) );
+      const auto rows = std::stoi( r.option( "rows", "100" ) );
+
+      std::shared_ptr< tao::pq::connection > connection;
+      try {
+         connection = tao::pq::connection::create( database );
+      }
+      catch( const std::exception& e ) {
+         // allows running all benchmarks without a server
+         std::cerr << "skipping libpq baseline benchmarks, no server: " << e.what() << std::endl;
+         return;
+      }
+
+      // a separate connection, both are set up the same way
+      const std::unique_ptr< PGconn, decltype( &PQfinish ) > pgconn( PQconnectdb( database.c_str() ), &PQfinish );
+      if( PQstatus( pgconn.get() ) != CONNECTION_OK ) {
+         throw std::runtime_error( std::string( "libpq: " ) + PQerrorMessage( pgconn.get() ) );
+      }
+      raw libpq( pgconn.get() );
+
+      connection->prepare( "select", select_statement );
+      libpq.prepare( "select", select_statement, 1 );
+
+      int i = 0;
+      r.run( "libpq/select/unprepared", [ & ] { do_not_optimize( libpq.select( false, ++i ) ); } );
+      r.run( "taopq/select/unprepared", [ & ] { do_not_optimize( connection->execute( select_statement, ++i ).as< int >() ); } );
+      compare( r, "select/unprepared" );
+
+      r.run( "libpq/select/prepared", [ & ] { do_not_optimize( libpq.select( true, ++i ) ); } );
+      r.run( "taopq/select/prepared", [ & ] { do_not_optimize( connection->execute( "select", ++i ).as< int >() ); } );
+      compare( r, "select/prepared" );
+
+      r.run( "libpq/transaction/3", [ & ] {
+         libpq.command( "BEGIN" );
+         do_not_optimize( libpq.select( true, ++i ) );
+         do_not_optimize( libpq.select( true, ++i ) );
+         do_not_optimize( libpq.select( true, ++i ) );
+         libpq.command( "COMMIT" );
+      } );
+      r.run( "taopq/transaction/3", [ & ] {
+         const auto tr = connection->transaction();
+         do_not_optimize( tr->execute( "select", ++i ).as< int >() );
+         do_not_optimize( tr->execute( "select", ++i ).as< int >() );
+         do_not_optimize( tr->execute( "select", ++i ).as< int >() );
+         tr->commit();
+      } );
+      compare( r, "transaction/3" );
+
+      const std::string vector = "vector/" + std::to_string( rows );
+      r.run( "libpq/" + vector, [ & ] { do_not_optimize( libpq.series( 1, rows ) ); } );
+      r.run( "taopq/" + vector, [ & ] { do_not_optimize( connection->execute( series_statement, 1, rows ).vector< int >() ); } );
+      compare( r, vector );
+   } );
+}
@@ -0,0 +1,150 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include "../bench.hpp"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <libpq-fe.h>
+
+#include <tao/pq/internal/gen.hpp>
+#include <tao/pq/null.hpp>
+#include <tao/pq/parameter_traits.hpp>
+
+namespace
+{
+   using tao::pq::bench::do_not_optimize;
+
+   template< typename T >
+   void consume( const T& traits )
+   {
+      do_not_optimize( traits.template type< 0 >() );
+      do_not_optimize( traits.template value< 0 >() );
+      do_not_optimize( traits.template length< 0 >() );
+      do_not_optimize( traits.template format< 0 >() );
+   }
+
+   template< template< typename... > class Traits, typename T >
+   void single( tao::pq::bench::runner& r, const std::string& name, const T& v )
+   {
+      r.run( name, [ & ] {
+         const Traits< T > traits( v );
+         consume( traits );
+      } );
+   }
+
+   template< typename T >
+   void both( tao::pq::bench::runner& r, const std::string& type, const T& v )
+   {
+      single< tao::pq::parameter_text_traits >( r, "text/" + type, v );
+      single< tao::pq::parameter_binary_traits >( r, "binary/" + type, v );
+   }
+
+   // same as transaction::execute_indexed() builds for PQsendQueryParams()
+   template< std::size_t... Os, std::size_t... Is, typename... Ts >
+   void build_indexed( std::index_sequence< Os... > /*unused*/, std::index_sequence< Is... > /*unused*/, const std::tuple< Ts... >& tuple )
+   {
+      const Oid types[] = { std::get< Os >( tuple ).template type< Is >()... };
+      const char* const values[] = { std::get< Os >( tuple ).template value< Is >()... };
+      const int lengths[] = { std::get< Os >( tuple ).template length< Is >()... };
+      const int formats[] = { std::get< Os >( tuple ).template format< Is >()... };
+      do_not_optimize( types );
+      do_not_optimize( values );
+      do_not_optimize( lengths );
+      do_not_optimize( formats );
+   }
+
+   template< typename... Ts >
+   void build_traits( const Ts&... ts )
+   {
+      using gen = tao::pq::internal::gen< Ts::columns... >;
+      build_indexed( typename gen::outer_sequence(), typename gen::inner_sequence(), std::tie( ts... ) );
+   }
+
+   template< template< typename... > class Traits, typename... As >
+   void build( const As&... as )
+   {
+      build_traits( Traits< As >( as )... );
+   }
+
+   template< template< typename... > class Traits >
+   void indexed( tao::pq::bench::runner& r, const std::string& prefix )
+   {
+      const std::string s = "a short string";
+      const std::optional< int > o = 42;
+      r.run( prefix + "1", [ & ] { build< Traits >( 42 ); } );
+      r.run( prefix + "4", [ & ] { build< Traits >( 42, 3.14, s, o ); } );
+      r.run( prefix + "16", [ & ] { build< Traits >( 1, 2LL, 3.0, s, o, true, 'c', 8, 9, 10.0, s, o, false, 14LL, 15, 16.0f ); } );
+   }
+
+   template< template< typename... > class Traits >
+   void optional( tao::pq::bench::runner& r, const std::string& prefix )
+   {
+      const std::optional< int > engaged = 42;
+      const std::optional< int > empty;
+      const std::optional< std::string > engaged_string = "a short string";
+      single< Traits >( r, prefix + "optional<int>/engaged", engaged );
+      single< Traits >( r, prefix + "optional<int>/empty", empty );
+      single< Traits >( r, prefix + "optional<string>/engaged", engaged_string );
+      single< Traits >( r, prefix + "null", tao::pq::null );
+   }
+
+   void bytea( tao::pq::bench::runner& r )
+   {
+      // PQescapeByteaConn() only needs the connection's settings, a failed
+      // connection provides the defaults without requiring a server
+      const std::unique_ptr< PGconn, decltype( &PQfinish ) > c( PQconnectdb( "host=/nonexistent/taopq-bench connect_timeout=1" ), &PQfinish );
+      for( const std::size_t size : { 16, 1024, 65536 } ) {
+         std::vector< unsigned char > data( size );
+         for( std::size_t i = 0; i < size; ++i ) {
+            data[ i ] = static_cast< unsigned char >( i * 31 );
+         }
+         const tao::span< const unsigned char > v( data.data(), data.size() );
+         r.run( "text/bytea/" + std::to_string( size ), [ & ] {
+            const tao::pq::parameter_text_traits< tao::span< const unsigned char > > traits( c.get(), v );
+            consume( traits );
+         } );
+         single< tao::pq::parameter_binary_traits >( r, "binary/bytea/" + std::to_string( size ), v );
+      }
+   }
+
+}  // namespace
+
+auto main( int argc, char** argv ) -> int
+{
+   return tao::pq::bench::main( argc, argv, []( tao::pq::bench::runner& r ) {
+      both( r, "bool", true );
+      both( r, "char", 'x' );
+      both( r, "short", short( -12345 ) );
+      both( r, "int", -1234567890 );
+      both( r, "long", -1234567890L );
+      both( r, "long long", -1234567890123456789LL );
+      both( r, "float", 3.1415927f );
+      both( r, "double", 3.141592653589793 );
+      both( r, "const char*", static_cast< const char* >( "a short string" ) );
+      both( r, "string/16", std::string( 16, 'x' ) );
+      both( r, "string/1024", std::string( 1024, 'x' ) );
+
+      // only supported as text
+      single< tao::pq::parameter_text_traits >( r, "text/signed char", static_cast< signed char >( -123 ) );
+      single< tao::pq::parameter_text_traits >( r, "text/unsigned char", static_cast< unsigned char >( 234 ) );
+      single< tao::pq::parameter_text_traits >( r, "text/unsigned short", static_cast< unsigned short >( 54321 ) );
+      single< tao::pq::parameter_text_traits >( r, "text/unsigned", 3234567890U );
+      single< tao::pq::parameter_text_traits >( r, "text/unsigned long", 3234567890UL );
+      single< tao::pq::parameter_text_traits >( r, "text/unsigned long long", 12345678901234567890ULL );
+      single< tao::pq::parameter_text_traits >( r, "text/long double", 3.14159265358979323846L );
+
+      optional< tao::pq::parameter_text_traits >( r, "text/" );
+      optional< tao::pq::parameter_binary_traits >( r, "binary/" );
+
+      bytea( r );
+
+      indexed< tao::pq::parameter_text_traits >( r, "text/execute_indexed/" );
+      indexed< tao::pq::parameter_binary_traits >( r, "binary/execute_indexed/" );
+   } );
+}
@@ -0,0 +1,179 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include "../bench.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <tao/pq/internal/histogram.hpp>
+#include <tao/pq/internal/pool.hpp>
+
+// usage: taopq-bench-pool_contention [--threads=<n>,...] [--hold=<ns>,...] [--pool-sizes=<factor>,...] [--lock-stats=1] [<common arguments>]
+
+namespace
+{
+   using clock = std::chrono::steady_clock;
+
+   [[nodiscard]] auto nanoseconds( const clock::duration d ) noexcept -> std::uint64_t
+   {
+      return static_cast< std::uint64_t >( std::chrono::duration_cast< std::chrono::nanoseconds >( d ).count() );
+   }
+
+   struct lock_stats
+   {
+      tao::pq::internal::histogram wait;  // in nanoseconds
+      tao::pq::internal::histogram hold;  // in nanoseconds
+   };
+
+   // records how long the lock is waited for and held, the times are only
+   // written while the lock is held
+   class instrumented_mutex
+   {
+   private:
+      std::mutex m_mutex;
+      clock::time_point m_acquired;
+
+   public:
+      inline static lock_stats* stats = nullptr;
+
+      void lock()
+      {
+         const auto start = clock::now();
+         m_mutex.lock();
+         m_acquired = clock::now();
+         stats->wait.record( nanoseconds( m_acquired - start ) );
+      }
+
+      void unlock()
+      {
+         stats->hold.record( nanoseconds( clock::now() - m_acquired ) );
+         m_mutex.unlock();
+      }
+   };
+
+   struct item
+   {
+      bool retained;
+   };
+
+   // the first size items are kept in the pool, further items are created when
+   // the pool is empty and dropped when they are returned, like connections
+   // exceeding the size of a bounded pool
+   template< typename Mutex >
+   class stand_in_pool final
+      : public tao::pq::internal::pool< item, Mutex >
+   {
+   private:
+      const std::size_t m_size;
+      mutable std::atomic< std::size_t > m_created{ 0 };
+
+      [[nodiscard]] auto v_create() const -> std::unique_ptr< item > override
+      {
+         return std::make_unique< item >( item{ m_created.fetch_add( 1, std::memory_order_relaxed ) < m_size } );
+      }
+
+      [[nodiscard]] auto v_is_valid( item& i ) const noexcept -> bool override
+      {
+         return i.retained;
+      }
+
+   public:
+      explicit stand_in_pool( const std::size_t size ) noexcept
+         : m_size( size )
+      {}
+
+      void fill()
+      {
+         std::vector< std::shared_ptr< item > > items;
+         for( std::size_t i = 0; i < m_size; ++i ) {
+            items.push_back( this->get() );
+         }
+      }
+   };
+
+   void spin( const std::chrono::nanoseconds hold ) noexcept
+   {
+      if( hold.count() > 0 ) {
+         const auto end = clock::now() + hold;
+         while( clock::now() < end ) {
+         }
+      }
+   }
+
+   void add( tao::pq::bench::load_result& r, const std::string& prefix, const tao::pq::internal::histogram_snapshot& h )
+   {
+      r.metrics.emplace_back( prefix + "_p50_ns", static_cast< double >( h.percentile( 0.5 ) ) );
+      r.metrics.emplace_back( prefix + "_p99_ns", static_cast< double >( h.percentile( 0.99 ) ) );
+      r.metrics.emplace_back( prefix + "_max_ns", static_cast< double >( h.max() ) );
+   }
+
+   template< typename Mutex >
+   void contention( tao::pq::bench::runner& r, const std::size_t threads, const std::chrono::nanoseconds hold, const std::string& factor )
+   {
+      lock_stats stats;
+      instrumented_mutex::stats = &stats;
+      const auto size = std::max< std::size_t >( 1, static_cast< std::size_t >( static_cast< double >( threads ) * std::stod( factor ) ) );
+      const auto pool = std::make_shared< stand_in_pool< Mutex > >( size );
+      pool->fill();
+
+      const std::string name = "pool/hold=" + std::to_string( hold.count() ) + "ns/size=" + factor + "x";
+      r.load(
+         name, threads, 1,
+         [ & ]( const std::size_t /*unused*/ ) {
+            return [ &, hold ] {
+               const auto sp = pool->get();
+               spin( hold );
+            };
+         },
+         [ & ]( tao::pq::bench::load_result& result ) {
+            const auto m = pool->metrics();
+            result.metrics.emplace_back( "size", static_cast< double >( size ) );
+            result.metrics.emplace_back( "creations", static_cast< double >( m.creations ) );
+            add( result, "checkout", m.checkout_latency );
+            if constexpr( std::is_same_v< Mutex, instrumented_mutex > ) {
+               add( result, "lock_wait", stats.wait.snapshot() );
+               add( result, "lock_hold", stats.hold.snapshot() );
+            }
+         } );
+   }
+
+}  // namespace
+
+auto main( int argc, char** argv ) -> int
+{
+   return tao::pq::bench::main( argc, argv, []( tao::pq::bench::runner& r ) {
+      const auto threads = r.list_option( "threads", "1,2,4,8,16,32,64,128" );
+      const auto holds = r.list_option( "hold", "0,1000,10000" );
+      const auto factors = r.list_option( "pool-sizes", "0.5,2" );
+      const bool lock_stats = ( r.option( "lock-stats", "0" ) != "0" );
+
+      // the uncontended cost of a checkout and return
+      {
+         const auto pool = std::make_shared< stand_in_pool< std::mutex > >( 1 );
+         pool->fill();
+         r.run( "pool/checkout", [ & ] { tao::pq::bench::do_not_optimize( pool->get() ); } );
+      }
+
+      for( const auto& hold : holds ) {
+         for( const auto& factor : factors ) {
+            for( const auto& t : threads ) {
+               if( lock_stats ) {
+                  contention< instrumented_mutex >( r, std::stoul( t ), std::chrono::nanoseconds( std::stoul( hold ) ), factor );
+               }
+               else {
+                  contention< std::mutex >( r, std::stoul( t ), std::chrono::nanoseconds( std::stoul( hold ) ), factor );
+               }
+            }
+         }
+      }
+   } );
+}
@@ -0,0 +1,227 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include "../bench.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <libpq-fe.h>
+
+#include <tao/pq/internal/printf.hpp>
+#include <tao/pq/internal/strtox.hpp>
+#include <tao/pq/result.hpp>
+#include <tao/pq/result_traits_optional.hpp>
+#include <tao/pq/result_traits_pair.hpp>
+#include <tao/pq/result_traits_tuple.hpp>
+
+// usage: taopq-bench-result_decoding [--rows=<n>] [--null-density=<fraction>] [<common arguments>]
+
+namespace
+{
+   using tao::pq::bench::do_not_optimize;
+
+   // type OIDs from pg_type.h
+   constexpr Oid BOOLOID = 16;
+   constexpr Oid INT8OID = 20;
+   constexpr Oid INT4OID = 23;
+   constexpr Oid TEXTOID = 25;
+   constexpr Oid FLOAT8OID = 701;
+
+   struct column
+   {
+      std::string name;
+      Oid type;
+      std::function< std::string( std::mt19937& ) > generate;
+      bool nullable = false;
+   };
+
+   // builds a result set like one received from the server, in text format
+   [[nodiscard]] auto make_result( const std::vector< column >& columns, const std::size_t rows, const double null_density ) -> tao::pq::result
+   {
+      std::mt19937 rng( 42 );  // NOLINT(cert-msc32-c,cert-msc51-cpp)
+      std::bernoulli_distribution is_null( null_density );
+
+      std::unique_ptr< PGresult, decltype( &PQclear ) > pgresult( PQmakeEmptyPGresult( nullptr, PGRES_TUPLES_OK ), &PQclear );
+      PGresult* r = pgresult.get();
+
+      std::vector< PGresAttDesc > attributes;
+      for( const auto& c : columns ) {
+         PGresAttDesc a{};
+         a.name = const_cast< char* >( c.name.c_str() );  // NOLINT(cppcoreguidelines-pro-type-const-cast)
+         a.typid = c.type;
+         a.typlen = -1;
+         a.atttypmod = -1;
+         attributes.push_back( a );
+      }
+      if( PQsetResultAttrs( r, static_cast< int >( attributes.size() ), attributes.data() ) == 0 ) {
+         throw std::runtime_error( "PQsetResultAttrs() failed" );
+      }
+
+      for( std::size_t row = 0; row < rows; ++row ) {
+         for( std::size_t i = 0; i < columns.size(); ++i ) {
+            const int tup_num = static_cast< int >( row );
+            const int field_num = static_cast< int >( i );
+            int ok;
+            if( columns[ i ].nullable && is_null( rng ) ) {
+               ok = PQsetvalue( r, tup_num, field_num, nullptr, -1 );
+            }
+            else {
+               const std::string value = columns[ i ].generate( rng );
+               ok = PQsetvalue( r, tup_num, field_num, const_cast< char* >( value.c_str() ), static_cast< int >( value.size() ) );  // NOLINT(cppcoreguidelines-pro-type-const-cast)
+            }
+            if( ok == 0 ) {
+               throw std::runtime_error( "PQsetvalue() failed" );
+            }
+         }
+      }
+      return tao::pq::result( pgresult.release() );
+   }
+
+   [[nodiscard]] auto int4( std::mt19937& rng ) -> std::string
+   {
+      return std::to_string( static_cast< int >( rng() ) );
+   }
+
+   [[nodiscard]] auto int8( std::mt19937& rng ) -> std::string
+   {
+      return std::to_string( ( static_cast< long long >( rng() ) << 31 ) ^ rng() );
+   }
+
+   [[nodiscard]] auto float8( std::mt19937& rng ) -> std::string
+   {
+      return tao::pq::internal::printf( "%.17g", std::uniform_real_distribution< double >( -1e6, 1e6 )( rng ) );
+   }
+
+   [[nodiscard]] auto text( std::mt19937& rng ) -> std::string
+   {
+      std::string nrv( 16, ' ' );
+      for( auto& c : nrv ) {
+         c = static_cast< char >( 'a' + rng() % 26 );
+      }
+      return nrv;
+   }
+
+   [[nodiscard]] auto boolean( std::mt19937& rng ) -> std::string
+   {
+      return ( rng() % 2 == 0 ) ? "t" : "f";
+   }
+
+   template< typename T >
+   void vector( tao::pq::bench::runner& r, const std::string& prefix, const std::string& type, const tao::pq::result& res )
+   {
+      r.run( prefix + "result::vector<" + type + ">", [ & ] { do_not_optimize( res.vector< T >() ); } );
+   }
+
+   template< typename T >
+   void get( tao::pq::bench::runner& r, const std::string& prefix, const std::string& type, const tao::pq::result& res, const std::size_t column )
+   {
+      r.run( prefix + "row::get<" + type + ">", [ & ] {
+         for( const auto& row : res ) {
+            do_not_optimize( row.get< T >( column ) );
+         }
+      } );
+   }
+
+   void decoding( tao::pq::bench::runner& r, const std::size_t rows, const double null_density )
+   {
+      const std::string prefix = std::to_string( rows ) + "/";
+
+      const column id{ "id", INT8OID, int8 };
+      const column i{ "i", INT4OID, int4 };
+      const column d{ "d", FLOAT8OID, float8 };
+      const column s{ "s", TEXTOID, text };
+      const column b{ "b", BOOLOID, boolean };
+      const column o{ "o", INT4OID, int4, true };
+
+      // single columns
+      vector< int >( r, prefix, "int", make_result( { i }, rows, null_density ) );
+      vector< long long >( r, prefix, "long long", make_result( { id }, rows, null_density ) );
+      vector< double >( r, prefix, "double", make_result( { d }, rows, null_density ) );
+      vector< std::string >( r, prefix, "string", make_result( { s }, rows, null_density ) );
+      vector< bool >( r, prefix, "bool", make_result( { b }, rows, null_density ) );
+      vector< std::optional< int > >( r, prefix, "optional<int>", make_result( { o }, rows, null_density ) );
+
+      // multiple columns
+      const auto wide = make_result( { id, i, d, s, b, o }, rows, null_density );
+      vector< std::pair< long long, int > >( r, prefix, "pair<long long,int>", make_result( { id, i }, rows, null_density ) );
+      vector< std::tuple< long long, int, double, std::string, bool, std::optional< int > > >( r, prefix, "tuple<long long,int,double,string,bool,optional<int>>", wide );
+
+      get< long long >( r, prefix, "long long", wide, 0 );
+      get< int >( r, prefix, "int", wide, 1 );
+      get< double >( r, prefix, "double", wide, 2 );
+      get< std::string >( r, prefix, "string", wide, 3 );
+      get< const char* >( r, prefix, "const char*", wide, 3 );
+      get< bool >( r, prefix, "bool", wide, 4 );
+      get< std::optional< int > >( r, prefix, "optional<int>", wide, 5 );
+
+      r.run( prefix + "row::index", [ & ] {
+         for( const auto& row : wide ) {
+            do_not_optimize( row.index( "o" ) );
+         }
+      } );
+      r.run( prefix + "row::operator[](name).as<int>", [ & ] {
+         for( const auto& row : wide ) {
+            do_not_optimize( row[ "i" ].as< int >() );
+         }
+      } );
+      r.run( prefix + "row::tuple<long long,int,double>", [ & ] {
+         for( const auto& row : wide ) {
+            do_not_optimize( row.slice( 0, 3 ).tuple< long long, int, double >() );
+         }
+      } );
+      r.run( prefix + "row::pair<string,bool>", [ & ] {
+         for( const auto& row : wide ) {
+            do_not_optimize( row.slice( 3, 2 ).pair< std::string, bool >() );
+         }
+      } );
+   }
+
+   template< typename F >
+   void strtox( tao::pq::bench::runner& r, const std::string& name, const std::vector< std::string >& inputs, F f )
+   {
+      r.run( "strtox/" + name, [ & ] {
+         for( const auto& input : inputs ) {
+            do_not_optimize( f( input.c_str() ) );
+         }
+      } );
+   }
+
+   void strtox( tao::pq::bench::runner& r )
+   {
+      std::mt19937 rng( 42 );  // NOLINT(cert-msc32-c,cert-msc51-cpp)
+      std::vector< std::string > ints;
+      std::vector< std::string > doubles;
+      for( std::size_t n = 0; n < 1000; ++n ) {
+         ints.push_back( int8( rng ) );
+         doubles.push_back( float8( rng ) );
+      }
+      strtox( r, "strtoll/1000", ints, []( const char* s ) { return tao::pq::internal::strtoll( s ); } );
+      strtox( r, "strtod/1000", doubles, []( const char* s ) { return tao::pq::internal::strtod( s ); } );
+   }
+
+}  // namespace
+
+auto main( int argc, char** argv ) -> int
+{
+   return tao::pq::bench::main( argc, argv, []( tao::pq::bench::runner& r ) {
+      const auto rows = std::stoul( r.option( "rows", "1000" ) );
+      const auto null_density = std::stod( r.option( "null-density", "0.1" ) );
+      if( ( null_density < 0 ) || ( null_density > 1 ) ) {
+         throw std::invalid_argument( "null density must be between 0 and 1" );
+      }
+      if( rows != 1 ) {
+         decoding( r, 1, null_density );
+      }
+      decoding( r, rows, null_density );
+      strtox( r );
+   } );
+}
@@ -0,0 +1,236 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include "../../test/getenv.hpp"
+#include "../bench.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <tao/pq.hpp>
+#include <tao/pq/connection_pool.hpp>
+#include <tao/pq/table_writer.hpp>
+
+// usage: taopq-bench-tpcb [--database=<connection string>] [--scale=<n>] [--clients=<n>,...] [--init=0|1]
+//                         [--prepared=0|1] [--binary=0|1] [--isolation=<level>] [<common arguments>]
+//
+// the TPC-B like workload of pgbench on pgbench's own tables, see doc/Benchmarks.md
+// for how to compare the results with pgbench
+//
+// requires a server, see src/bench/postgres.sh to run it against a temporary one
+
+namespace
+{
+   // the statements of pgbench's built-in tpcb-like script
+   const char* const update_account = "UPDATE pgbench_accounts SET abalance = abalance + $1 WHERE aid = $2";
+   const char* const select_account = "SELECT abalance FROM pgbench_accounts WHERE aid = $1";
+   const char* const update_teller = "UPDATE pgbench_tellers SET tbalance = tbalance + $1 WHERE tid = $2";
+   const char* const update_branch = "UPDATE pgbench_branches SET bbalance = bbalance + $1 WHERE bid = $2";
+   const char* const insert_history = "INSERT INTO pgbench_history ( tid, bid, aid, delta, mtime ) VALUES ( $1, $2, $3, $4, CURRENT_TIMESTAMP )";
+
+   // the sizes pgbench uses per scale factor
+   constexpr int branches = 1;
+   constexpr int tellers = 10;
+   constexpr int accounts = 100000;
+
+   struct options
+   {
+      std::string database;
+      int scale = 0;
+      std::vector< std::size_t > clients;
+      bool prepared = false;
+      bool binary = false;
+      tao::pq::transaction::isolation_level isolation = tao::pq::transaction::isolation_level::default_isolation_level;
+   };
+
+   [[nodiscard]] auto isolation_level( const std::string& name ) -> tao::pq::transaction::isolation_level
+   {
+      using tao::pq::transaction;
+      if( name == "default" ) {
+         return transaction::isolation_level::default_isolation_level;
+      }
+      if( name == "read_committed" ) {
+         return transaction::isolation_level::read_committed;
+      }
+      if( name == "repeatable_read" ) {
+         return transaction::isolation_level::repeatable_read;
+      }
+      if( name == "serializable" ) {
+         return transaction::isolation_level::serializable;
+      }
+      throw std::invalid_argument( "unknown isolation level: " + name );
+   }
+
+   template< typename F >
+   void copy( const std::shared_ptr< tao::pq::transaction >& tr, const std::string& table, const int rows, const F& f )
+   {
+      tao::pq::table_writer tw( tr, "COPY " + table + " FROM STDIN" );
+      for( int i = 1; i <= rows; ++i ) {
+         tw.insert( f( i ) );
+      }
+      tw.finish();
+   }
+
+   // the same schema and data as 'pgbench -i -s <scale>', except that all
+   // tables are loaded with COPY
+   void initialize( tao::pq::connection& c, const int scale )
+   {
+      c.execute( "DROP TABLE IF EXISTS pgbench_accounts, pgbench_branches, pgbench_history, pgbench_tellers" );
+      c.execute( "CREATE TABLE pgbench_history ( tid INT, bid INT, aid INT, delta INT, mtime TIMESTAMP, filler CHAR( 22 ) )" );
+      c.execute( "CREATE TABLE pgbench_tellers ( tid INT NOT NULL, bid INT, tbalance INT, filler CHAR( 84 ) ) WITH ( fillfactor = 100 )" );
+      c.execute( "CREATE TABLE pgbench_accounts ( aid INT NOT NULL, bid INT, abalance INT, filler CHAR( 84 ) ) WITH ( fillfactor = 100 )" );
+      c.execute( "CREATE TABLE pgbench_branches ( bid INT NOT NULL, bbalance INT, filler CHAR( 88 ) ) WITH ( fillfactor = 100 )" );
+
+      const auto tr = c.transaction();
+      copy( tr, "pgbench_branches", branches * scale, []( const int i ) {
+         return std::to_string( i ) + "\t0\t\\N\n";
+      } );
+      copy( tr, "pgbench_tellers", tellers * scale, []( const int i ) {
+         return std::to_string( i ) + '\t' + std::to_string( ( i - 1 ) / tellers + 1 ) + "\t0\t\\N\n";
+      } );
+      copy( tr, "pgbench_accounts", accounts * scale, []( const int i ) {
+         return std::to_string( i ) + '\t' + std::to_string( ( i - 1 ) / accounts + 1 ) + "\t0\t\n";
+      } );
+      tr->commit();
+
+      c.execute( "ALTER TABLE pgbench_branches ADD PRIMARY KEY ( bid )" );
+      c.execute( "ALTER TABLE pgbench_tellers ADD PRIMARY KEY ( tid )" );
+      c.execute( "ALTER TABLE pgbench_accounts ADD PRIMARY KEY ( aid )" );
+      c.execute( "VACUUM ANALYZE pgbench_branches" );
+      c.execute( "VACUUM ANALYZE pgbench_tellers" );
+      c.execute( "VACUUM ANALYZE pgbench_accounts" );
+      c.execute( "VACUUM ANALYZE pgbench_history" );
+   }
+
+   // serialization failures and deadlocks are retried, like pgbench does with --max-tries=0
+   [[nodiscard]] auto is_retryable( const std::exception& e ) noexcept -> bool
+   {
+      const std::string what = e.what();
+      return ( what.find( "/40001: " ) != std::string::npos ) || ( what.find( "/40P01: " ) != std::string::npos );
+   }
+
+   class client
+   {
+   private:
+      const std::shared_ptr< tao::pq::connection > m_connection;
+      const options& m_options;
+      std::atomic< std::size_t >& m_retries;
+      std::mt19937 m_rng;
+
+      [[nodiscard]] auto statement( const char* name, const char* sql ) const noexcept -> const char*
+      {
+         return m_options.prepared ? name : sql;
+      }
+
+      [[nodiscard]] auto random( const int from, const int to ) -> int
+      {
+         return std::uniform_int_distribution< int >( from, to )( m_rng );
+      }
+
+      template< template< typename... > class Traits >
+      void transaction( const int aid, const int bid, const int tid, const int delta )
+      {
+         const auto tr = m_connection->transaction( m_options.isolation );
+         tr->execute< Traits >( statement( "update_account", update_account ), delta, aid );
+         tao::pq::bench::do_not_optimize( tr->execute< Traits >( statement( "select_account", select_account ), aid ).template as< int >() );
+         tr->execute< Traits >( statement( "update_teller", update_teller ), delta, tid );
+         tr->execute< Traits >( statement( "update_branch", update_branch ), delta, bid );
+         tr->execute< Traits >( statement( "insert_history", insert_history ), tid, bid, aid, delta );
+         tr->commit();
+      }
+
+   public:
+      client( const std::shared_ptr< tao::pq::connection >& connection, const options& o, std::atomic< std::size_t >& retries, const std::size_t seed )
+         : m_connection( connection ),
+           m_options( o ),
+           m_retries( retries ),
+           m_rng( static_cast< std::mt19937::result_type >( seed ) )
+      {
+         if( o.prepared ) {
+            m_connection->prepare( "update_account", update_account );
+            m_connection->prepare( "select_account", select_account );
+            m_connection->prepare( "update_teller", update_teller );
+            m_connection->prepare( "update_branch", update_branch );
+            m_connection->prepare( "insert_history", insert_history );
+         }
+      }
+
+      void operator()()
+      {
+         const int aid = random( 1, accounts * m_options.scale );
+         const int bid = random( 1, branches * m_options.scale );
+         const int tid = random( 1, tellers * m_options.scale );
+         const int delta = random( -5000, 5000 );
+         while( true ) {
+            try {
+               if( m_options.binary ) {
+                  transaction< tao::pq::parameter_binary_traits >( aid, bid, tid, delta );
+               }
+               else {
+                  transaction< tao::pq::parameter_text_traits >( aid, bid, tid, delta );
+               }
+               return;
+            }
+            catch( const std::exception& e ) {
+               if( !is_retryable( e ) ) {
+                  throw;
+               }
+               m_retries.fetch_add( 1, std::memory_order_relaxed );
+            }
+         }
+      }
+   };
+
+}  // namespace
+
+auto main( int argc, char** argv ) -> int
+{
+   return tao::pq::bench::main( argc, argv, []( tao::pq::bench::runner& r ) {
+      options o;
+      o.database = r.option( "database", tao::pq::internal::getenv( "TAOPQ_BENCHMARK_DATABASE", "dbname=postgres" ) );
+      o.scale = std::stoi( r.option( "scale", "1" ) );
+      for( const auto& c : r.list_option( "clients", "1,2,4,8" ) ) {
+         o.clients.push_back( std::stoul( c ) );
+      }
+      o.prepared = ( r.option( "prepared", "1" ) != "0" );
+      o.binary = ( r.option( "binary", "0" ) != "0" );
+      const auto isolation = r.option( "isolation", "default" );
+      o.isolation = isolation_level( isolation );
+
+      std::shared_ptr< tao::pq::connection > c;
+      try {
+         c = tao::pq::connection::create( o.database );
+      }
+      catch( const std::exception& e ) {
+         // allows running all benchmarks without a server
+         std::cerr << "skipping TPC-B benchmarks, no server: " << e.what() << std::endl;
+         return;
+      }
+
+      if( r.option( "init", "1" ) != "0" ) {
+         initialize( *c, o.scale );
+      }
+
+      const std::string name = std::string( "tpcb/scale=" ) + std::to_string( o.scale ) + ( o.prepared ? "/prepared" : "/extended" ) + ( o.binary ? "/binary/" : "/text/" ) + isolation;
+      for( const auto clients : o.clients ) {
+         // a new pool per run, so that the prepared statements are set up again
+         const auto pool = tao::pq::connection_pool::create( o.database );
+         std::atomic< std::size_t > retries( 0 );
+         r.load(
+            name, clients, 1,
+            [ & ]( const std::size_t thread ) {
+               return client( pool->connection(), o, retries, thread );
+            },
+            [ & ]( tao::pq::bench::load_result& result ) {
+               result.metrics.emplace_back( "retries", static_cast< double >( retries.load() ) );
+            } );
+      }
+   } );
+}
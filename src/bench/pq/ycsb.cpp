@@ -0,0 +1,404 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include "../../test/getenv.hpp"
+#include "../bench.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <tao/pq.hpp>
+#include <tao/pq/connection_pool.hpp>
+#include <tao/pq/internal/histogram.hpp>
+#include <tao/pq/table_writer.hpp>
+
+// usage: taopq-bench-ycsb [--database=<connection string>] [--workloads=<a-f>,...] [--records=<n>]
+//                         [--threads=<n>,...] [--distribution=zipfian|uniform] [--field-length=<n>]
+//                         [--max-scan-length=<n>] [--init=0|1] [<common arguments>]
+//
+// the core workloads of the Yahoo! Cloud Serving Benchmark on a key-value table
+//
+// requires a server, see src/bench/postgres.sh to run it against a temporary one
+
+namespace
+{
+   using tao::pq::bench::do_not_optimize;
+
+   constexpr std::size_t fields = 10;
+
+   enum operation : std::size_t
+   {
+      read,
+      update,
+      insert,
+      scan,
+      read_modify_write,
+      operations
+   };
+
+   const char* const operation_names[] = { "read", "update", "insert", "scan", "rmw" };
+
+   enum class distribution
+   {
+      uniform,
+      zipfian,
+      latest
+   };
+
+   // the proportions of the operations, in the order of the operation enum
+   struct workload
+   {
+      std::string name;
+      std::array< double, operations > proportions;
+      distribution keys;
+   };
+
+   // the core workloads as defined by YCSB
+   [[nodiscard]] auto core_workload( const char name ) -> workload
+   {
+      switch( name ) {
+         case 'a':
+            return { "a", { 0.5, 0.5, 0, 0, 0 }, distribution::zipfian };
+         case 'b':
+            return { "b", { 0.95, 0.05, 0, 0, 0 }, distribution::zipfian };
+         case 'c':
+            return { "c", { 1, 0, 0, 0, 0 }, distribution::zipfian };
+         case 'd':
+            return { "d", { 0.95, 0, 0.05, 0, 0 }, distribution::latest };
+         case 'e':
+            return { "e", { 0, 0, 0.05, 0.95, 0 }, distribution::zipfian };
+         case 'f':
+            return { "f", { 0.5, 0, 0, 0, 0.5 }, distribution::zipfian };
+      }
+      throw std::invalid_argument( std::string( "unknown workload: " ) + name );
+   }
+
+   struct options
+   {
+      std::string database;
+      std::vector< std::string > workloads;
+      std::uint64_t records = 0;
+      std::vector< std::size_t > threads;
+      bool uniform = false;
+      std::size_t field_length = 0;
+      int max_scan_length = 0;
+   };
+
+   // the Zipfian generator used by YCSB, from Gray et al., "Quickly Generating
+   // Billion-Record Synthetic Databases", returns values in [0, items)
+   class zipfian
+   {
+   private:
+      static constexpr double theta = 0.99;
+
+      const double m_items;
+      double m_zetan = 0;
+      double m_alpha = 0;
+      double m_eta = 0;
+
+   public:
+      explicit zipfian( const std::uint64_t items )
+         : m_items( static_cast< double >( items ) )
+      {
+         for( std::uint64_t i = 1; i <= items; ++i ) {
+            m_zetan += 1 / std::pow( static_cast< double >( i ), theta );
+         }
+         const double zeta2 = 1 + 1 / std::pow( 2, theta );
+         m_alpha = 1 / ( 1 - theta );
+         m_eta = ( 1 - std::pow( 2 / m_items, 1 - theta ) ) / ( 1 - zeta2 / m_zetan );
+      }
+
+      template< typename Rng >
+      [[nodiscard]] auto operator()( Rng& rng ) const -> std::uint64_t
+      {
+         const double u = std::uniform_real_distribution< double >( 0, 1 )( rng );
+         const double uz = u * m_zetan;
+         if( uz < 1 ) {
+            return 0;
+         }
+         if( uz < 1 + std::pow( 0.5, theta ) ) {
+            return 1;
+         }
+         return std::min( static_cast< std::uint64_t >( m_items * std::pow( m_eta * u - m_eta + 1, m_alpha ) ), static_cast< std::uint64_t >( m_items ) - 1 );
+      }
+   };
+
+   // the keys are hashed so that neither popular nor recently inserted records
+   // are adjacent, as YCSB does by default
+   [[nodiscard]] auto key( const std::uint64_t n ) -> std::string
+   {
+      std::uint64_t hash = 0xcbf29ce484222325;
+      for( int i = 0; i < 8; ++i ) {
+         hash ^= ( n >> ( i * 8 ) ) & 0xff;
+         hash *= 0x100000001b3;
+      }
+      return "user" + std::to_string( hash );
+   }
+
+   [[nodiscard]] auto field_list() -> std::string
+   {
+      std::string nrv;
+      for( std::size_t i = 0; i < fields; ++i ) {
+         nrv += ( ( i == 0 ) ? "field" : ", field" ) + std::to_string( i );
+      }
+      return nrv;
+   }
+
+   void initialize( tao::pq::connection& c, const options& o )
+   {
+      std::string columns;
+      for( std::size_t i = 0; i < fields; ++i ) {
+         columns += ", field" + std::to_string( i ) + " TEXT";
+      }
+      c.execute( "DROP TABLE IF EXISTS usertable" );
+      c.execute( "CREATE TABLE usertable ( ycsb_key TEXT PRIMARY KEY" + columns + " )" );
+
+      std::mt19937 rng;
+      const auto tr = c.transaction();
+      tao::pq::table_writer tw( tr, "COPY usertable ( ycsb_key, " + field_list() + " ) FROM STDIN" );
+      for( std::uint64_t n = 0; n < o.records; ++n ) {
+         std::string line = key( n );
+         for( std::size_t i = 0; i < fields; ++i ) {
+            line += '\t';
+            for( std::size_t j = 0; j < o.field_length; ++j ) {
+               line += static_cast< char >( 'a' + rng() % 26 );
+            }
+         }
+         line += '\n';
+         tw.insert( line );
+      }
+      tw.finish();
+      tr->commit();
+      c.execute( "VACUUM ANALYZE usertable" );
+   }
+
+   using record = std::vector< std::string >;
+
+   [[nodiscard]] auto decode( const tao::pq::row& row ) -> record
+   {
+      record nrv;
+      nrv.reserve( row.columns() );
+      for( std::size_t i = 0; i < row.columns(); ++i ) {
+         nrv.push_back( row.get< std::string >( i ) );
+      }
+      return nrv;
+   }
+
+   // shared by all clients of a run
+   struct state
+   {
+      const options& o;
+      const workload& w;
+      const zipfian& z;
+      std::atomic< std::uint64_t >& inserted;
+      std::array< tao::pq::internal::histogram, operations > latencies;
+   };
+
+   class client
+   {
+   private:
+      const std::shared_ptr< tao::pq::connection > m_connection;
+      state& m_state;
+      std::mt19937_64 m_rng;
+
+      [[nodiscard]] auto choose_operation() -> operation
+      {
+         double u = std::uniform_real_distribution< double >( 0, 1 )( m_rng );
+         std::size_t last = 0;
+         for( std::size_t i = 0; i < operations; ++i ) {
+            if( m_state.w.proportions[ i ] > 0 ) {
+               if( u < m_state.w.proportions[ i ] ) {
+                  return static_cast< operation >( i );
+               }
+               u -= m_state.w.proportions[ i ];
+               last = i;
+            }
+         }
+         // rounding errors
+         return static_cast< operation >( last );
+      }
+
+      // an existing record, records inserted by other clients may not be committed yet
+      [[nodiscard]] auto choose_key() -> std::string
+      {
+         const auto inserted = m_state.inserted.load( std::memory_order_relaxed );
+         if( m_state.o.uniform ) {
+            return key( std::uniform_int_distribution< std::uint64_t >( 0, inserted - 1 )( m_rng ) );
+         }
+         const auto z = m_state.z( m_rng );
+         if( m_state.w.keys == distribution::latest ) {
+            return key( inserted - 1 - std::min( z, inserted - 1 ) );
+         }
+         return key( z % m_state.o.records );
+      }
+
+      [[nodiscard]] auto value() -> std::string
+      {
+         std::string nrv( m_state.o.field_length, ' ' );
+         for( auto& c : nrv ) {
+            c = static_cast< char >( 'a' + m_rng() % 26 );
+         }
+         return nrv;
+      }
+
+      [[nodiscard]] auto read_record( const std::string& k ) -> record
+      {
+         const auto result = m_connection->execute( "read", k );
+         return result.empty() ? record() : decode( result[ 0 ] );
+      }
+
+      void update_field( const std::string& k )
+      {
+         const auto field = std::uniform_int_distribution< std::size_t >( 0, fields - 1 )( m_rng );
+         m_connection->execute( "update" + std::to_string( field ), value(), k );
+      }
+
+      void run( const operation op )
+      {
+         switch( op ) {
+            case read:
+               do_not_optimize( read_record( choose_key() ) );
+               break;
+
+            case update:
+               update_field( choose_key() );
+               break;
+
+            case insert: {
+               const auto n = m_state.inserted.fetch_add( 1, std::memory_order_relaxed );
+               m_connection->execute( "insert", key( n ), value(), value(), value(), value(), value(), value(), value(), value(), value(), value() );
+               break;
+            }
+
+            case scan: {
+               const auto length = std::uniform_int_distribution< int >( 1, m_state.o.max_scan_length )( m_rng );
+               std::vector< record > records;
+               for( const auto& row : m_connection->execute( "scan", choose_key(), length ) ) {
+                  records.push_back( decode( row ) );
+               }
+               do_not_optimize( records );
+               break;
+            }
+
+            case read_modify_write: {
+               const auto k = choose_key();
+               do_not_optimize( read_record( k ) );
+               update_field( k );
+               break;
+            }
+
+            case operations:
+               break;
+         }
+      }
+
+   public:
+      client( const std::shared_ptr< tao::pq::connection >& connection, state& s, const std::size_t seed )
+         : m_connection( connection ),
+           m_state( s ),
+           m_rng( seed )
+      {
+         const auto list = field_list();
+         m_connection->prepare( "read", "SELECT " + list + " FROM usertable WHERE ycsb_key = $1" );
+         m_connection->prepare( "scan", "SELECT " + list + " FROM usertable WHERE ycsb_key >= $1 ORDER BY ycsb_key LIMIT $2" );
+         m_connection->prepare( "insert", "INSERT INTO usertable ( ycsb_key, " + list + " ) VALUES ( $1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11 )" );
+         for( std::size_t i = 0; i < fields; ++i ) {
+            m_connection->prepare( "update" + std::to_string( i ), "UPDATE usertable SET field" + std::to_string( i ) + " = $1 WHERE ycsb_key = $2" );
+         }
+      }
+
+      void operator()()
+      {
+         const auto op = choose_operation();
+         const auto start = std::chrono::steady_clock::now();
+         run( op );
+         m_state.latencies[ op ].record( static_cast< std::uint64_t >( std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now() - start ).count() ) );
+      }
+   };
+
+   // throughput and latency percentiles for each operation type of the workload
+   void add( tao::pq::bench::load_result& r, const state& s )
+   {
+      for( std::size_t i = 0; i < operations; ++i ) {
+         const auto h = s.latencies[ i ].snapshot();
+         if( h.count() != 0 ) {
+            const std::string prefix = operation_names[ i ];
+            r.metrics.emplace_back( prefix + "_ops_per_second", static_cast< double >( h.count() ) / r.seconds );
+            r.metrics.emplace_back( prefix + "_p50_ns", static_cast< double >( h.percentile( 0.5 ) ) );
+            r.metrics.emplace_back( prefix + "_p99_ns", static_cast< double >( h.percentile( 0.99 ) ) );
+            r.metrics.emplace_back( prefix + "_p999_ns", static_cast< double >( h.percentile( 0.999 ) ) );
+         }
+      }
+   }
+
+}  // namespace
+
+auto main( int argc, char** argv ) -> int
+{
+   return tao::pq::bench::main( argc, argv, []( tao::pq::bench::runner& r ) {
+      options o;
+      o.database = r.option( "database", tao::pq::internal::getenv( "TAOPQ_BENCHMARK_DATABASE", "dbname=postgres" ) );
+      o.workloads = r.list_option( "workloads", "a,b,c,f,d,e" );
+      o.records = std::stoull( r.option( "records", "100000" ) );
+      for( const auto& t : r.list_option( "threads", "1,2,4,8" ) ) {
+         o.threads.push_back( std::stoul( t ) );
+      }
+      o.uniform = ( r.option( "distribution", "zipfian" ) == "uniform" );
+      o.field_length = std::stoul( r.option( "field-length", "100" ) );
+      o.max_scan_length = std::stoi( r.option( "max-scan-length", "100" ) );
+
+      std::vector< workload > workloads;
+      for( const auto& name : o.workloads ) {
+         if( name.size() != 1 ) {
+            throw std::invalid_argument( "unknown workload: " + name );
+         }
+         workloads.push_back( core_workload( name[ 0 ] ) );
+      }
+
+      std::shared_ptr< tao::pq::connection > c;
+      try {
+         c = tao::pq::connection::create( o.database );
+      }
+      catch( const std::exception& e ) {
+         // allows running all benchmarks without a server
+         std::cerr << "skipping YCSB benchmarks, no server: " << e.what() << std::endl;
+         return;
+      }
+
+      if( r.option( "init", "1" ) != "0" ) {
+         initialize( *c, o );
+      }
+
+      // the records inserted by the workloads d and e are kept for the following runs
+      std::atomic< std::uint64_t > inserted( o.records );
+      const zipfian z( o.records );
+      for( const auto& w : workloads ) {
+         const std::string name = "ycsb/" + w.name + ( o.uniform ? "/uniform" : ( w.keys == distribution::latest ) ? "/latest" : "/zipfian" );
+         for( const auto threads : o.threads ) {
+            // a new pool per run, so that the prepared statements are set up again
+            const auto pool = tao::pq::connection_pool::create( o.database );
+            state s{ o, w, z, inserted, {} };
+            r.load(
+               name, threads, 1,
+               [ & ]( const std::size_t thread ) {
+                  return client( pool->connection(), s, thread );
+               },
+               [ & ]( tao::pq::bench::load_result& result ) {
+                  add( result, s );
+               } );
+         }
+      }
+   } );
+}
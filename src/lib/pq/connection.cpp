@@ -6,10 +6,12 @@
 #include <cstring>
 #include <stdexcept>
 #include <string_view>
+#include <utility>
 
 #include <libpq-fe.h>
 
 #include <tao/pq/connection.hpp>
+#include <tao/pq/internal/poll.hpp>
 
 namespace tao::pq
 {
@@ -100,7 +102,14 @@ namespace tao::pq
          explicit top_level_transaction( const transaction::isolation_level il, const std::shared_ptr< pq::connection >& connection )
             : transaction_base( connection )
          {
-            execute( isolation_level_to_statement( il ) );
+            notify_observer( transaction_event::kind::begin );
+            try {
+               execute( isolation_level_to_statement( il ) );
+            }
+            catch( ... ) {
+               notify_observer( transaction_event::kind::rollback );
+               throw;
+            }
          }
 
          ~top_level_transaction() override
@@ -175,17 +184,187 @@ namespace tao::pq
       return m_prepared_statements.find( name ) != m_prepared_statements.end();
    }
 
-   auto connection::execute_params( const char* statement,
+   // like PQexec*() do before sending, collects the results left over, e.g.
+   // when a COPY was not finished, otherwise the connection stays busy
+   void connection::clear_results()
+   {
+      while( PGresult* r = PQgetResult( m_pgconn.get() ) ) {
+         const auto status = PQresultStatus( r );
+         PQclear( r );
+         if( status == PGRES_COPY_IN ) {
+            if( PQputCopyEnd( m_pgconn.get(), "COPY terminated by new statement" ) < 0 ) {
+               throw std::runtime_error( "PQputCopyEnd() failed: " + error_message() );
+            }
+         }
+         else if( status == PGRES_COPY_OUT ) {
+            char* buffer = nullptr;
+            while( PQgetCopyData( m_pgconn.get(), &buffer, 0 ) > 0 ) {
+               PQfreemem( buffer );
+            }
+         }
+         else if( status == PGRES_COPY_BOTH ) {
+            throw std::runtime_error( "statement not allowed during COPY BOTH" );
+         }
+         if( !is_open() ) {
+            return;
+         }
+      }
+   }
+
+   auto connection::send_params( const char* statement,
+                                 const int n_params,
+                                 const Oid types[],
+                                 const char* const values[],
+                                 const int lengths[],
+                                 const int formats[] ) -> std::size_t
+   {
+      clear_results();
+      const bool prepared = is_prepared( statement );
+      if( prepared ) {
+         if( PQsendQueryPrepared( m_pgconn.get(), statement, n_params, values, lengths, formats, 0 ) == 0 ) {
+            throw std::runtime_error( "PQsendQueryPrepared() failed: " + error_message() );
+         }
+      }
+      else {
+         if( PQsendQueryParams( m_pgconn.get(), statement, n_params, types, values, lengths, formats, 0 ) == 0 ) {
+            throw std::runtime_error( "PQsendQueryParams() failed: " + error_message() );
+         }
+      }
+      // the round-trip is counted when waiting for the result
+      const auto nrv = internal::statement_wire_size( statement, prepared, n_params, values, lengths, formats );
+      m_wire.exchanged( nrv, internal::response_overhead( prepared ) );
+      return nrv;
+   }
+
+   // best effort, a failure (e.g. within an aborted transaction) leaves the name unchanged
+   void connection::set_application_name( const std::string& name ) noexcept
+   {
+      const char* const values[] = { name.c_str() };
+      const char* const statement = "SELECT pg_catalog.set_config( 'application_name', $1, false )";
+      const std::unique_ptr< PGresult, decltype( &PQclear ) > r( PQexecParams( m_pgconn.get(), statement, 1, nullptr, values, nullptr, nullptr, 0 ), &PQclear );
+      m_wire.round_trip();
+      m_wire.exchanged( internal::statement_wire_size( statement, false, 1, values, nullptr, nullptr ), internal::response_overhead( false ) );
+      m_wire.result( r.get() );
+      if( PQresultStatus( r.get() ) == PGRES_TUPLES_OK ) {
+         try {
+            m_application_name = name;
+         }
+         // LCOV_EXCL_START
+         catch( ... ) {
+            m_application_name.clear();
+         }
+         // LCOV_EXCL_STOP
+      }
+   }
+
+   // same as get_result() would do implicitly, but records when the server starts responding
+   void connection::wait_for_result( statement_event& event )
+   {
+      if( PQisBusy( m_pgconn.get() ) != 0 ) {
+         (void)internal::poll( PQsocket( m_pgconn.get() ), false );
+      }
+      event.responded = statement_event::clock::now();
+      while( true ) {
+         if( PQconsumeInput( m_pgconn.get() ) == 0 ) {
+            throw std::runtime_error( "PQconsumeInput() failed: " + error_message() );
+         }
+         if( PQisBusy( m_pgconn.get() ) == 0 ) {
+            break;
+         }
+         (void)internal::poll( PQsocket( m_pgconn.get() ), false );
+      }
+      event.received = statement_event::clock::now();
+   }
+
+   auto connection::get_result() -> PGresult*
+   {
+      m_wire.round_trip();
+      PGresult* nrv = nullptr;
+      while( PGresult* next = PQgetResult( m_pgconn.get() ) ) {
+         if( nrv != nullptr ) {
+            // keep the first error, the server aborts the statement after it
+            if( PQresultStatus( nrv ) == PGRES_FATAL_ERROR ) {
+               PQclear( next );
+               continue;
+            }
+            PQclear( nrv );
+         }
+         nrv = next;
+         m_wire.result( nrv );
+         switch( PQresultStatus( nrv ) ) {
+            case PGRES_COPY_IN:
+            case PGRES_COPY_OUT:
+            case PGRES_COPY_BOTH:
+               return nrv;
+            default:
+               break;
+         }
+      }
+      if( nrv == nullptr ) {
+         throw std::runtime_error( "PQgetResult() failed: " + error_message() );
+      }
+      return nrv;
+   }
+
+   auto connection::execute_params( const statement_event::time_point started,
+                                    const char* statement,
                                     const int n_params,
                                     const Oid types[],
                                     const char* const values[],
                                     const int lengths[],
                                     const int formats[] ) -> result
    {
-      if( is_prepared( statement ) ) {
-         return result( PQexecPrepared( m_pgconn.get(), statement, n_params, values, lengths, formats, 0 ) );
+      if( !m_observer ) {
+         const bool prepared = is_prepared( statement );
+         PGresult* r = prepared ? PQexecPrepared( m_pgconn.get(), statement, n_params, values, lengths, formats, 0 ) : PQexecParams( m_pgconn.get(), statement, n_params, types, values, lengths, formats, 0 );
+         m_wire.round_trip();
+         m_wire.exchanged( internal::statement_wire_size( statement, prepared, n_params, values, lengths, formats ), internal::response_overhead( prepared ) );
+         m_wire.result( r );
+         return result( r );
+      }
+
+      statement_event event;
+      event.connection = this;
+      event.statement = statement;
+      event.prepared = is_prepared( statement );
+      event.parameters = n_params;
+      event.values = values;
+      event.lengths = lengths;
+      event.formats = formats;
+      event.started = ( started == statement_event::time_point() ) ? statement_event::clock::now() : started;
+
+      const auto annotation = m_observer->annotate( *this, statement );
+      if( !annotation.application_name.empty() && ( annotation.application_name != m_application_name ) ) {
+         set_application_name( annotation.application_name );
+      }
+      std::string annotated;
+      if( !event.prepared && !annotation.comment.empty() ) {
+         annotated = "/* " + annotation.comment + " */ " + statement;
+      }
+      const char* sent_statement = annotated.empty() ? statement : annotated.c_str();
+      event.encoded = statement_event::clock::now();
+
+      try {
+         event.bytes_sent = send_params( sent_statement, n_params, types, values, lengths, formats );
+         event.sent = statement_event::clock::now();
+         wait_for_result( event );
+         result nrv( get_result() );
+         event.decoded = statement_event::clock::now();
+         event.rows = ( nrv.columns() != 0 ) ? nrv.size() : 0;
+         m_observer->on_statement( event );
+         return nrv;
+      }
+      catch( const std::exception& e ) {
+         const auto now = statement_event::clock::now();
+         for( auto* tp : { &event.sent, &event.responded, &event.received, &event.decoded } ) {
+            if( *tp == statement_event::time_point() ) {
+               *tp = now;
+            }
+         }
+         event.error = e.what();
+         m_observer->on_statement( event );
+         throw;
       }
-      return result( PQexecParams( m_pgconn.get(), statement, n_params, types, values, lengths, formats, 0 ) );
    }
 
    connection::connection( const connection::private_key& /*unused*/, const std::string& connection_info )
@@ -212,10 +391,36 @@ namespace tao::pq
       return PQstatus( m_pgconn.get() ) == CONNECTION_OK;
    }
 
+   void connection::set_observer( std::shared_ptr< pq::observer > observer ) noexcept
+   {
+      m_observer = std::move( observer );
+   }
+
+   void connection::load_types( const std::vector< std::string >& names )
+   {
+      set_types( type_catalog::load( direct(), names ) );
+   }
+
+   void connection::set_types( std::shared_ptr< const type_catalog > types ) noexcept
+   {
+      m_types = std::move( types );
+   }
+
+   auto connection::types() const noexcept -> const type_catalog&
+   {
+      static const type_catalog empty;
+      return m_types ? *m_types : empty;
+   }
+
    void connection::prepare( const std::string& name, const std::string& statement )
    {
       check_prepared_name( name );
-      result( PQprepare( m_pgconn.get(), name.c_str(), statement.c_str(), 0, nullptr ) );  // NOLINT(bugprone-unused-raii)
+      PGresult* r = PQprepare( m_pgconn.get(), name.c_str(), statement.c_str(), 0, nullptr );
+      // Parse and Sync, answered by ParseComplete and ReadyForQuery
+      m_wire.round_trip();
+      m_wire.exchanged( 8 + name.size() + 1 + statement.size() + 1 + 5, 5 + 6 );
+      m_wire.result( r );
+      (void)result( r );
       m_prepared_statements.insert( name );
    }
 
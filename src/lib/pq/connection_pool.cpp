@@ -3,6 +3,12 @@
 
 #include <tao/pq/connection_pool.hpp>
 
+#include <atomic>
+#include <exception>
+#include <utility>
+
+#include <tao/pq/internal/statement_key.hpp>
+
 namespace tao::pq
 {
    auto connection_pool::v_create() const -> std::unique_ptr< pq::connection >
@@ -15,6 +21,83 @@ namespace tao::pq
       return c.is_open();
    }
 
+   void connection_pool::set_observer( std::shared_ptr< pq::observer > observer ) noexcept
+   {
+      std::atomic_store( &m_observer, std::move( observer ) );
+   }
+
+   auto connection_pool::observer() const noexcept -> std::shared_ptr< pq::observer >
+   {
+      return std::atomic_load( &m_observer );
+   }
+
+   void connection_pool::load_types( const std::vector< std::string >& names )
+   {
+      std::atomic_store( &m_types, type_catalog::load( this->connection()->direct(), names ) );
+   }
+
+   auto connection_pool::types() const noexcept -> std::shared_ptr< const type_catalog >
+   {
+      return std::atomic_load( &m_types );
+   }
+
+   auto connection_pool::connection() -> std::shared_ptr< pq::connection >
+   {
+      auto nrv = this->get();
+      nrv->set_observer( observer() );
+      if( auto t = types() ) {
+         nrv->set_types( std::move( t ) );
+      }
+      return nrv;
+   }
+
+   auto connection_pool::execute_coalesced_params( std::shared_ptr< pq::connection >& c,
+                                                   const char* statement,
+                                                   const int n_params,
+                                                   const Oid types[],
+                                                   const char* const values[],
+                                                   const int lengths[],
+                                                   const int formats[] ) -> result
+   {
+      const auto key = internal::statement_key( statement, n_params, types, values, lengths, formats );
+
+      std::promise< result > promise;
+      {
+         std::unique_lock lock( m_flights_mutex );
+         const auto it = m_flights.find( key );
+         if( it != m_flights.end() ) {
+            const auto flight = it->second;
+            lock.unlock();
+            m_coalesced.fetch_add( 1, std::memory_order_relaxed );
+            return flight.get();
+         }
+         m_flights.emplace( key, promise.get_future().share() );
+      }
+
+      try {
+         if( !c ) {
+            c = this->connection();
+         }
+         const auto tr = c->direct();
+         const auto started = c->m_observer ? statement_event::clock::now() : statement_event::time_point();
+         auto nrv = c->execute_params( started, statement, n_params, types, values, lengths, formats );
+         {
+            const std::lock_guard lock( m_flights_mutex );
+            m_flights.erase( key );
+         }
+         promise.set_value( nrv );
+         return nrv;
+      }
+      catch( ... ) {
+         {
+            const std::lock_guard lock( m_flights_mutex );
+            m_flights.erase( key );
+         }
+         promise.set_exception( std::current_exception() );
+         throw;
+      }
+   }
+
    auto connection_pool::create( const std::string& connection_info ) -> std::shared_ptr< connection_pool >
    {
       return std::make_shared< connection_pool >( connection_pool::private_key(), connection_info );
@@ -0,0 +1,82 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include <tao/pq/internal/copy_format.hpp>
+
+#include <cstdint>
+
+namespace tao::pq::internal
+{
+   namespace
+   {
+      void put16( std::string& data, const std::int16_t v )
+      {
+         const auto u = static_cast< std::uint16_t >( v );
+         data += static_cast< char >( ( u >> 8 ) & 0xff );
+         data += static_cast< char >( u & 0xff );
+      }
+
+      void put32( std::string& data, const std::int32_t v )
+      {
+         const auto u = static_cast< std::uint32_t >( v );
+         for( int shift = 24; shift >= 0; shift -= 8 ) {
+            data += static_cast< char >( ( u >> shift ) & 0xff );
+         }
+      }
+
+   }  // namespace
+
+   void append_copy_text( std::string& data, const char* value )
+   {
+      if( value == nullptr ) {
+         data += "\\N";
+         return;
+      }
+      for( ; *value != '\0'; ++value ) {
+         switch( *value ) {
+            case '\\':
+               data += "\\\\";
+               break;
+            case '\t':
+               data += "\\t";
+               break;
+            case '\n':
+               data += "\\n";
+               break;
+            case '\r':
+               data += "\\r";
+               break;
+            default:
+               data += *value;
+         }
+      }
+   }
+
+   void append_copy_binary_header( std::string& data )
+   {
+      data.append( "PGCOPY\n\377\r\n\0", 11 );
+      put32( data, 0 );  // flags
+      put32( data, 0 );  // header extension
+   }
+
+   void append_copy_binary_row( std::string& data, const int fields )
+   {
+      put16( data, static_cast< std::int16_t >( fields ) );
+   }
+
+   void append_copy_binary_field( std::string& data, const char* value, const int length )
+   {
+      if( value == nullptr ) {
+         put32( data, -1 );
+         return;
+      }
+      put32( data, length );
+      data.append( value, static_cast< std::size_t >( length ) );
+   }
+
+   void append_copy_binary_trailer( std::string& data )
+   {
+      put16( data, -1 );
+   }
+
+}  // namespace tao::pq::internal
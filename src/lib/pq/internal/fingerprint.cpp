@@ -0,0 +1,126 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include <cctype>
+
+#include <tao/pq/internal/fingerprint.hpp>
+
+namespace tao::pq::internal
+{
+   namespace
+   {
+      [[nodiscard]] auto is_identifier_char( const char c ) noexcept -> bool
+      {
+         return ( std::isalnum( static_cast< unsigned char >( c ) ) != 0 ) || ( c == '_' ) || ( c == '$' ) || ( static_cast< unsigned char >( c ) >= 0x80 );
+      }
+
+      // returns the position after a quoted section starting at pos, quotes are escaped by doubling them
+      [[nodiscard]] auto skip_quoted( const std::string_view s, std::size_t pos, const char quote, const bool backslash ) noexcept -> std::size_t
+      {
+         ++pos;
+         while( pos < s.size() ) {
+            if( backslash && ( s[ pos ] == '\\' ) ) {
+               pos += 2;
+            }
+            else if( s[ pos ] == quote ) {
+               if( ( pos + 1 < s.size() ) && ( s[ pos + 1 ] == quote ) ) {
+                  pos += 2;
+               }
+               else {
+                  return pos + 1;
+               }
+            }
+            else {
+               ++pos;
+            }
+         }
+         return s.size();
+      }
+
+      // returns the length of a dollar quote tag like $$ or $tag$ at pos, or zero
+      [[nodiscard]] auto dollar_tag( const std::string_view s, const std::size_t pos ) noexcept -> std::size_t
+      {
+         std::size_t end = pos + 1;
+         while( ( end < s.size() ) && ( s[ end ] != '$' ) ) {
+            const char c = s[ end ];
+            if( !( std::isalpha( static_cast< unsigned char >( c ) ) != 0 || c == '_' || ( ( end > pos + 1 ) && ( std::isdigit( static_cast< unsigned char >( c ) ) != 0 ) ) ) ) {
+               return 0;
+            }
+            ++end;
+         }
+         return ( end < s.size() ) ? ( end - pos + 1 ) : 0;
+      }
+
+   }  // namespace
+
+   auto fingerprint( const std::string_view statement ) -> std::string
+   {
+      std::string nrv;
+      nrv.reserve( statement.size() );
+      bool space = false;
+      const auto append = [ & ]( const std::string_view token ) {
+         if( space && !nrv.empty() ) {
+            nrv += ' ';
+         }
+         space = false;
+         nrv += token;
+      };
+      std::size_t pos = 0;
+      while( pos < statement.size() ) {
+         const char c = statement[ pos ];
+         const bool after_identifier = ( pos > 0 ) && is_identifier_char( statement[ pos - 1 ] );
+         if( std::isspace( static_cast< unsigned char >( c ) ) != 0 ) {
+            space = true;
+            ++pos;
+         }
+         else if( ( c == '-' ) && ( pos + 1 < statement.size() ) && ( statement[ pos + 1 ] == '-' ) ) {
+            while( ( pos < statement.size() ) && ( statement[ pos ] != '\n' ) ) {
+               ++pos;
+            }
+            space = true;
+         }
+         else if( ( c == '/' ) && ( pos + 1 < statement.size() ) && ( statement[ pos + 1 ] == '*' ) ) {
+            const auto end = statement.find( "*/", pos + 2 );
+            pos = ( end == std::string_view::npos ) ? statement.size() : ( end + 2 );
+            space = true;
+         }
+         else if( c == '\'' ) {
+            // E'...' style strings allow backslash escapes
+            const bool escaped = after_identifier && ( ( statement[ pos - 1 ] == 'E' ) || ( statement[ pos - 1 ] == 'e' ) ) && ( ( pos == 1 ) || !is_identifier_char( statement[ pos - 2 ] ) );
+            if( escaped ) {
+               nrv.pop_back();
+            }
+            pos = skip_quoted( statement, pos, '\'', escaped );
+            append( "?" );
+         }
+         else if( c == '"' ) {
+            const auto end = skip_quoted( statement, pos, '"', false );
+            append( statement.substr( pos, end - pos ) );
+            pos = end;
+         }
+         else if( ( c == '$' ) && !after_identifier && ( dollar_tag( statement, pos ) != 0 ) ) {
+            const auto size = dollar_tag( statement, pos );
+            const auto end = statement.find( statement.substr( pos, size ), pos + size );
+            pos = ( end == std::string_view::npos ) ? statement.size() : ( end + size );
+            append( "?" );
+         }
+         else if( ( std::isdigit( static_cast< unsigned char >( c ) ) != 0 ) && !after_identifier ) {
+            while( ( pos < statement.size() ) && ( ( std::isalnum( static_cast< unsigned char >( statement[ pos ] ) ) != 0 ) || ( statement[ pos ] == '.' ) || ( ( ( statement[ pos ] == '+' ) || ( statement[ pos ] == '-' ) ) && ( ( statement[ pos - 1 ] == 'e' ) || ( statement[ pos - 1 ] == 'E' ) ) ) ) ) {
+               ++pos;
+            }
+            append( "?" );
+         }
+         else {
+            const auto begin = pos++;
+            if( is_identifier_char( c ) ) {
+               while( ( pos < statement.size() ) && is_identifier_char( statement[ pos ] ) ) {
+                  ++pos;
+               }
+            }
+            append( statement.substr( begin, pos - begin ) );
+         }
+      }
+      return nrv;
+   }
+
+}  // namespace tao::pq::internal
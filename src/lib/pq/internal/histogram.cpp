@@ -0,0 +1,66 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include <algorithm>
+#include <cmath>
+
+#include <tao/pq/internal/histogram.hpp>
+
+namespace tao::pq::internal
+{
+   auto histogram_snapshot::operator+=( const histogram_snapshot& other ) noexcept -> histogram_snapshot&
+   {
+      for( std::size_t i = 0; i < histogram_buckets::size; ++i ) {
+         m_counts[ i ] += other.m_counts[ i ];
+      }
+      m_count += other.m_count;
+      m_sum += other.m_sum;
+      m_max = std::max( m_max, other.m_max );
+      return *this;
+   }
+
+   auto histogram_snapshot::percentile( const double fraction ) const noexcept -> std::uint64_t
+   {
+      if( m_count == 0 ) {
+         return 0;
+      }
+      const auto rank = std::max< std::uint64_t >( 1, static_cast< std::uint64_t >( std::ceil( fraction * static_cast< double >( m_count ) ) ) );
+      std::uint64_t seen = 0;
+      for( std::size_t i = 0; i < histogram_buckets::size; ++i ) {
+         seen += m_counts[ i ];
+         if( seen >= rank ) {
+            if( i + 1 == histogram_buckets::size ) {
+               return m_max;
+            }
+            // report the middle of the bucket, but never more than was actually seen
+            const auto lower = histogram_buckets::lower_bound( i );
+            const auto upper = histogram_buckets::lower_bound( i + 1 );
+            return std::min( m_max, lower + ( upper - lower ) / 2 );
+         }
+      }
+      return m_max;  // LCOV_EXCL_LINE
+   }
+
+   auto histogram_snapshot::count_below( const std::uint64_t bound ) const noexcept -> std::uint64_t
+   {
+      // only buckets the largest value of which is within the bound, the last bucket is unbounded
+      std::uint64_t nrv = 0;
+      for( std::size_t i = 0; ( i + 1 < histogram_buckets::size ) && ( histogram_buckets::lower_bound( i + 1 ) - 1 <= bound ); ++i ) {
+         nrv += m_counts[ i ];
+      }
+      return nrv;
+   }
+
+   auto histogram::snapshot() const noexcept -> histogram_snapshot
+   {
+      histogram_snapshot nrv;
+      for( std::size_t i = 0; i < histogram_buckets::size; ++i ) {
+         nrv.m_counts[ i ] = m_counts[ i ].load( std::memory_order_relaxed );
+         nrv.m_count += nrv.m_counts[ i ];
+      }
+      nrv.m_sum = m_sum.load( std::memory_order_relaxed );
+      nrv.m_max = m_max.load( std::memory_order_relaxed );
+      return nrv;
+   }
+
+}  // namespace tao::pq::internal
@@ -0,0 +1,41 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include <tao/pq/internal/json.hpp>
+#include <tao/pq/internal/printf.hpp>
+
+namespace tao::pq::internal
+{
+   void json_string( std::string& out, const std::string_view value )
+   {
+      out += '"';
+      for( const char c : value ) {
+         switch( c ) {
+            case '"':
+               out += "\\\"";
+               break;
+            case '\\':
+               out += "\\\\";
+               break;
+            case '\n':
+               out += "\\n";
+               break;
+            case '\r':
+               out += "\\r";
+               break;
+            case '\t':
+               out += "\\t";
+               break;
+            default:
+               if( static_cast< unsigned char >( c ) < 0x20 ) {
+                  out += printf( "\\u%04x", static_cast< unsigned >( c ) );
+               }
+               else {
+                  out += c;
+               }
+         }
+      }
+      out += '"';
+   }
+
+}  // namespace tao::pq::internal
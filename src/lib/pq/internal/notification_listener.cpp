@@ -0,0 +1,131 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include <tao/pq/internal/notification_listener.hpp>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include <libpq-fe.h>
+
+#include <tao/pq/connection.hpp>
+#include <tao/pq/internal/poll.hpp>
+#include <tao/pq/internal/quote.hpp>
+
+namespace tao::pq::internal
+{
+   namespace
+   {
+#ifdef WIN32
+      // without a wakeup, the listener checks for a stop periodically
+      constexpr int poll_timeout_ms = 100;
+#else
+      constexpr int poll_timeout_ms = -1;
+#endif
+
+   }  // namespace
+
+   void notification_listener::connect()
+   {
+      m_connection = connection::create( m_connection_info );
+      m_connection->execute( "LISTEN " + quote_identifier( m_channel ) );
+      m_listening.store( true, std::memory_order_relaxed );
+      if( m_callbacks.connected ) {
+         m_callbacks.connected();
+      }
+      // notifications might have arrived with the result of LISTEN
+      receive();
+   }
+
+   void notification_listener::receive()
+   {
+      PGconn* pgconn = m_connection->underlying_raw_ptr();
+      if( PQconsumeInput( pgconn ) == 0 ) {
+         throw std::runtime_error( std::string( "PQconsumeInput() failed: " ) + PQerrorMessage( pgconn ) );
+      }
+      while( PGnotify* notify = PQnotifies( pgconn ) ) {
+         const std::string payload = notify->extra;
+         PQfreemem( notify );
+         m_callbacks.notification( payload );
+      }
+   }
+
+   auto notification_listener::stopped() -> bool
+   {
+      const std::lock_guard lock( m_mutex );
+      return m_stop;
+   }
+
+   void notification_listener::listen() noexcept
+   {
+      while( !stopped() ) {
+         try {
+            if( !m_connection ) {
+               connect();
+            }
+            (void)poll( PQsocket( m_connection->underlying_raw_ptr() ), false, m_wakeup[ 0 ], poll_timeout_ms );
+            receive();
+         }
+         catch( ... ) {
+            m_listening.store( false, std::memory_order_relaxed );
+            m_connection.reset();
+            if( m_callbacks.disconnected ) {
+               m_callbacks.disconnected();
+            }
+            std::unique_lock lock( m_mutex );
+            m_condition.wait_for( lock, m_reconnect_interval, [ this ] { return m_stop; } );
+         }
+      }
+   }
+
+   notification_listener::notification_listener( const std::string& connection_info, const std::string& channel, const std::chrono::milliseconds reconnect_interval, callbacks cb )  // NOLINT(modernize-pass-by-value)
+      : m_connection_info( connection_info ),
+        m_channel( channel ),
+        m_reconnect_interval( reconnect_interval ),
+        m_callbacks( std::move( cb ) )
+   {
+      connect();
+#ifndef WIN32
+      if( ::pipe( m_wakeup ) != 0 ) {
+         throw std::system_error( errno, std::system_category(), "pipe() failed" );  // LCOV_EXCL_LINE
+      }
+      for( const int fd : m_wakeup ) {
+         (void)::fcntl( fd, F_SETFL, ::fcntl( fd, F_GETFL ) | O_NONBLOCK );
+      }
+#endif
+      try {
+         m_thread = std::thread( [ this ] { listen(); } );
+      }
+      catch( ... ) {
+#ifndef WIN32
+         ::close( m_wakeup[ 0 ] );
+         ::close( m_wakeup[ 1 ] );
+#endif
+         throw;
+      }
+   }
+
+   notification_listener::~notification_listener()
+   {
+      {
+         const std::lock_guard lock( m_mutex );
+         m_stop = true;
+      }
+      m_condition.notify_all();
+#ifndef WIN32
+      (void)::write( m_wakeup[ 1 ], "", 1 );
+#endif
+      m_thread.join();
+#ifndef WIN32
+      ::close( m_wakeup[ 0 ] );
+      ::close( m_wakeup[ 1 ] );
+#endif
+   }
+
+}  // namespace tao::pq::internal
@@ -0,0 +1,76 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#ifdef WIN32
+#include <winsock2.h>
+#else
+#include <cerrno>
+#include <poll.h>
+#endif
+
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <tao/pq/internal/poll.hpp>
+
+namespace tao::pq::internal
+{
+   auto poll( const int socket, const bool wait_for_write, const int timeout_ms ) -> bool
+   {
+#ifdef WIN32
+      WSAPOLLFD pfd = {};
+      pfd.fd = static_cast< SOCKET >( socket );
+      pfd.events = wait_for_write ? POLLWRNORM : POLLRDNORM;
+      const int r = ::WSAPoll( &pfd, 1, timeout_ms );
+      if( r == SOCKET_ERROR ) {
+         throw std::system_error( ::WSAGetLastError(), std::system_category(), "WSAPoll() failed" );
+      }
+      return r != 0;
+#else
+      pollfd pfd = {};
+      pfd.fd = socket;
+      pfd.events = wait_for_write ? POLLOUT : POLLIN;
+      while( true ) {
+         const int r = ::poll( &pfd, 1, timeout_ms );
+         if( r >= 0 ) {
+            return r != 0;
+         }
+         if( errno != EINTR ) {
+            throw std::system_error( errno, std::system_category(), "poll() failed" );
+         }
+      }
+#endif
+   }
+
+   auto poll( const int socket, const bool wait_for_write, const int wakeup, const int timeout_ms ) -> bool
+   {
+#ifdef WIN32
+      // there is nothing like a pipe for WSAPoll(), the caller has to use a timeout
+      WSAPOLLFD pfd = {};
+      pfd.fd = static_cast< SOCKET >( socket );
+      pfd.events = POLLRDNORM | ( wait_for_write ? POLLWRNORM : 0 );
+      const int r = ::WSAPoll( &pfd, 1, timeout_ms );
+      if( r == SOCKET_ERROR ) {
+         throw std::system_error( ::WSAGetLastError(), std::system_category(), "WSAPoll() failed" );
+      }
+      return r != 0;
+#else
+      pollfd pfd[ 2 ] = {};
+      pfd[ 0 ].fd = socket;
+      pfd[ 0 ].events = POLLIN | ( wait_for_write ? POLLOUT : 0 );
+      pfd[ 1 ].fd = wakeup;
+      pfd[ 1 ].events = POLLIN;
+      while( true ) {
+         const int r = ::poll( pfd, ( wakeup < 0 ) ? 1 : 2, timeout_ms );
+         if( r >= 0 ) {
+            return r != 0;
+         }
+         if( errno != EINTR ) {
+            throw std::system_error( errno, std::system_category(), "poll() failed" );
+         }
+      }
+#endif
+   }
+
+}  // namespace tao::pq::internal
@@ -0,0 +1,35 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include <tao/pq/internal/quote.hpp>
+
+namespace tao::pq::internal
+{
+   namespace
+   {
+      [[nodiscard]] auto quote( const std::string& s, const char q ) -> std::string
+      {
+         std::string nrv( 1, q );
+         for( const char c : s ) {
+            if( c == q ) {
+               nrv += q;
+            }
+            nrv += c;
+         }
+         nrv += q;
+         return nrv;
+      }
+
+   }  // namespace
+
+   auto quote_identifier( const std::string& identifier ) -> std::string
+   {
+      return quote( identifier, '"' );
+   }
+
+   auto quote_literal( const std::string& literal ) -> std::string
+   {
+      return quote( literal, '\'' );
+   }
+
+}  // namespace tao::pq::internal
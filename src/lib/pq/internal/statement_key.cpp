@@ -0,0 +1,35 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include <cstring>
+
+#include <tao/pq/internal/statement_key.hpp>
+
+namespace tao::pq::internal
+{
+   auto statement_key( const char* statement,
+                       const int n_params,
+                       const Oid types[],
+                       const char* const values[],
+                       const int lengths[],
+                       const int formats[] ) -> std::string
+   {
+      std::string nrv = statement;
+      nrv += '\0';
+      for( int i = 0; i < n_params; ++i ) {
+         nrv.append( reinterpret_cast< const char* >( &types[ i ] ), sizeof( Oid ) );
+         nrv += static_cast< char >( formats[ i ] );
+         if( values[ i ] == nullptr ) {
+            nrv += 'N';
+         }
+         else {
+            const auto length = ( formats[ i ] != 0 ) ? static_cast< std::size_t >( lengths[ i ] ) : std::strlen( values[ i ] );
+            nrv += 'V';
+            nrv.append( reinterpret_cast< const char* >( &length ), sizeof( length ) );
+            nrv.append( values[ i ], length );
+         }
+      }
+      return nrv;
+   }
+
+}  // namespace tao::pq::internal
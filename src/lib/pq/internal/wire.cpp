@@ -0,0 +1,117 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include <cstring>
+
+#include <libpq-fe.h>
+
+#include <tao/pq/internal/wire.hpp>
+
+namespace tao::pq::internal
+{
+   namespace
+   {
+      // type byte, length and terminating zero
+      [[nodiscard]] auto message_size( const char* s ) noexcept -> std::size_t
+      {
+         return 1 + 4 + std::strlen( s ) + 1;
+      }
+
+      [[nodiscard]] auto error_size( const PGresult* result ) noexcept -> std::size_t
+      {
+         static constexpr int fields[] = { PG_DIAG_SEVERITY,
+                                           PG_DIAG_SEVERITY_NONLOCALIZED,
+                                           PG_DIAG_SQLSTATE,
+                                           PG_DIAG_MESSAGE_PRIMARY,
+                                           PG_DIAG_MESSAGE_DETAIL,
+                                           PG_DIAG_MESSAGE_HINT,
+                                           PG_DIAG_STATEMENT_POSITION,
+                                           PG_DIAG_INTERNAL_POSITION,
+                                           PG_DIAG_INTERNAL_QUERY,
+                                           PG_DIAG_CONTEXT,
+                                           PG_DIAG_SCHEMA_NAME,
+                                           PG_DIAG_TABLE_NAME,
+                                           PG_DIAG_COLUMN_NAME,
+                                           PG_DIAG_DATATYPE_NAME,
+                                           PG_DIAG_CONSTRAINT_NAME,
+                                           PG_DIAG_SOURCE_FILE,
+                                           PG_DIAG_SOURCE_LINE,
+                                           PG_DIAG_SOURCE_FUNCTION };
+         std::size_t nrv = 1 + 4 + 1;
+         for( const int field : fields ) {
+            if( const char* value = PQresultErrorField( result, field ) ) {
+               nrv += 1 + std::strlen( value ) + 1;
+            }
+         }
+         return nrv;
+      }
+
+   }  // namespace
+
+   auto statement_wire_size( const char* statement,
+                             const bool prepared,
+                             const int n_params,
+                             const char* const values[],
+                             const int lengths[],
+                             const int formats[] ) noexcept -> std::size_t
+   {
+      const std::size_t statement_size = std::strlen( statement ) + 1;
+      std::size_t nrv = prepared ? 0 : ( 7 + 1 + statement_size + 4 * n_params );
+      nrv += 14 + ( prepared ? statement_size : 1 ) + ( ( formats != nullptr ) ? 2 * n_params : 0 );
+      for( int i = 0; i < n_params; ++i ) {
+         nrv += 4;
+         if( values[ i ] != nullptr ) {
+            nrv += ( ( formats != nullptr ) && ( formats[ i ] != 0 ) ) ? lengths[ i ] : std::strlen( values[ i ] );
+         }
+      }
+      return nrv + 7 + 10 + 5;
+   }
+
+   auto result_wire_size( const PGresult* result ) noexcept -> std::size_t
+   {
+      if( result == nullptr ) {
+         return 0;
+      }
+      const int columns = PQnfields( result );
+      std::size_t nrv = 0;
+      switch( PQresultStatus( result ) ) {
+         case PGRES_TUPLES_OK:
+         case PGRES_SINGLE_TUPLE:
+            nrv += 1 + 4 + 2;
+            for( int column = 0; column < columns; ++column ) {
+               nrv += std::strlen( PQfname( result, column ) ) + 1 + 18;
+            }
+            for( int row = 0; row < PQntuples( result ); ++row ) {
+               nrv += 1 + 4 + 2;
+               for( int column = 0; column < columns; ++column ) {
+                  nrv += 4 + ( ( PQgetisnull( result, row, column ) != 0 ) ? 0 : PQgetlength( result, row, column ) );
+               }
+            }
+            [[fallthrough]];
+
+         case PGRES_COMMAND_OK:
+            // PQcmdStatus() does not modify the result
+            if( const char* status = PQcmdStatus( const_cast< PGresult* >( result ) ); ( status != nullptr ) && ( *status != '\0' ) ) {  // NOLINT(cppcoreguidelines-pro-type-const-cast)
+               nrv += message_size( status );
+            }
+            return nrv;
+
+         case PGRES_EMPTY_QUERY:
+            return 1 + 4;
+
+         case PGRES_COPY_IN:
+         case PGRES_COPY_OUT:
+         case PGRES_COPY_BOTH:
+            return 1 + 4 + 1 + 2 + 2 * static_cast< std::size_t >( columns );
+
+         case PGRES_BAD_RESPONSE:
+         case PGRES_NONFATAL_ERROR:
+         case PGRES_FATAL_ERROR:
+            return error_size( result );
+
+         default:
+            return 0;
+      }
+   }
+
+}  // namespace tao::pq::internal
@@ -0,0 +1,205 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include <tao/pq/job_queue.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include <tao/pq/internal/copy_format.hpp>
+#include <tao/pq/internal/quote.hpp>
+
+#include <tao/pq/result.hpp>
+#include <tao/pq/table_writer.hpp>
+
+namespace tao::pq
+{
+   namespace
+   {
+      [[nodiscard]] auto unique_name() -> std::string
+      {
+         static std::atomic< std::uint64_t > queues( 0 );
+         return "taopq_job_queue_" + std::to_string( queues++ );
+      }
+
+   }  // namespace
+
+   job_batch::job_batch( const std::shared_ptr< transaction >& tr, std::vector< job >&& jobs, const std::string& acknowledge )  // NOLINT(modernize-pass-by-value)
+      : m_transaction( tr ),
+        m_jobs( std::move( jobs ) ),
+        m_acknowledge( acknowledge )
+   {}
+
+   void job_batch::acknowledge()
+   {
+      std::vector< std::int64_t > ids;
+      ids.reserve( m_jobs.size() );
+      for( const auto& j : m_jobs ) {
+         ids.push_back( j.id );
+      }
+      acknowledge( ids );
+   }
+
+   void job_batch::acknowledge( const std::vector< std::int64_t >& ids )
+   {
+      if( !m_transaction ) {
+         throw std::logic_error( "job batch already finished" );
+      }
+      if( !ids.empty() ) {
+         m_transaction->execute( m_acknowledge, ids );
+      }
+      m_transaction->commit();
+      m_transaction.reset();
+   }
+
+   void job_batch::release()
+   {
+      if( m_transaction ) {
+         m_transaction->rollback();
+         m_transaction.reset();
+      }
+   }
+
+   void job_queue::prepare( pq::connection& c )
+   {
+      if( !c.is_prepared( m_dequeue.c_str() ) ) {
+         c.prepare( m_dequeue, "SELECT id, payload FROM " + m_options.table + " ORDER BY id LIMIT $1 FOR UPDATE SKIP LOCKED" );
+         c.prepare( m_acknowledge, "DELETE FROM " + m_options.table + " WHERE id = ANY( $1::BIGINT[] )" );
+         c.prepare( m_insert, "INSERT INTO " + m_options.table + " ( payload ) VALUES ( $1 )" );
+      }
+   }
+
+   void job_queue::notify( const std::shared_ptr< transaction >& tr )
+   {
+      if( !m_options.channel.empty() ) {
+         tr->execute( "NOTIFY " + internal::quote_identifier( m_options.channel ) );
+      }
+   }
+
+   void job_queue::enqueue( const std::string& payload )
+   {
+      const auto c = m_pool->connection();
+      prepare( *c );
+      const auto tr = c->direct();
+      tr->execute( m_insert, payload );
+      m_enqueued.fetch_add( 1, std::memory_order_relaxed );
+      notify( tr );
+   }
+
+   void job_queue::enqueue( const std::vector< std::string >& payloads )
+   {
+      if( payloads.empty() ) {
+         return;
+      }
+      const auto tr = m_pool->connection()->transaction();
+      enqueue( tr, payloads );
+      tr->commit();
+   }
+
+   void job_queue::enqueue( const std::shared_ptr< transaction >& tr, const std::vector< std::string >& payloads )
+   {
+      if( payloads.empty() ) {
+         return;
+      }
+      {
+         table_writer tw( tr, "COPY " + m_options.table + " ( payload ) FROM STDIN" );
+         std::string data;
+         for( const auto& payload : payloads ) {
+            internal::append_copy_text( data, payload.c_str() );
+            data += '\n';
+            if( data.size() >= internal::copy_chunk_size ) {
+               tw.insert( data );
+               data.clear();
+            }
+         }
+         if( !data.empty() ) {
+            tw.insert( data );
+         }
+         (void)tw.finish();
+      }
+      m_enqueued.fetch_add( payloads.size(), std::memory_order_relaxed );
+      notify( tr );
+   }
+
+   auto job_queue::try_dequeue() -> job_batch
+   {
+      const auto c = m_pool->connection();
+      prepare( *c );
+      const auto tr = c->transaction();
+      const auto r = tr->execute( m_dequeue, m_options.batch_size );
+      if( r.empty() ) {
+         tr->commit();
+         return job_batch();
+      }
+      std::vector< job > jobs;
+      jobs.reserve( r.size() );
+      for( const auto& row : r ) {
+         jobs.push_back( { row.get< std::int64_t >( 0 ), row.get< std::string >( 1 ) } );
+      }
+      m_dequeued.fetch_add( jobs.size(), std::memory_order_relaxed );
+      return job_batch( tr, std::move( jobs ), m_acknowledge );
+   }
+
+   auto job_queue::dequeue( const std::chrono::milliseconds timeout ) -> job_batch
+   {
+      const auto deadline = std::chrono::steady_clock::now() + timeout;
+      while( true ) {
+         std::uint64_t seen = 0;
+         {
+            const std::lock_guard lock( m_mutex );
+            seen = m_notifications;
+         }
+         auto nrv = try_dequeue();
+         if( !nrv.empty() ) {
+            return nrv;
+         }
+         std::unique_lock lock( m_mutex );
+         const auto now = std::chrono::steady_clock::now();
+         if( now >= deadline ) {
+            return nrv;
+         }
+         m_condition.wait_until( lock, std::min( deadline, now + m_options.poll_interval ), [ & ] { return m_notifications != seen; } );
+      }
+   }
+
+   // wakes the waiting workers
+   void job_queue::wake()
+   {
+      {
+         const std::lock_guard lock( m_mutex );
+         ++m_notifications;
+      }
+      m_condition.notify_all();
+   }
+
+   job_queue::job_queue( const private_key& /*unused*/, const std::shared_ptr< connection_pool >& pool, const job_queue_options& options )  // NOLINT(modernize-pass-by-value)
+      : m_pool( pool ),
+        m_options( options ),
+        m_name( unique_name() ),
+        m_dequeue( m_name + "_dequeue" ),
+        m_acknowledge( m_name + "_acknowledge" ),
+        m_insert( m_name + "_insert" )
+   {
+      if( m_options.batch_size == 0 ) {
+         throw std::invalid_argument( "job queue with an empty batch size" );
+      }
+      if( m_options.channel.empty() ) {
+         return;
+      }
+      internal::notification_listener::callbacks cb;
+      cb.notification = [ this ]( const std::string& /*unused*/ ) { wake(); };
+      // jobs might have been enqueued while the listener was disconnected,
+      // until it is connected again the workers fall back to polling
+      cb.connected = [ this ] { wake(); };
+      m_listener = std::make_unique< internal::notification_listener >( m_pool->m_connection_info, m_options.channel, m_options.reconnect_interval, std::move( cb ) );
+   }
+
+   job_queue::~job_queue() = default;
+
+   auto job_queue::create( const std::shared_ptr< connection_pool >& pool, const job_queue_options& options ) -> std::shared_ptr< job_queue >
+   {
+      return std::make_shared< job_queue >( private_key(), pool, options );
+   }
+
+}  // namespace tao::pq
@@ -0,0 +1,69 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include <tao/pq/key_join.hpp>
+
+#include <cctype>
+#include <stdexcept>
+
+namespace tao::pq::internal
+{
+   auto key_type_name( const Oid oid ) noexcept -> const char*
+   {
+      switch( oid ) {
+         case 16:
+            return "BOOLEAN";
+         case 20:
+            return "BIGINT";
+         case 21:
+            return "SMALLINT";
+         case 23:
+            return "INTEGER";
+         case 25:
+            return "TEXT";
+         case 700:
+            return "REAL";
+         case 701:
+            return "DOUBLE PRECISION";
+         default:
+            return nullptr;
+      }
+   }
+
+   void check_key_type( const std::string& type )
+   {
+      int depth = 0;
+      for( const char c : type ) {
+         if( c == '(' ) {
+            ++depth;
+         }
+         else if( c == ')' ) {
+            if( --depth < 0 ) {
+               break;
+            }
+         }
+         else if( ( std::isalnum( static_cast< unsigned char >( c ) ) == 0 ) && ( c != '_' ) && ( c != ' ' ) && ( c != '.' ) && ( c != ',' ) ) {
+            throw std::invalid_argument( "invalid key type: " + type );
+         }
+      }
+      if( depth != 0 ) {
+         throw std::invalid_argument( "invalid key type: " + type );
+      }
+   }
+
+   auto replace_keys( const std::string& statement, const std::string& relation ) -> std::string
+   {
+      static const std::string placeholder = "{keys}";
+      std::string nrv = statement;
+      auto pos = nrv.find( placeholder );
+      if( pos == std::string::npos ) {
+         throw std::invalid_argument( "statement does not refer to {keys}: " + statement );
+      }
+      do {
+         nrv.replace( pos, placeholder.size(), relation );
+         pos = nrv.find( placeholder, pos + relation.size() );
+      } while( pos != std::string::npos );
+      return nrv;
+   }
+
+}  // namespace tao::pq::internal
@@ -0,0 +1,317 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include <tao/pq/multiplexer.hpp>
+
+#if defined( LIBPQ_HAS_PIPELINING )
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <exception>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#include <tao/pq/internal/poll.hpp>
+
+namespace tao::pq
+{
+   namespace internal
+   {
+      struct multiplexed_statement
+      {
+         bool prepare = false;
+         std::string name;  // of the statement to prepare
+         std::string statement;
+
+         // copies of the parameters
+         std::vector< Oid > types;
+         std::vector< std::string > buffers;
+         std::vector< const char* > values;
+         std::vector< int > lengths;
+         std::vector< int > formats;
+
+         std::promise< result > promise;
+         std::unique_ptr< PGresult, decltype( &PQclear ) > pgresult{ nullptr, &PQclear };
+         bool completed = false;  // all results are received, the sync is still outstanding
+      };
+
+   }  // namespace internal
+
+   namespace
+   {
+#ifdef WIN32
+      // without a wakeup, the driver checks the queue periodically
+      constexpr int poll_timeout_ms = 1;
+#else
+      constexpr int poll_timeout_ms = -1;
+#endif
+
+      [[nodiscard]] auto error_message( PGconn* pgconn ) -> std::string
+      {
+         std::string nrv = PQerrorMessage( pgconn );
+         if( !nrv.empty() && ( nrv.back() == '\n' ) ) {
+            nrv.pop_back();
+         }
+         return nrv;
+      }
+
+   }  // namespace
+
+   auto multiplexer::submit( std::unique_ptr< internal::multiplexed_statement > s ) -> std::future< result >
+   {
+      auto nrv = s->promise.get_future();
+      {
+         const std::lock_guard lock( m_mutex );
+         if( m_stopped ) {
+            throw std::runtime_error( "multiplexer stopped" );
+         }
+         m_queue.push_back( std::move( s ) );
+         m_pending.fetch_add( 1, std::memory_order_relaxed );
+      }
+      wakeup();
+      return nrv;
+   }
+
+   auto multiplexer::submit( const char* statement,
+                             const int n_params,
+                             const Oid types[],
+                             const char* const values[],
+                             const int lengths[],
+                             const int formats[] ) -> std::future< result >
+   {
+      auto s = std::make_unique< internal::multiplexed_statement >();
+      s->statement = statement;
+      const auto n = static_cast< std::size_t >( n_params );
+      s->types.assign( types, types + n );
+      s->lengths.assign( lengths, lengths + n );
+      s->formats.assign( formats, formats + n );
+      s->buffers.reserve( n );
+      for( std::size_t i = 0; i < n; ++i ) {
+         if( values[ i ] == nullptr ) {
+            s->buffers.emplace_back();
+         }
+         else if( formats[ i ] != 0 ) {
+            s->buffers.emplace_back( values[ i ], static_cast< std::size_t >( lengths[ i ] ) );
+         }
+         else {
+            s->buffers.emplace_back( values[ i ] );
+         }
+      }
+      s->values.reserve( n );
+      for( std::size_t i = 0; i < n; ++i ) {
+         s->values.push_back( ( values[ i ] == nullptr ) ? nullptr : s->buffers[ i ].c_str() );
+      }
+      return submit( std::move( s ) );
+   }
+
+   void multiplexer::wakeup() noexcept
+   {
+#ifndef WIN32
+      // a full pipe already wakes up the driver
+      (void)::write( m_wakeup[ 1 ], "", 1 );
+#endif
+   }
+
+   void multiplexer::drive() noexcept
+   {
+      PGconn* pgconn = m_connection->underlying_raw_ptr();
+      try {
+         while( send() ) {
+            const int flushed = PQflush( pgconn );
+            if( flushed < 0 ) {
+               throw std::runtime_error( "PQflush() failed: " + error_message( pgconn ) );
+            }
+            (void)internal::poll( PQsocket( pgconn ), flushed == 1, m_wakeup[ 0 ], poll_timeout_ms );
+#ifndef WIN32
+            char buffer[ 64 ];
+            while( ::read( m_wakeup[ 0 ], buffer, sizeof( buffer ) ) > 0 ) {
+            }
+#endif
+            receive();
+         }
+      }
+      catch( ... ) {
+         fail( std::current_exception() );
+      }
+   }
+
+   // moves the queued statements to the pipeline, returns false when stopped and all statements are completed
+   auto multiplexer::send() -> bool
+   {
+      const auto first = m_in_flight.size();
+      {
+         const std::lock_guard lock( m_mutex );
+         if( m_stopped && m_queue.empty() && m_in_flight.empty() ) {
+            return false;
+         }
+         while( !m_queue.empty() ) {
+            m_in_flight.push_back( std::move( m_queue.front() ) );
+            m_queue.pop_front();
+         }
+      }
+      PGconn* pgconn = m_connection->underlying_raw_ptr();
+      for( auto i = first; i < m_in_flight.size(); ++i ) {
+         const auto& s = *m_in_flight[ i ];
+         if( s.prepare ) {
+            if( PQsendPrepare( pgconn, s.name.c_str(), s.statement.c_str(), 0, nullptr ) == 0 ) {
+               throw std::runtime_error( "PQsendPrepare() failed: " + error_message( pgconn ) );
+            }
+            // statements queued after this one may already use the name
+            m_prepared_statements.insert( s.name );
+         }
+         else {
+            const auto n_params = static_cast< int >( s.values.size() );
+            if( m_prepared_statements.find( s.statement ) != m_prepared_statements.end() ) {
+               if( PQsendQueryPrepared( pgconn, s.statement.c_str(), n_params, s.values.data(), s.lengths.data(), s.formats.data(), 0 ) == 0 ) {
+                  throw std::runtime_error( "PQsendQueryPrepared() failed: " + error_message( pgconn ) );
+               }
+            }
+            else {
+               if( PQsendQueryParams( pgconn, s.statement.c_str(), n_params, s.types.data(), s.values.data(), s.lengths.data(), s.formats.data(), 0 ) == 0 ) {
+                  throw std::runtime_error( "PQsendQueryParams() failed: " + error_message( pgconn ) );
+               }
+            }
+         }
+         // isolates errors, the server skips the remaining statements up to the next sync
+         if( PQpipelineSync( pgconn ) == 0 ) {
+            throw std::runtime_error( "PQpipelineSync() failed: " + error_message( pgconn ) );
+         }
+      }
+      return true;
+   }
+
+   // each statement yields its results, a null pointer, and the result of its sync
+   void multiplexer::receive()
+   {
+      PGconn* pgconn = m_connection->underlying_raw_ptr();
+      if( PQconsumeInput( pgconn ) == 0 ) {
+         throw std::runtime_error( "PQconsumeInput() failed: " + error_message( pgconn ) );
+      }
+      while( !m_in_flight.empty() && ( PQisBusy( pgconn ) == 0 ) ) {
+         auto& s = *m_in_flight.front();
+         PGresult* r = PQgetResult( pgconn );
+         if( !s.completed ) {
+            if( r == nullptr ) {
+               s.completed = true;
+               complete( s );
+            }
+            // keep the first error, like connection::get_result()
+            else if( s.pgresult && ( PQresultStatus( s.pgresult.get() ) == PGRES_FATAL_ERROR ) ) {
+               PQclear( r );
+            }
+            else {
+               s.pgresult.reset( r );
+            }
+            continue;
+         }
+         if( r == nullptr ) {
+            break;
+         }
+         const auto status = PQresultStatus( r );
+         PQclear( r );
+         if( status == PGRES_PIPELINE_SYNC ) {
+            m_in_flight.pop_front();
+         }
+      }
+   }
+
+   void multiplexer::complete( internal::multiplexed_statement& s ) noexcept
+   {
+      // before the future is ready, so that pending() does not count it afterwards
+      m_pending.fetch_sub( 1, std::memory_order_relaxed );
+      try {
+         if( !s.pgresult ) {
+            throw std::runtime_error( "PQgetResult() failed: " + error_message( m_connection->underlying_raw_ptr() ) );
+         }
+         s.promise.set_value( result( s.pgresult.release() ) );
+      }
+      catch( ... ) {
+         if( s.prepare ) {
+            m_prepared_statements.erase( s.name );
+         }
+         s.promise.set_exception( std::current_exception() );
+      }
+   }
+
+   // the connection is unusable, all outstanding statements fail
+   void multiplexer::fail( const std::exception_ptr& e ) noexcept
+   {
+      const std::lock_guard lock( m_mutex );
+      m_stopped = true;
+      for( auto* statements : { &m_in_flight, &m_queue } ) {
+         for( const auto& s : *statements ) {
+            if( !s->completed ) {
+               s->promise.set_exception( e );
+            }
+         }
+         statements->clear();
+      }
+      m_pending.store( 0, std::memory_order_relaxed );
+   }
+
+   multiplexer::multiplexer( const private_key& /*unused*/, const std::string& connection_info )
+      : m_connection( connection::create( connection_info ) )
+   {
+      PGconn* pgconn = m_connection->underlying_raw_ptr();
+      if( PQsetnonblocking( pgconn, 1 ) != 0 ) {
+         throw std::runtime_error( "PQsetnonblocking() failed: " + error_message( pgconn ) );  // LCOV_EXCL_LINE
+      }
+      if( PQenterPipelineMode( pgconn ) == 0 ) {
+         throw std::runtime_error( "PQenterPipelineMode() failed: " + error_message( pgconn ) );  // LCOV_EXCL_LINE
+      }
+#ifndef WIN32
+      if( ::pipe( m_wakeup ) != 0 ) {
+         throw std::system_error( errno, std::system_category(), "pipe() failed" );  // LCOV_EXCL_LINE
+      }
+      for( const int fd : m_wakeup ) {
+         (void)::fcntl( fd, F_SETFL, ::fcntl( fd, F_GETFL ) | O_NONBLOCK );
+      }
+#endif
+      try {
+         m_driver = std::thread( [ this ] { drive(); } );
+      }
+      catch( ... ) {
+#ifndef WIN32
+         ::close( m_wakeup[ 0 ] );
+         ::close( m_wakeup[ 1 ] );
+#endif
+         throw;
+      }
+   }
+
+   multiplexer::~multiplexer()
+   {
+      {
+         const std::lock_guard lock( m_mutex );
+         m_stopped = true;
+      }
+      wakeup();
+      m_driver.join();
+#ifndef WIN32
+      ::close( m_wakeup[ 0 ] );
+      ::close( m_wakeup[ 1 ] );
+#endif
+   }
+
+   auto multiplexer::create( const std::string& connection_info ) -> std::shared_ptr< multiplexer >
+   {
+      return std::make_shared< multiplexer >( private_key(), connection_info );
+   }
+
+   void multiplexer::prepare( const std::string& name, const std::string& statement )
+   {
+      connection::check_prepared_name( name );
+      auto s = std::make_unique< internal::multiplexed_statement >();
+      s->prepare = true;
+      s->name = name;
+      s->statement = statement;
+      (void)submit( std::move( s ) ).get();
+   }
+
+}  // namespace tao::pq
+
+#endif
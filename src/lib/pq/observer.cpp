@@ -0,0 +1,43 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include <tao/pq/observer.hpp>
+
+#include <utility>
+
+namespace tao::pq
+{
+   observer_list::observer_list( std::vector< std::shared_ptr< observer > > observers ) noexcept
+      : m_observers( std::move( observers ) )
+   {}
+
+   void observer_list::on_statement( const statement_event& event ) noexcept
+   {
+      for( const auto& o : m_observers ) {
+         o->on_statement( event );
+      }
+   }
+
+   void observer_list::on_transaction( const transaction_event& event ) noexcept
+   {
+      for( const auto& o : m_observers ) {
+         o->on_transaction( event );
+      }
+   }
+
+   auto observer_list::annotate( const pq::connection& c, const char* statement ) -> statement_annotation
+   {
+      statement_annotation nrv;
+      for( const auto& o : m_observers ) {
+         auto a = o->annotate( c, statement );
+         if( nrv.comment.empty() ) {
+            nrv.comment = std::move( a.comment );
+         }
+         if( nrv.application_name.empty() ) {
+            nrv.application_name = std::move( a.application_name );
+         }
+      }
+      return nrv;
+   }
+
+}  // namespace tao::pq
@@ -0,0 +1,136 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include <tao/pq/parallel_scan.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include <tao/pq/connection.hpp>
+#include <tao/pq/internal/quote.hpp>
+
+namespace tao::pq
+{
+   namespace internal
+   {
+      namespace
+      {
+         [[nodiscard]] auto tid( const std::uint64_t page ) -> std::string
+         {
+            return '(' + std::to_string( page ) + ",0)";
+         }
+
+         // each worker has its own transaction, so one name suffices
+         const std::string scan_cursor = "taopq_scan";
+
+      }  // namespace
+
+      auto declare_scan_cursor( const std::string& statement ) -> std::string
+      {
+         return "DECLARE " + scan_cursor + " NO SCROLL CURSOR FOR " + statement;
+      }
+
+      void fetch_scan_cursor( const std::shared_ptr< transaction >& tr, const std::size_t rows, const std::function< void( const result& ) >& f )
+      {
+         const auto fetch = "FETCH FORWARD " + std::to_string( rows ) + " FROM " + scan_cursor;
+         while( true ) {
+            const auto r = tr->execute( fetch );
+            if( !r.empty() ) {
+               f( r );
+            }
+            // a short chunk is the last one, saving the final round-trip
+            if( r.size() < rows ) {
+               break;
+            }
+         }
+         tr->execute( "CLOSE " + scan_cursor );
+      }
+
+      void parallel_for_each( const std::shared_ptr< connection_pool >& pool,
+                              const std::size_t partitions,
+                              const std::size_t workers,
+                              const std::function< void( const std::shared_ptr< transaction >&, const std::size_t ) >& task )
+      {
+         if( workers == 0 ) {
+            throw std::invalid_argument( "parallel scan without workers" );
+         }
+         if( partitions == 0 ) {
+            return;
+         }
+
+         // the snapshot stays valid while the coordinating transaction is open
+         const auto coordinator = pool->connection()->transaction( transaction::isolation_level::repeatable_read );
+         const auto snapshot = coordinator->execute( "SELECT pg_export_snapshot()" ).as< std::string >();
+
+         std::atomic< std::size_t > next( 0 );
+         std::mutex mutex;
+         std::exception_ptr error;
+
+         const auto worker = [ & ] {
+            try {
+               const auto tr = pool->connection()->transaction( transaction::isolation_level::repeatable_read );
+               tr->execute( "SET TRANSACTION SNAPSHOT " + quote_literal( snapshot ) );
+               for( auto i = next++; i < partitions; i = next++ ) {
+                  task( tr, i );
+               }
+               tr->commit();
+            }
+            catch( ... ) {
+               next = partitions;
+               const std::lock_guard lock( mutex );
+               if( !error ) {
+                  error = std::current_exception();
+               }
+            }
+         };
+
+         std::vector< std::thread > threads;
+         const auto n = std::min( workers, partitions );
+         threads.reserve( n - 1 );
+         try {
+            for( std::size_t i = 1; i < n; ++i ) {
+               threads.emplace_back( worker );
+            }
+         }
+         catch( ... ) {
+            // the started workers stop after their current partition
+            next = partitions;
+            for( auto& t : threads ) {
+               t.join();
+            }
+            throw;
+         }
+         worker();
+         for( auto& t : threads ) {
+            t.join();
+         }
+         if( error ) {
+            std::rethrow_exception( error );
+         }
+         coordinator->commit();
+      }
+
+   }  // namespace internal
+
+   auto ctid_partitions( const std::shared_ptr< transaction >& tr, const std::string& table, const std::size_t n ) -> std::vector< std::pair< std::string, std::string > >
+   {
+      if( n == 0 ) {
+         throw std::invalid_argument( "ctid partitions without partitions" );
+      }
+      const auto pages = tr->execute( "SELECT pg_relation_size( $1 ) / current_setting( 'block_size' )::BIGINT", table ).as< std::uint64_t >();
+      std::vector< std::pair< std::string, std::string > > nrv;
+      nrv.reserve( n );
+      for( std::size_t i = 0; i < n; ++i ) {
+         const auto first = pages * i / n;
+         const auto last = pages * ( i + 1 ) / n;
+         nrv.emplace_back( internal::tid( first ), ( i + 1 == n ) ? std::string( "(4294967295,0)" ) : internal::tid( last ) );
+      }
+      return nrv;
+   }
+
+}  // namespace tao::pq
@@ -0,0 +1,49 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include <tao/pq/pool_metrics.hpp>
+
+#include <cmath>
+#include <initializer_list>
+
+#include <tao/pq/internal/printf.hpp>
+
+namespace tao::pq
+{
+   namespace
+   {
+      void metric( std::string& out, const std::string& name, const char* type, const char* help, const unsigned long long value )
+      {
+         out += internal::printf( "# HELP %s %s\n# TYPE %s %s\n%s %llu\n", name.c_str(), help, name.c_str(), type, name.c_str(), value );
+      }
+
+      // the histogram's unit is converted to seconds by the given factor
+      void histogram( std::string& out, const std::string& name, const char* help, const internal::histogram_snapshot& h, const double unit, const std::initializer_list< double > bounds )
+      {
+         out += internal::printf( "# HELP %s %s\n# TYPE %s histogram\n", name.c_str(), help, name.c_str() );
+         for( const double bound : bounds ) {
+            const auto count = h.count_below( static_cast< std::uint64_t >( std::llround( bound / unit ) ) );
+            out += internal::printf( "%s_bucket{le=\"%g\"} %llu\n", name.c_str(), bound, static_cast< unsigned long long >( count ) );
+         }
+         out += internal::printf( "%s_bucket{le=\"+Inf\"} %llu\n", name.c_str(), static_cast< unsigned long long >( h.count() ) );
+         out += internal::printf( "%s_sum %.9g\n", name.c_str(), static_cast< double >( h.sum() ) * unit );
+         out += internal::printf( "%s_count %llu\n", name.c_str(), static_cast< unsigned long long >( h.count() ) );
+      }
+
+   }  // namespace
+
+   auto pool_metrics::to_prometheus( const std::string& prefix ) const -> std::string
+   {
+      std::string nrv;
+      metric( nrv, prefix + "_idle_connections", "gauge", "Number of idle connections in the pool.", idle );
+      metric( nrv, prefix + "_in_use_connections", "gauge", "Number of connections currently checked out.", in_use );
+      metric( nrv, prefix + "_checkouts_total", "counter", "Number of connection checkouts.", checkouts );
+      metric( nrv, prefix + "_creations_total", "counter", "Number of connections created.", creations );
+      metric( nrv, prefix + "_creation_failures_total", "counter", "Number of failed attempts to create a connection.", creation_failures );
+      metric( nrv, prefix + "_invalidated_total", "counter", "Number of connections dropped because they were no longer valid.", invalidated );
+      histogram( nrv, prefix + "_checkout_seconds", "Time to check out a connection, including its creation if necessary.", checkout_latency, 1e-9, { 1e-6, 1e-5, 1e-4, 1e-3, 1e-2, 0.1, 1, 10 } );
+      histogram( nrv, prefix + "_connection_age_seconds", "Age of connections at checkout.", connection_age, 1e-3, { 1, 10, 60, 600, 3600, 86400 } );
+      return nrv;
+   }
+
+}  // namespace tao::pq
@@ -0,0 +1,540 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include <tao/pq/replication_connection.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include <tao/pq/internal/poll.hpp>
+#include <tao/pq/internal/quote.hpp>
+#include <tao/pq/result.hpp>
+
+namespace tao::pq
+{
+   namespace
+   {
+      // microseconds between the Unix epoch and the PostgreSQL epoch, 2000-01-01
+      constexpr std::int64_t postgres_epoch = 946684800000000;
+
+      void put64( std::string& data, const std::uint64_t v )
+      {
+         for( int shift = 56; shift >= 0; shift -= 8 ) {
+            data += static_cast< char >( ( v >> shift ) & 0xff );
+         }
+      }
+
+      // reads the big-endian fields of a replication message
+      class reader
+      {
+      private:
+         const char* m_data;
+         const char* const m_end;
+
+         void check( const std::size_t size ) const
+         {
+            if( static_cast< std::size_t >( m_end - m_data ) < size ) {
+               throw std::runtime_error( "malformed replication message" );
+            }
+         }
+
+         [[nodiscard]] auto get( const std::size_t size ) -> std::uint64_t
+         {
+            check( size );
+            std::uint64_t nrv = 0;
+            for( std::size_t i = 0; i < size; ++i ) {
+               nrv = ( nrv << 8 ) | static_cast< unsigned char >( *m_data++ );
+            }
+            return nrv;
+         }
+
+      public:
+         reader( const char* data, const std::size_t size ) noexcept
+            : m_data( data ),
+              m_end( data + size )
+         {}
+
+         [[nodiscard]] auto get8() -> char
+         {
+            check( 1 );
+            return *m_data++;
+         }
+
+         [[nodiscard]] auto get16() -> std::int16_t
+         {
+            return static_cast< std::int16_t >( get( 2 ) );
+         }
+
+         [[nodiscard]] auto get32() -> std::int32_t
+         {
+            return static_cast< std::int32_t >( get( 4 ) );
+         }
+
+         [[nodiscard]] auto get64() -> std::uint64_t
+         {
+            return get( 8 );
+         }
+
+         [[nodiscard]] auto string() -> std::string
+         {
+            const auto* end = static_cast< const char* >( std::memchr( m_data, '\0', static_cast< std::size_t >( m_end - m_data ) ) );
+            if( end == nullptr ) {
+               throw std::runtime_error( "malformed replication message" );
+            }
+            std::string nrv( m_data, end );
+            m_data = end + 1;
+            return nrv;
+         }
+
+         [[nodiscard]] auto bytes( const std::size_t size ) -> std::string
+         {
+            check( size );
+            std::string nrv( m_data, size );
+            m_data += size;
+            return nrv;
+         }
+
+         // unchanged TOASTed values are nullopt, they are flagged if requested
+         [[nodiscard]] auto tuple( std::vector< bool >* unchanged = nullptr ) -> std::vector< std::optional< std::string > >
+         {
+            const auto n = get16();
+            std::vector< std::optional< std::string > > nrv;
+            nrv.reserve( static_cast< std::size_t >( std::max< std::int16_t >( n, 0 ) ) );
+            if( unchanged != nullptr ) {
+               unchanged->clear();
+               unchanged->reserve( nrv.capacity() );
+            }
+            for( std::int16_t i = 0; i < n; ++i ) {
+               const auto kind = get8();
+               switch( kind ) {
+                  case 't':
+                     nrv.emplace_back( bytes( static_cast< std::uint32_t >( get32() ) ) );
+                     break;
+                  case 'n':
+                  case 'u':
+                     nrv.emplace_back( std::nullopt );
+                     break;
+                  default:
+                     throw std::runtime_error( "unsupported tuple data in replication message" );
+               }
+               if( unchanged != nullptr ) {
+                  unchanged->push_back( kind == 'u' );
+               }
+            }
+            return nrv;
+         }
+      };
+
+      // reads a (possibly double-quoted) name of test_decoding's output up to one of the delimiters
+      [[nodiscard]] auto test_decoding_name( const std::string& line, std::size_t& pos, const char* delimiters ) -> std::string
+      {
+         std::string nrv;
+         if( ( pos < line.size() ) && ( line[ pos ] == '"' ) ) {
+            while( ++pos < line.size() ) {
+               if( line[ pos ] == '"' ) {
+                  if( ( pos + 1 < line.size() ) && ( line[ pos + 1 ] == '"' ) ) {
+                     nrv += '"';
+                     ++pos;
+                     continue;
+                  }
+                  ++pos;
+                  break;
+               }
+               nrv += line[ pos ];
+            }
+            return nrv;
+         }
+         const auto end = std::min( line.find_first_of( delimiters, pos ), line.size() );
+         nrv = line.substr( pos, end - pos );
+         pos = end;
+         return nrv;
+      }
+
+      // parses "name[type]:value ..." until the end or the next "old-key:" or "new-tuple:",
+      // unchanged TOASTed values are nullopt, they are flagged if requested
+      void test_decoding_values( const std::string& line, std::size_t& pos, std::vector< std::string >& columns, std::vector< std::optional< std::string > >& values, std::vector< bool >* unchanged = nullptr )
+      {
+         while( ( pos = line.find_first_not_of( ' ', pos ) ) != std::string::npos ) {
+            if( ( line.compare( pos, 8, "old-key:" ) == 0 ) || ( line.compare( pos, 10, "new-tuple:" ) == 0 ) || ( line[ pos ] == '(' ) ) {
+               return;
+            }
+            auto name = test_decoding_name( line, pos, "[" );
+            const auto end = line.find( "]:", pos );
+            if( end == std::string::npos ) {
+               throw std::runtime_error( "malformed test_decoding output: " + line );
+            }
+            pos = end + 2;
+            if( columns.size() <= values.size() ) {
+               columns.emplace_back( std::move( name ) );
+            }
+            if( ( pos < line.size() ) && ( line[ pos ] == '\'' ) ) {
+               std::string value;
+               while( true ) {
+                  if( ++pos >= line.size() ) {
+                     throw std::runtime_error( "malformed test_decoding output: " + line );
+                  }
+                  if( line[ pos ] == '\'' ) {
+                     if( ( pos + 1 < line.size() ) && ( line[ pos + 1 ] == '\'' ) ) {
+                        value += '\'';
+                        ++pos;
+                        continue;
+                     }
+                     ++pos;
+                     break;
+                  }
+                  value += line[ pos ];
+               }
+               values.emplace_back( std::move( value ) );
+               if( unchanged != nullptr ) {
+                  unchanged->push_back( false );
+               }
+            }
+            else {
+               const auto value = test_decoding_name( line, pos, " " );
+               const bool toast = ( value == "unchanged-toast-datum" );
+               if( toast || ( value == "null" ) ) {
+                  values.emplace_back( std::nullopt );
+               }
+               else {
+                  values.emplace_back( value );
+               }
+               if( unchanged != nullptr ) {
+                  unchanged->push_back( toast );
+               }
+            }
+         }
+      }
+
+   }  // namespace
+
+   auto format_lsn( const std::uint64_t lsn ) -> std::string
+   {
+      char buffer[ 32 ];
+      (void)std::snprintf( buffer, sizeof( buffer ), "%X/%X", static_cast< unsigned >( lsn >> 32 ), static_cast< unsigned >( lsn & 0xffffffff ) );
+      return buffer;
+   }
+
+   auto parse_lsn( const std::string& lsn ) -> std::uint64_t
+   {
+      unsigned hi = 0;
+      unsigned lo = 0;
+      char dummy = 0;
+      if( std::sscanf( lsn.c_str(), "%X/%X%c", &hi, &lo, &dummy ) != 2 ) {  // NOLINT(cert-err34-c)
+         throw std::invalid_argument( "invalid lsn: " + lsn );
+      }
+      return ( static_cast< std::uint64_t >( hi ) << 32 ) | lo;
+   }
+
+   auto replication_connection::error_message() const -> std::string
+   {
+      std::string nrv = PQerrorMessage( m_pgconn.get() );
+      if( !nrv.empty() && ( nrv.back() == '\n' ) ) {
+         nrv.pop_back();
+      }
+      return nrv;
+   }
+
+   void replication_connection::start()
+   {
+      PGconn* c = m_pgconn.get();
+      if( m_options.create_slot ) {
+         std::string statement = "CREATE_REPLICATION_SLOT " + internal::quote_identifier( m_options.slot );
+         if( m_options.temporary_slot ) {
+            statement += " TEMPORARY";
+         }
+         statement += " LOGICAL " + internal::quote_identifier( m_options.plugin ) + " NOEXPORT_SNAPSHOT";
+         PGresult* r = PQexec( c, statement.c_str() );
+         const char* sql_state = PQresultErrorField( r, PG_DIAG_SQLSTATE );
+         if( ( sql_state != nullptr ) && ( std::strcmp( sql_state, "42710" ) == 0 ) ) {
+            PQclear( r );  // the slot exists already
+         }
+         else {
+            (void)result( r );
+         }
+      }
+
+      std::string statement = "START_REPLICATION SLOT " + internal::quote_identifier( m_options.slot ) + " LOGICAL " + format_lsn( m_options.start );
+      if( m_options.plugin == "pgoutput" ) {
+         std::string publications;
+         for( const auto& p : m_options.publications ) {
+            if( !publications.empty() ) {
+               publications += ',';
+            }
+            publications += internal::quote_identifier( p );
+         }
+         statement += " ( proto_version '1', publication_names " + internal::quote_literal( publications ) + " )";
+      }
+      (void)result( PQexec( c, statement.c_str() ), result::mode_t::expect_copy_both );
+      m_last_status = clock::now();
+   }
+
+   void replication_connection::receive( const char* data, const std::size_t size )
+   {
+      reader r( data, size );
+      switch( r.get8() ) {
+         case 'w': {
+            const auto start = r.get64();
+            (void)r.get64();  // the end of the server's log
+            (void)r.get64();  // the time it was sent
+            m_received = std::max( m_received, start );
+            const auto header = static_cast< std::size_t >( 1 + 8 + 8 + 8 );
+            if( m_options.plugin == "pgoutput" ) {
+               decode_pgoutput( data + header, size - header, start );
+            }
+            else {
+               decode_test_decoding( std::string( data + header, size - header ), start );
+            }
+         } break;
+
+         case 'k': {
+            (void)r.get64();
+            (void)r.get64();
+            if( r.get8() != 0 ) {
+               send_status();
+            }
+         } break;
+
+         default:
+            throw std::runtime_error( "unsupported replication message" );
+      }
+   }
+
+   void replication_connection::decode_pgoutput( const char* data, const std::size_t size, const std::uint64_t lsn )
+   {
+      reader r( data, size );
+      const auto add = [ & ]( const change_event::kind type, const std::uint32_t oid ) -> change_event& {
+         const auto it = m_relations.find( oid );
+         if( it == m_relations.end() ) {
+            throw std::runtime_error( "replication message for unknown relation " + std::to_string( oid ) );
+         }
+         auto& e = m_events.emplace_back();
+         e.type = type;
+         e.lsn = lsn;
+         e.xid = m_xid;
+         e.schema = it->second.schema;
+         e.table = it->second.table;
+         e.columns = it->second.columns;
+         return e;
+      };
+      switch( r.get8() ) {
+         case 'B': {
+            auto& e = m_events.emplace_back();
+            e.type = change_event::kind::begin;
+            e.lsn = r.get64();  // of the commit
+            (void)r.get64();    // the commit time
+            e.xid = m_xid = static_cast< std::uint32_t >( r.get32() );
+         } break;
+
+         case 'C': {
+            auto& e = m_events.emplace_back();
+            e.type = change_event::kind::commit;
+            (void)r.get8();     // flags
+            (void)r.get64();    // the commit
+            e.lsn = r.get64();  // the end of the transaction
+            e.xid = m_xid;
+         } break;
+
+         case 'R': {
+            const auto oid = static_cast< std::uint32_t >( r.get32() );
+            relation rel;
+            rel.schema = r.string();
+            rel.table = r.string();
+            (void)r.get8();  // replica identity
+            const auto n = r.get16();
+            for( std::int16_t i = 0; i < n; ++i ) {
+               (void)r.get8();  // flags
+               rel.columns.emplace_back( r.string() );
+               (void)r.get32();  // type
+               (void)r.get32();  // type modifier
+            }
+            m_relations[ oid ] = std::move( rel );
+         } break;
+
+         case 'I': {
+            auto& e = add( change_event::kind::insert, static_cast< std::uint32_t >( r.get32() ) );
+            (void)r.get8();  // 'N'
+            e.values = r.tuple( &e.unchanged );
+         } break;
+
+         case 'U': {
+            auto& e = add( change_event::kind::update, static_cast< std::uint32_t >( r.get32() ) );
+            const auto kind = r.get8();
+            if( ( kind == 'K' ) || ( kind == 'O' ) ) {
+               e.old_values = r.tuple();
+               (void)r.get8();  // 'N'
+            }
+            e.values = r.tuple( &e.unchanged );
+         } break;
+
+         case 'D': {
+            auto& e = add( change_event::kind::delete_, static_cast< std::uint32_t >( r.get32() ) );
+            (void)r.get8();  // 'K' or 'O'
+            e.old_values = r.tuple();
+         } break;
+
+         case 'T': {
+            const auto n = r.get32();
+            (void)r.get8();  // options
+            for( std::int32_t i = 0; i < n; ++i ) {
+               (void)add( change_event::kind::truncate, static_cast< std::uint32_t >( r.get32() ) );
+            }
+         } break;
+
+         default:
+            break;  // e.g. origin and type messages
+      }
+   }
+
+   void replication_connection::decode_test_decoding( const std::string& line, const std::uint64_t lsn )
+   {
+      if( ( line.compare( 0, 6, "BEGIN " ) == 0 ) || ( line.compare( 0, 7, "COMMIT " ) == 0 ) ) {
+         auto& e = m_events.emplace_back();
+         e.type = ( line[ 0 ] == 'B' ) ? change_event::kind::begin : change_event::kind::commit;
+         e.lsn = lsn;
+         e.xid = static_cast< std::uint32_t >( std::stoul( line.substr( line.find( ' ' ) + 1 ) ) );
+         m_xid = e.xid;
+         return;
+      }
+      if( line.compare( 0, 6, "table " ) != 0 ) {
+         return;  // e.g. BEGIN and COMMIT without transaction ids
+      }
+      change_event e;
+      e.lsn = lsn;
+      e.xid = m_xid;
+      std::size_t pos = 6;
+      e.schema = test_decoding_name( line, pos, "." );
+      ++pos;
+      e.table = test_decoding_name( line, pos, ":" );
+      pos += 2;
+      const auto end = line.find( ':', pos );
+      if( end == std::string::npos ) {
+         throw std::runtime_error( "malformed test_decoding output: " + line );
+      }
+      const auto kind = line.substr( pos, end - pos );
+      pos = end + 1;
+      if( kind == "INSERT" ) {
+         e.type = change_event::kind::insert;
+         test_decoding_values( line, pos, e.columns, e.values, &e.unchanged );
+      }
+      else if( kind == "UPDATE" ) {
+         e.type = change_event::kind::update;
+         pos = line.find_first_not_of( ' ', pos );
+         if( ( pos != std::string::npos ) && ( line.compare( pos, 8, "old-key:" ) == 0 ) ) {
+            pos += 8;
+            std::vector< std::string > columns;
+            test_decoding_values( line, pos, columns, e.old_values );
+            pos += 10;  // "new-tuple:"
+         }
+         test_decoding_values( line, pos, e.columns, e.values, &e.unchanged );
+      }
+      else if( kind == "DELETE" ) {
+         e.type = change_event::kind::delete_;
+         test_decoding_values( line, pos, e.columns, e.old_values );
+      }
+      else if( kind == "TRUNCATE" ) {
+         e.type = change_event::kind::truncate;
+      }
+      else {
+         throw std::runtime_error( "malformed test_decoding output: " + line );
+      }
+      m_events.emplace_back( std::move( e ) );
+   }
+
+   replication_connection::replication_connection( const private_key& /*unused*/, const std::string& connection_info, const replication_options& options )  // NOLINT(modernize-pass-by-value)
+      : m_pgconn( [ & ] {
+           // the connection info is expanded, later parameters take precedence
+           const char* const keywords[] = { "dbname", "replication", nullptr };
+           const char* const values[] = { connection_info.c_str(), "database", nullptr };
+           return PQconnectdbParams( keywords, values, 1 );
+        }(),
+                  internal::deleter() ),
+        m_options( options )
+   {
+      if( ( m_options.plugin != "pgoutput" ) && ( m_options.plugin != "test_decoding" ) ) {
+         throw std::invalid_argument( "unsupported output plugin: " + m_options.plugin );
+      }
+      if( PQstatus( m_pgconn.get() ) != CONNECTION_OK ) {
+         throw std::runtime_error( "connection failed: " + error_message() );
+      }
+      start();
+   }
+
+   auto replication_connection::create( const std::string& connection_info, const replication_options& options ) -> std::shared_ptr< replication_connection >
+   {
+      return std::make_shared< replication_connection >( private_key(), connection_info, options );
+   }
+
+   replication_connection::~replication_connection()
+   {
+      try {
+         send_status();
+      }
+      catch( ... ) {
+         // the server resumes from the last reported position
+      }
+   }
+
+   auto replication_connection::next( const std::chrono::milliseconds timeout ) -> std::optional< change_event >
+   {
+      PGconn* c = m_pgconn.get();
+      const auto deadline = clock::now() + timeout;
+      while( m_events.empty() ) {
+         char* buffer = nullptr;
+         const int size = PQgetCopyData( c, &buffer, 1 );
+         if( size > 0 ) {
+            const std::unique_ptr< char, decltype( &PQfreemem ) > guard( buffer, &PQfreemem );
+            receive( buffer, static_cast< std::size_t >( size ) );
+            continue;
+         }
+         if( size == -1 ) {
+            (void)result( PQgetResult( c ) );
+            throw std::runtime_error( "replication stream ended" );
+         }
+         if( size < 0 ) {
+            throw std::runtime_error( "PQgetCopyData() failed: " + error_message() );
+         }
+
+         const auto now = clock::now();
+         if( now - m_last_status >= m_options.status_interval ) {
+            send_status();
+         }
+         if( now >= deadline ) {
+            return std::nullopt;
+         }
+         const auto wait = std::min( deadline, m_last_status + m_options.status_interval ) - now;
+         const auto wait_ms = std::chrono::duration_cast< std::chrono::milliseconds >( wait ).count() + 1;
+         if( internal::poll( PQsocket( c ), false, static_cast< int >( wait_ms ) ) ) {
+            if( PQconsumeInput( c ) == 0 ) {
+               throw std::runtime_error( "PQconsumeInput() failed: " + error_message() );
+            }
+         }
+      }
+      auto nrv = std::move( m_events.front() );
+      m_events.pop_front();
+      return nrv;
+   }
+
+   void replication_connection::acknowledge( const std::uint64_t lsn ) noexcept
+   {
+      m_acknowledged = std::max( m_acknowledged, lsn );
+   }
+
+   void replication_connection::send_status( const bool reply_requested )
+   {
+      const auto now = std::chrono::duration_cast< std::chrono::microseconds >( std::chrono::system_clock::now().time_since_epoch() ).count();
+      std::string data = "r";
+      put64( data, std::max( m_received, m_acknowledged ) );  // written
+      put64( data, m_acknowledged );  // flushed
+      put64( data, m_acknowledged );  // applied
+      put64( data, static_cast< std::uint64_t >( now - postgres_epoch ) );
+      data += reply_requested ? '\1' : '\0';
+      PGconn* c = m_pgconn.get();
+      if( ( PQputCopyData( c, data.data(), static_cast< int >( data.size() ) ) != 1 ) || ( PQflush( c ) != 0 ) ) {
+         throw std::runtime_error( "sending the standby status update failed: " + error_message() );
+      }
+      m_last_status = clock::now();
+   }
+
+}  // namespace tao::pq
@@ -52,6 +52,12 @@ namespace tao::pq
             }
             break;
 
+         case PGRES_COPY_BOTH:
+            if( mode == mode_t::expect_copy_both ) {
+               return;
+            }
+            break;
+
          case PGRES_EMPTY_QUERY:
             throw std::runtime_error( "empty query" );
 
@@ -66,6 +72,10 @@ namespace tao::pq
       throw std::runtime_error( "unexpected result: " + res_status );
    }
 
+   result::result( PGresult* pgresult )
+      : result( pgresult, mode_t::expect_ok )
+   {}
+
    auto result::has_rows_affected() const noexcept -> bool
    {
       const char* str = PQcmdTuples( m_pgresult.get() );
@@ -0,0 +1,177 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include <tao/pq/result_cache.hpp>
+
+#include <stdexcept>
+#include <utility>
+
+#include <tao/pq/internal/statement_key.hpp>
+
+namespace tao::pq
+{
+   void result_cache::erase( const std::list< entry >::iterator it )
+   {
+      for( const auto& tag : it->tags ) {
+         const auto t = m_tags.find( tag );
+         if( t != m_tags.end() ) {
+            t->second.erase( it->key );
+            if( t->second.empty() ) {
+               m_tags.erase( t );
+            }
+         }
+      }
+      m_index.erase( it->key );
+      m_bytes -= it->bytes;
+      m_entries.erase( it );
+   }
+
+   void result_cache::store( std::string key, const cache_policy& policy, const result& r, const std::uint64_t generation )
+   {
+      const auto bytes = PQresultMemorySize( r.m_pgresult.get() ) + key.size();
+      if( bytes > m_options.max_bytes ) {
+         return;
+      }
+      const auto ttl = ( policy.ttl.count() > 0 ) ? policy.ttl : m_options.ttl;
+      const auto expires = std::chrono::steady_clock::now() + ttl;
+
+      const std::lock_guard lock( m_mutex );
+      // an invalidation while the statement was executed might apply to its result
+      if( ( generation != m_generation ) || ( !m_options.channel.empty() && !listening() ) ) {
+         return;
+      }
+      const auto it = m_index.find( key );
+      if( it != m_index.end() ) {
+         erase( it->second );
+      }
+      m_entries.push_front( { std::move( key ), r, bytes, expires, policy.tags } );
+      const auto& e = m_entries.front();
+      m_index.emplace( e.key, m_entries.begin() );
+      for( const auto& tag : e.tags ) {
+         m_tags[ tag ].insert( e.key );
+      }
+      m_bytes += bytes;
+      while( m_bytes > m_options.max_bytes ) {
+         erase( std::prev( m_entries.end() ) );
+         ++m_evicted;
+      }
+   }
+
+   auto result_cache::execute_params( std::shared_ptr< pq::connection >& c,
+                                      const cache_policy& policy,
+                                      const char* statement,
+                                      const int n_params,
+                                      const Oid types[],
+                                      const char* const values[],
+                                      const int lengths[],
+                                      const int formats[] ) -> result
+   {
+      auto key = internal::statement_key( statement, n_params, types, values, lengths, formats );
+      std::uint64_t generation = 0;
+      {
+         const std::lock_guard lock( m_mutex );
+         const auto it = m_index.find( key );
+         if( it != m_index.end() ) {
+            if( it->second->expires > std::chrono::steady_clock::now() ) {
+               m_entries.splice( m_entries.begin(), m_entries, it->second );
+               ++m_hits;
+               return m_entries.front().result;
+            }
+            erase( it->second );
+            ++m_expired;
+         }
+         ++m_misses;
+         generation = m_generation;
+      }
+      auto nrv = m_pool->execute_coalesced_params( c, statement, n_params, types, values, lengths, formats );
+      store( std::move( key ), policy, nrv, generation );
+      return nrv;
+   }
+
+   void result_cache::invalidate( const std::string& tag )
+   {
+      const std::lock_guard lock( m_mutex );
+      ++m_generation;
+      const auto t = m_tags.find( tag );
+      if( t == m_tags.end() ) {
+         return;
+      }
+      // erase() modifies the tag's keys
+      const auto keys = t->second;
+      for( const auto key : keys ) {
+         erase( m_index.at( key ) );
+         ++m_invalidated;
+      }
+   }
+
+   void result_cache::clear()
+   {
+      const std::lock_guard lock( m_mutex );
+      ++m_generation;
+      m_invalidated += m_entries.size();
+      m_tags.clear();
+      m_index.clear();
+      m_entries.clear();
+      m_bytes = 0;
+   }
+
+   void result_cache::notify( const std::string& tag )
+   {
+      if( m_options.channel.empty() ) {
+         throw std::logic_error( "result cache without a channel" );
+      }
+      (void)m_pool->execute( "SELECT pg_notify( $1, $2 )", m_options.channel, tag );
+   }
+
+   auto result_cache::metrics() const -> result_cache_metrics
+   {
+      const std::lock_guard lock( m_mutex );
+      result_cache_metrics nrv;
+      nrv.entries = m_entries.size();
+      nrv.bytes = m_bytes;
+      nrv.hits = m_hits;
+      nrv.misses = m_misses;
+      nrv.evicted = m_evicted;
+      nrv.expired = m_expired;
+      nrv.invalidated = m_invalidated;
+      nrv.notifications = m_notifications;
+      return nrv;
+   }
+
+   // invalidates the tag of a notification received by the listener
+   void result_cache::receive( const std::string& tag )
+   {
+      {
+         const std::lock_guard lock( m_mutex );
+         ++m_notifications;
+      }
+      if( tag.empty() ) {
+         clear();
+      }
+      else {
+         invalidate( tag );
+      }
+   }
+
+   result_cache::result_cache( const private_key& /*unused*/, const std::shared_ptr< connection_pool >& pool, const result_cache_options& options )  // NOLINT(modernize-pass-by-value)
+      : m_pool( pool ),
+        m_options( options )
+   {
+      if( m_options.channel.empty() ) {
+         return;
+      }
+      internal::notification_listener::callbacks cb;
+      cb.notification = [ this ]( const std::string& tag ) { receive( tag ); };
+      // invalidations might be missed until the listener is connected again
+      cb.disconnected = [ this ] { clear(); };
+      m_listener = std::make_unique< internal::notification_listener >( m_pool->m_connection_info, m_options.channel, m_options.reconnect_interval, std::move( cb ) );
+   }
+
+   result_cache::~result_cache() = default;
+
+   auto result_cache::create( const std::shared_ptr< connection_pool >& pool, const result_cache_options& options ) -> std::shared_ptr< result_cache >
+   {
+      return std::make_shared< result_cache >( private_key(), pool, options );
+   }
+
+}  // namespace tao::pq
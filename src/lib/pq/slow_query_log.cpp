@@ -0,0 +1,213 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include <tao/pq/slow_query_log.hpp>
+
+#include <algorithm>
+#include <string_view>
+#include <utility>
+
+#include <tao/pq/internal/json.hpp>
+#include <tao/pq/internal/printf.hpp>
+
+namespace tao::pq
+{
+   namespace
+   {
+      [[nodiscard]] auto ns( const statement_event::clock::duration d ) noexcept -> std::chrono::nanoseconds
+      {
+         return std::chrono::duration_cast< std::chrono::nanoseconds >( d );
+      }
+
+      [[nodiscard]] auto ms( const std::chrono::nanoseconds d ) noexcept -> double
+      {
+         return static_cast< double >( d.count() ) / 1000000.0;
+      }
+
+      // renders a parameter as an SQL literal, truncated to roughly max_length characters
+      [[nodiscard]] auto render( const char* value, const int length, const bool binary, const std::size_t max_length ) -> std::string
+      {
+         if( value == nullptr ) {
+            return "NULL";
+         }
+         std::string nrv = "'";
+         if( binary ) {
+            const auto size = static_cast< std::size_t >( length );
+            const auto n = std::min( size, max_length / 2 );
+            nrv += "\\x";
+            for( std::size_t i = 0; i < n; ++i ) {
+               nrv += internal::printf( "%02x", static_cast< unsigned char >( value[ i ] ) );
+            }
+            if( n < size ) {
+               nrv += "...";
+            }
+         }
+         else {
+            const std::string_view sv = value;
+            auto n = std::min( sv.size(), max_length );
+            // do not cut UTF-8 sequences in half
+            while( ( n < sv.size() ) && ( n > 0 ) && ( ( static_cast< unsigned char >( sv[ n ] ) & 0xc0 ) == 0x80 ) ) {
+               --n;
+            }
+            for( std::size_t i = 0; i < n; ++i ) {
+               if( sv[ i ] == '\'' ) {
+                  nrv += '\'';
+               }
+               nrv += sv[ i ];
+            }
+            if( n < sv.size() ) {
+               nrv += "...";
+            }
+         }
+         nrv += '\'';
+         return nrv;
+      }
+
+   }  // namespace
+
+   auto slow_query::to_text() const -> std::string
+   {
+      std::string nrv = internal::printf( "slow query: %.3fms (encoding %.3fms, sending %.3fms, waiting %.3fms, receiving %.3fms, decoding %.3fms), %zu rows, %zu bytes sent",
+                                          ms( total ),
+                                          ms( encoding ),
+                                          ms( sending ),
+                                          ms( waiting ),
+                                          ms( receiving ),
+                                          ms( decoding ),
+                                          rows,
+                                          bytes_sent );
+      if( !error.empty() ) {
+         nrv += ", error: ";
+         nrv += error;
+      }
+      nrv += prepared ? "\n  prepared statement: " : "\n  statement: ";
+      nrv += statement;
+      if( !parameters.empty() ) {
+         nrv += "\n  parameters:";
+         for( std::size_t i = 0; i < parameters.size(); ++i ) {
+            nrv += internal::printf( " $%zu=", i + 1 );
+            nrv += parameters[ i ];
+         }
+         if( omitted_parameters != 0 ) {
+            nrv += internal::printf( " (%d more)", omitted_parameters );
+         }
+      }
+      nrv += '\n';
+      return nrv;
+   }
+
+   auto slow_query::to_json() const -> std::string
+   {
+      const auto us = std::chrono::duration_cast< std::chrono::microseconds >( time.time_since_epoch() ).count();
+      std::string nrv = internal::printf( "{\"time_us\":%lld,\"statement\":", static_cast< long long >( us ) );
+      internal::json_string( nrv, statement );
+      nrv += internal::printf( ",\"prepared\":%s,\"rows\":%zu,\"bytes_sent\":%zu,\"error\":", prepared ? "true" : "false", rows, bytes_sent );
+      internal::json_string( nrv, error );
+      nrv += internal::printf( ",\"encoding_ns\":%lld,\"sending_ns\":%lld,\"waiting_ns\":%lld,\"receiving_ns\":%lld,\"decoding_ns\":%lld,\"total_ns\":%lld,\"parameters\":[",
+                               static_cast< long long >( encoding.count() ),
+                               static_cast< long long >( sending.count() ),
+                               static_cast< long long >( waiting.count() ),
+                               static_cast< long long >( receiving.count() ),
+                               static_cast< long long >( decoding.count() ),
+                               static_cast< long long >( total.count() ) );
+      for( std::size_t i = 0; i < parameters.size(); ++i ) {
+         if( i != 0 ) {
+            nrv += ',';
+         }
+         internal::json_string( nrv, parameters[ i ] );
+      }
+      nrv += internal::printf( "],\"omitted_parameters\":%d}", omitted_parameters );
+      return nrv;
+   }
+
+   slow_query_log::slow_query_log( sink s, const slow_query_options& options )
+      : m_options( options ),
+        m_sink( std::move( s ) ),
+        m_buffer( options.buffer_size )
+   {
+      m_thread = std::thread( &slow_query_log::run, this );
+   }
+
+   slow_query_log::~slow_query_log()
+   {
+      {
+         const std::lock_guard lock( m_mutex );
+         m_stop = true;
+      }
+      m_condition.notify_one();
+      m_thread.join();
+   }
+
+   void slow_query_log::run()
+   {
+      bool stop = false;
+      while( !stop ) {
+         {
+            std::unique_lock lock( m_mutex );
+            m_condition.wait_for( lock, m_options.flush_interval, [ & ] { return m_stop; } );
+            stop = m_stop;
+         }
+         try {
+            flush();
+         }
+         // LCOV_EXCL_START
+         catch( ... ) {
+            // a failing sink loses the current entry, but must not terminate the program
+         }
+         // LCOV_EXCL_STOP
+      }
+   }
+
+   void slow_query_log::on_statement( const statement_event& event ) noexcept
+   {
+      const auto total = ns( event.total() );
+      if( total < m_options.threshold ) {
+         return;
+      }
+      try {
+         slow_query q;
+         q.time = std::chrono::system_clock::now();
+         q.statement = event.statement;
+         q.prepared = event.prepared;
+         q.rows = event.rows;
+         q.bytes_sent = event.bytes_sent;
+         if( event.error != nullptr ) {
+            q.error = event.error;
+         }
+         q.encoding = ns( event.encoding() );
+         q.sending = ns( event.sending() );
+         q.waiting = ns( event.waiting() );
+         q.receiving = ns( event.receiving() );
+         q.decoding = ns( event.decoding() );
+         q.total = total;
+         if( event.values != nullptr ) {
+            const auto n = std::min( static_cast< std::size_t >( event.parameters ), m_options.max_parameters );
+            q.parameters.reserve( n );
+            for( std::size_t i = 0; i < n; ++i ) {
+               const bool binary = ( event.formats != nullptr ) && ( event.formats[ i ] != 0 );
+               const int length = ( event.lengths != nullptr ) ? event.lengths[ i ] : 0;
+               q.parameters.emplace_back( render( event.values[ i ], length, binary, m_options.max_parameter_length ) );
+            }
+            q.omitted_parameters = event.parameters - static_cast< int >( n );
+         }
+         if( !m_buffer.try_push( std::move( q ) ) ) {
+            m_dropped.fetch_add( 1, std::memory_order_relaxed );
+         }
+      }
+      // LCOV_EXCL_START
+      catch( ... ) {
+         m_dropped.fetch_add( 1, std::memory_order_relaxed );
+      }
+      // LCOV_EXCL_STOP
+   }
+
+   void slow_query_log::flush()
+   {
+      const std::lock_guard lock( m_sink_mutex );
+      slow_query q;
+      while( m_buffer.try_pop( q ) ) {
+         m_sink( q );
+      }
+   }
+
+}  // namespace tao::pq
@@ -0,0 +1,223 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include <tao/pq/statistics.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <map>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+#include <tao/pq/internal/fingerprint.hpp>
+#include <tao/pq/internal/histogram.hpp>
+#include <tao/pq/internal/json.hpp>
+#include <tao/pq/internal/printf.hpp>
+
+namespace tao::pq
+{
+   namespace
+   {
+      std::atomic< std::uint64_t > next_id{ 0 };
+
+      struct counters
+      {
+         const std::string fingerprint;
+         std::atomic< std::uint64_t > calls{ 0 };
+         std::atomic< std::uint64_t > errors{ 0 };
+         std::atomic< std::uint64_t > rows{ 0 };
+         std::atomic< std::uint64_t > bytes_sent{ 0 };
+         internal::histogram latency;
+
+         explicit counters( std::string in_fingerprint )
+            : fingerprint( std::move( in_fingerprint ) )
+         {}
+      };
+
+      struct merged
+      {
+         std::uint64_t calls = 0;
+         std::uint64_t errors = 0;
+         std::uint64_t rows = 0;
+         std::uint64_t bytes_sent = 0;
+         internal::histogram_snapshot latency;
+      };
+
+   }  // namespace
+
+   // only the owning thread modifies a shard, it takes the mutex when
+   // adding new statements as other threads might be reading concurrently.
+   struct statistics::shard
+   {
+      std::mutex mutex;
+      std::deque< counters > entries;
+      std::unordered_map< std::string, counters* > by_fingerprint;
+
+      // the statement's text is cached to avoid calculating the fingerprint on each call
+      std::unordered_map< std::string_view, counters* > by_statement;
+      std::deque< std::string > statements;
+   };
+
+   statistics::statistics( const std::size_t max_statements )
+      : m_id( next_id++ ),
+        m_max_statements( max_statements )
+   {}
+
+   statistics::~statistics() = default;
+
+   auto statistics::local_shard() -> shard&
+   {
+      struct local
+      {
+         std::uint64_t id;
+         shard* ptr;
+         std::weak_ptr< shard > owner;
+      };
+
+      // the ids are never reused, entries for destroyed statistics simply expire
+      static thread_local std::vector< local > shards;
+      for( const auto& e : shards ) {
+         if( e.id == m_id ) {
+            // the shard is owned by *this, so it is still alive
+            return *e.ptr;
+         }
+      }
+      shards.erase( std::remove_if( shards.begin(), shards.end(), []( const local& e ) { return e.owner.expired(); } ), shards.end() );
+      const auto nrv = std::make_shared< shard >();
+      {
+         const std::lock_guard lock( m_mutex );
+         m_shards.push_back( nrv );
+      }
+      shards.push_back( { m_id, nrv.get(), nrv } );
+      return *nrv;
+   }
+
+   void statistics::on_statement( const statement_event& event ) noexcept
+   {
+      try {
+         auto& s = local_shard();
+         counters* c = nullptr;
+         const std::string_view statement = event.statement;
+         const auto it = s.by_statement.find( statement );
+         if( it != s.by_statement.end() ) {
+            c = it->second;
+         }
+         else {
+            auto fingerprint = ( s.by_fingerprint.size() < m_max_statements ) ? internal::fingerprint( statement ) : std::string( "?" );
+            const std::lock_guard lock( s.mutex );
+            const auto jt = s.by_fingerprint.find( fingerprint );
+            if( jt != s.by_fingerprint.end() ) {
+               c = jt->second;
+            }
+            else {
+               c = &s.entries.emplace_back( fingerprint );
+               s.by_fingerprint.emplace( std::move( fingerprint ), c );
+            }
+            // statements with embedded literals would grow the cache without bounds
+            if( s.statements.size() >= 4 * m_max_statements ) {
+               s.by_statement.clear();
+               s.statements.clear();
+            }
+            s.by_statement.emplace( s.statements.emplace_back( statement ), c );
+         }
+         c->calls.fetch_add( 1, std::memory_order_relaxed );
+         if( event.error != nullptr ) {
+            c->errors.fetch_add( 1, std::memory_order_relaxed );
+         }
+         c->rows.fetch_add( event.rows, std::memory_order_relaxed );
+         c->bytes_sent.fetch_add( event.bytes_sent, std::memory_order_relaxed );
+         c->latency.record( std::chrono::duration_cast< std::chrono::nanoseconds >( event.total() ).count() );
+      }
+      // LCOV_EXCL_START
+      catch( ... ) {
+         // statistics are best effort, out of memory simply loses the event
+      }
+      // LCOV_EXCL_STOP
+   }
+
+   auto statistics::snapshot() const -> std::vector< entry >
+   {
+      std::map< std::string, merged > m;
+      {
+         const std::lock_guard lock( m_mutex );
+         for( const auto& s : m_shards ) {
+            const std::lock_guard shard_lock( s->mutex );
+            for( const auto& c : s->entries ) {
+               auto& e = m[ c.fingerprint ];
+               e.calls += c.calls.load( std::memory_order_relaxed );
+               e.errors += c.errors.load( std::memory_order_relaxed );
+               e.rows += c.rows.load( std::memory_order_relaxed );
+               e.bytes_sent += c.bytes_sent.load( std::memory_order_relaxed );
+               e.latency += c.latency.snapshot();
+            }
+         }
+      }
+      std::vector< entry > nrv;
+      nrv.reserve( m.size() );
+      for( const auto& [ fingerprint, e ] : m ) {
+         auto& r = nrv.emplace_back();
+         r.statement = fingerprint;
+         r.calls = e.calls;
+         r.errors = e.errors;
+         r.rows = e.rows;
+         r.bytes_sent = e.bytes_sent;
+         r.total = std::chrono::nanoseconds( e.latency.sum() );
+         r.mean = std::chrono::nanoseconds( e.latency.mean() );
+         r.p50 = std::chrono::nanoseconds( e.latency.percentile( 0.5 ) );
+         r.p99 = std::chrono::nanoseconds( e.latency.percentile( 0.99 ) );
+         r.p999 = std::chrono::nanoseconds( e.latency.percentile( 0.999 ) );
+         r.max = std::chrono::nanoseconds( e.latency.max() );
+      }
+      std::stable_sort( nrv.begin(), nrv.end(), []( const entry& lhs, const entry& rhs ) { return lhs.total > rhs.total; } );
+      return nrv;
+   }
+
+   auto statistics::to_text() const -> std::string
+   {
+      const auto us = []( const std::chrono::nanoseconds ns ) { return static_cast< double >( ns.count() ) / 1000.0; };
+      std::string nrv = internal::printf( "%10s %8s %10s %12s %12s %12s %12s %12s %12s  %s\n", "calls", "errors", "rows", "bytes", "mean[us]", "p50[us]", "p99[us]", "p999[us]", "max[us]", "statement" );
+      for( const auto& e : snapshot() ) {
+         nrv += internal::printf( "%10llu %8llu %10llu %12llu %12.1f %12.1f %12.1f %12.1f %12.1f  ",
+                                  static_cast< unsigned long long >( e.calls ),
+                                  static_cast< unsigned long long >( e.errors ),
+                                  static_cast< unsigned long long >( e.rows ),
+                                  static_cast< unsigned long long >( e.bytes_sent ),
+                                  us( e.mean ),
+                                  us( e.p50 ),
+                                  us( e.p99 ),
+                                  us( e.p999 ),
+                                  us( e.max ) );
+         nrv += e.statement;
+         nrv += '\n';
+      }
+      return nrv;
+   }
+
+   auto statistics::to_json() const -> std::string
+   {
+      std::string nrv = "[";
+      for( const auto& e : snapshot() ) {
+         if( nrv.size() > 1 ) {
+            nrv += ',';
+         }
+         nrv += "\n{\"statement\":";
+         internal::json_string( nrv, e.statement );
+         nrv += internal::printf( ",\"calls\":%llu,\"errors\":%llu,\"rows\":%llu,\"bytes_sent\":%llu,\"total_ns\":%lld,\"mean_ns\":%lld,\"p50_ns\":%lld,\"p99_ns\":%lld,\"p999_ns\":%lld,\"max_ns\":%lld}",
+                                  static_cast< unsigned long long >( e.calls ),
+                                  static_cast< unsigned long long >( e.errors ),
+                                  static_cast< unsigned long long >( e.rows ),
+                                  static_cast< unsigned long long >( e.bytes_sent ),
+                                  static_cast< long long >( e.total.count() ),
+                                  static_cast< long long >( e.mean.count() ),
+                                  static_cast< long long >( e.p50.count() ),
+                                  static_cast< long long >( e.p99.count() ),
+                                  static_cast< long long >( e.p999.count() ),
+                                  static_cast< long long >( e.max.count() ) );
+      }
+      nrv += "\n]\n";
+      return nrv;
+   }
+
+}  // namespace tao::pq
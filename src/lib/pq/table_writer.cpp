@@ -14,7 +14,13 @@ namespace tao::pq
    table_writer::table_writer( const std::shared_ptr< transaction >& transaction, const std::string& statement )
       : m_transaction( transaction )
    {
-      result( PQexecParams( transaction->m_connection->m_pgconn.get(), statement.c_str(), 0, nullptr, nullptr, nullptr, nullptr, 0 ), result::mode_t::expect_copy_in );
+      auto& c = *transaction->m_connection;
+      PGresult* r = PQexecParams( c.m_pgconn.get(), statement.c_str(), 0, nullptr, nullptr, nullptr, nullptr, 0 );
+      // answered by ParseComplete, BindComplete and CopyInResponse, ReadyForQuery follows after the data
+      c.m_wire.round_trip();
+      c.m_wire.exchanged( internal::statement_wire_size( statement.c_str(), false, 0, nullptr, nullptr, nullptr ), internal::response_overhead( false ) - 6 );
+      c.m_wire.result( r );
+      result( r, result::mode_t::expect_copy_in );
    }
 
    table_writer::~table_writer()
@@ -30,6 +36,7 @@ namespace tao::pq
       if( r != 1 ) {
          throw std::runtime_error( "PQputCopyData() failed: " + m_transaction->m_connection->error_message() );
       }
+      m_transaction->m_connection->m_wire.sent( 1 + 4 + data.size() );
    }
 
    auto table_writer::finish() -> std::size_t
@@ -40,7 +47,10 @@ namespace tao::pq
          throw std::runtime_error( "PQputCopyEnd() failed: " + connection->error_message() );
       }
       m_transaction.reset();
-      return result( PQgetResult( connection->m_pgconn.get() ) ).rows_affected();
+      // CopyDone and Sync, answered by CommandComplete and ReadyForQuery
+      connection->m_wire.exchanged( 5 + 5, 6 );
+      // collects all results, otherwise the connection stays busy
+      return result( connection->get_result() ).rows_affected();
    }
 
 }  // namespace tao::pq
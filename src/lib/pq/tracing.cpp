@@ -0,0 +1,292 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include <tao/pq/tracing.hpp>
+
+#include <cctype>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include <libpq-fe.h>
+
+#include <tao/pq/connection.hpp>
+#include <tao/pq/internal/fingerprint.hpp>
+#include <tao/pq/internal/json.hpp>
+#include <tao/pq/internal/printf.hpp>
+
+namespace tao::pq
+{
+   namespace
+   {
+      thread_local const trace_scope* current_scope = nullptr;
+
+      // the context of the statement span announced to the server by annotate(),
+      // on_statement() must not look up the parent again as a new trace might be started
+      thread_local const tracer* pending_tracer = nullptr;
+      thread_local trace_context pending_context;
+      thread_local std::string pending_parent_span_id;
+
+      [[nodiscard]] auto random_hex() -> std::string
+      {
+         thread_local std::mt19937_64 engine( std::random_device{}() ^ std::hash< std::thread::id >()( std::this_thread::get_id() ) ^ static_cast< std::uint64_t >( std::chrono::steady_clock::now().time_since_epoch().count() ) );
+         std::uint64_t value = 0;
+         while( value == 0 ) {
+            value = engine();
+         }
+         return internal::printf( "%016llx", static_cast< unsigned long long >( value ) );
+      }
+
+      [[nodiscard]] auto is_hex( const std::string& s, const std::size_t pos, const std::size_t size ) noexcept -> bool
+      {
+         for( std::size_t i = pos; i < pos + size; ++i ) {
+            if( std::isxdigit( static_cast< unsigned char >( s[ i ] ) ) == 0 ) {
+               return false;
+            }
+         }
+         return true;
+      }
+
+      [[nodiscard]] auto to_system( const statement_event::time_point tp, const std::chrono::system_clock::time_point now, const statement_event::time_point steady_now ) noexcept -> std::chrono::system_clock::time_point
+      {
+         return now - std::chrono::duration_cast< std::chrono::system_clock::duration >( steady_now - tp );
+      }
+
+      [[nodiscard]] auto backend_pid( const pq::connection* c ) noexcept -> int
+      {
+         return ( c != nullptr ) ? PQbackendPID( c->underlying_raw_ptr() ) : 0;
+      }
+
+   }  // namespace
+
+   auto trace_context::generate() -> trace_context
+   {
+      return { random_hex() + random_hex(), random_hex() };
+   }
+
+   auto trace_context::from_traceparent( const std::string& traceparent ) -> trace_context
+   {
+      if( ( traceparent.size() < 55 ) || ( traceparent[ 2 ] != '-' ) || ( traceparent[ 35 ] != '-' ) || ( traceparent[ 52 ] != '-' ) || !is_hex( traceparent, 3, 32 ) || !is_hex( traceparent, 36, 16 ) ) {
+         throw std::invalid_argument( "invalid traceparent: " + traceparent );
+      }
+      return { traceparent.substr( 3, 32 ), traceparent.substr( 36, 16 ) };
+   }
+
+   auto trace_context::traceparent() const -> std::string
+   {
+      return "00-" + trace_id + '-' + span_id + "-01";
+   }
+
+   trace_scope::trace_scope( trace_context context ) noexcept
+      : m_context( std::move( context ) ),
+        m_previous( current_scope )
+   {
+      current_scope = this;
+   }
+
+   trace_scope::~trace_scope()
+   {
+      current_scope = m_previous;
+   }
+
+   auto trace_scope::current() noexcept -> const trace_context*
+   {
+      return ( current_scope != nullptr ) ? &current_scope->m_context : nullptr;
+   }
+
+   auto span::to_json() const -> std::string
+   {
+      const auto us = []( const std::chrono::system_clock::time_point tp ) {
+         return static_cast< long long >( std::chrono::duration_cast< std::chrono::microseconds >( tp.time_since_epoch() ).count() );
+      };
+      std::string nrv = "{\"name\":";
+      internal::json_string( nrv, name );
+      nrv += ",\"trace_id\":";
+      internal::json_string( nrv, trace_id );
+      nrv += ",\"span_id\":";
+      internal::json_string( nrv, span_id );
+      nrv += ",\"parent_span_id\":";
+      internal::json_string( nrv, parent_span_id );
+      nrv += internal::printf( ",\"start_us\":%lld,\"end_us\":%lld,\"statement\":", us( start ), us( end ) );
+      internal::json_string( nrv, statement );
+      nrv += internal::printf( ",\"backend_pid\":%d,\"rows\":%zu,\"error\":", backend_pid, rows );
+      internal::json_string( nrv, error );
+      nrv += '}';
+      return nrv;
+   }
+
+   void memory_span_sink::export_span( const span& s ) noexcept
+   {
+      try {
+         const std::lock_guard lock( m_mutex );
+         m_spans.push_back( s );
+      }
+      // LCOV_EXCL_START
+      catch( ... ) {
+      }
+      // LCOV_EXCL_STOP
+   }
+
+   auto memory_span_sink::spans() const -> std::vector< span >
+   {
+      const std::lock_guard lock( m_mutex );
+      return m_spans;
+   }
+
+   void memory_span_sink::clear() noexcept
+   {
+      const std::lock_guard lock( m_mutex );
+      m_spans.clear();
+   }
+
+   file_span_sink::file_span_sink( const std::string& filename )
+      : m_stream( filename, std::ios::app )
+   {
+      if( !m_stream ) {
+         throw std::runtime_error( "unable to open span file: " + filename );
+      }
+   }
+
+   void file_span_sink::export_span( const span& s ) noexcept
+   {
+      try {
+         const auto line = s.to_json() + '\n';
+         const std::lock_guard lock( m_mutex );
+         m_stream << line << std::flush;
+      }
+      // LCOV_EXCL_START
+      catch( ... ) {
+      }
+      // LCOV_EXCL_STOP
+   }
+
+   tracer::tracer( std::shared_ptr< span_sink > sink, const propagation p ) noexcept
+      : m_sink( std::move( sink ) ),
+        m_propagation( p )
+   {}
+
+   // the innermost open transaction on the connection, the thread's trace
+   // scope, or a new trace, in which case the returned span id is empty
+   auto tracer::parent( const pq::connection* c ) -> trace_context
+   {
+      {
+         const std::lock_guard lock( m_mutex );
+         const auto it = m_open.find( c );
+         if( ( it != m_open.end() ) && !it->second.empty() ) {
+            return { it->second.back().trace_id, it->second.back().span_id };
+         }
+      }
+      if( const auto* ctx = trace_scope::current() ) {
+         return *ctx;
+      }
+      return { trace_context::generate().trace_id, std::string() };
+   }
+
+   void tracer::on_statement( const statement_event& event ) noexcept
+   {
+      try {
+         span s;
+         s.name = "statement";
+         if( pending_tracer == this ) {
+            pending_tracer = nullptr;
+            s.trace_id = std::move( pending_context.trace_id );
+            s.span_id = std::move( pending_context.span_id );
+            s.parent_span_id = std::move( pending_parent_span_id );
+         }
+         else {
+            const auto p = parent( event.connection );
+            s.trace_id = p.trace_id;
+            s.parent_span_id = p.span_id;
+            s.span_id = random_hex();
+         }
+         const auto now = std::chrono::system_clock::now();
+         const auto steady_now = statement_event::clock::now();
+         s.start = to_system( event.started, now, steady_now );
+         s.end = to_system( event.decoded, now, steady_now );
+         s.statement = internal::fingerprint( event.statement );
+         s.backend_pid = backend_pid( event.connection );
+         s.rows = event.rows;
+         if( event.error != nullptr ) {
+            s.error = event.error;
+         }
+         m_sink->export_span( s );
+      }
+      // LCOV_EXCL_START
+      catch( ... ) {
+      }
+      // LCOV_EXCL_STOP
+   }
+
+   void tracer::on_transaction( const transaction_event& event ) noexcept
+   {
+      try {
+         if( event.what == transaction_event::kind::begin ) {
+            span s;
+            s.name = event.nested ? "savepoint" : "transaction";
+            const auto p = parent( event.connection );
+            s.trace_id = p.trace_id;
+            s.parent_span_id = p.span_id;
+            s.span_id = random_hex();
+            s.start = std::chrono::system_clock::now();
+            s.backend_pid = backend_pid( event.connection );
+            const std::lock_guard lock( m_mutex );
+            m_open[ event.connection ].push_back( std::move( s ) );
+            return;
+         }
+         span s;
+         {
+            const std::lock_guard lock( m_mutex );
+            const auto it = m_open.find( event.connection );
+            if( ( it == m_open.end() ) || it->second.empty() ) {
+               return;
+            }
+            s = std::move( it->second.back() );
+            it->second.pop_back();
+            if( it->second.empty() ) {
+               m_open.erase( it );
+            }
+         }
+         s.end = std::chrono::system_clock::now();
+         if( event.what == transaction_event::kind::rollback ) {
+            s.error = "rollback";
+         }
+         m_sink->export_span( s );
+      }
+      // LCOV_EXCL_START
+      catch( ... ) {
+      }
+      // LCOV_EXCL_STOP
+   }
+
+   auto tracer::annotate( const pq::connection& c, const char* /*unused*/ ) -> statement_annotation
+   {
+      statement_annotation nrv;
+      switch( m_propagation ) {
+         case propagation::none:
+            break;
+
+         case propagation::comment: {
+            auto p = parent( &c );
+            pending_tracer = this;
+            pending_parent_span_id = std::move( p.span_id );
+            pending_context = { std::move( p.trace_id ), random_hex() };
+            nrv.comment = "traceparent='" + pending_context.traceparent() + '\'';
+            break;
+         }
+
+         case propagation::application_name: {
+            // uses the parent's context, otherwise each statement would need an additional round-trip
+            const auto p = parent( &c );
+            if( !p.span_id.empty() ) {
+               nrv.application_name = p.traceparent();
+            }
+            break;
+         }
+      }
+      return nrv;
+   }
+
+}  // namespace tao::pq
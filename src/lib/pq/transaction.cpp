@@ -58,7 +58,14 @@ namespace tao::pq
          explicit top_level_transaction( const std::shared_ptr< pq::connection >& connection )
             : transaction_base( connection )
          {
-            execute( "START TRANSACTION" );
+            notify_observer( transaction_event::kind::begin );
+            try {
+               execute( "START TRANSACTION" );
+            }
+            catch( ... ) {
+               notify_observer( transaction_event::kind::rollback );
+               throw;
+            }
          }
 
          ~top_level_transaction() override
@@ -102,7 +109,14 @@ namespace tao::pq
          explicit nested_transaction( const std::shared_ptr< connection >& connection )
             : transaction_base( connection )
          {
-            execute( internal::printf( "SAVEPOINT \"TAOPQ_%p\"", static_cast< void* >( this ) ) );
+            notify_observer( transaction_event::kind::begin, true );
+            try {
+               execute( internal::printf( "SAVEPOINT \"TAOPQ_%p\"", static_cast< void* >( this ) ) );
+            }
+            catch( ... ) {
+               notify_observer( transaction_event::kind::rollback, true );
+               throw;
+            }
          }
 
          ~nested_transaction() override
@@ -160,7 +174,28 @@ namespace tao::pq
       }
    }
 
-   auto transaction::execute_params( const char* statement,
+   void transaction::notify_observer( const transaction_event::kind what, const bool nested ) const noexcept
+   {
+      if( m_connection && m_connection->m_observer && !v_is_direct() ) {
+         transaction_event event;
+         event.connection = m_connection.get();
+         event.transaction = this;
+         event.what = what;
+         event.nested = nested;
+         m_connection->m_observer->on_transaction( event );
+      }
+   }
+
+   auto transaction::observed_now() const noexcept -> statement_event::time_point
+   {
+      if( m_connection && m_connection->m_observer ) {
+         return statement_event::clock::now();
+      }
+      return statement_event::time_point();
+   }
+
+   auto transaction::execute_params( const statement_event::time_point started,
+                                     const char* statement,
                                      const int n_params,
                                      const Oid types[],
                                      const char* const values[],
@@ -168,7 +203,7 @@ namespace tao::pq
                                      const int formats[] ) -> result
    {
       check_current_transaction();
-      return m_connection->execute_params( statement, n_params, types, values, lengths, formats );
+      return m_connection->execute_params( started, statement, n_params, types, values, lengths, formats );
    }
 
    auto transaction::underlying_raw_ptr() const noexcept -> PGconn*
@@ -176,6 +211,11 @@ namespace tao::pq
       return m_connection->underlying_raw_ptr();
    }
 
+   auto transaction::types() const noexcept -> const type_catalog&
+   {
+      return m_connection->types();
+   }
+
    void transaction::commit()
    {
       check_current_transaction();
@@ -184,25 +224,31 @@ namespace tao::pq
       }
       // LCOV_EXCL_START
       catch( ... ) {
+         notify_observer( transaction_event::kind::rollback );
          v_reset();
          throw;
       }
       // LCOV_EXCL_STOP
+      notify_observer( transaction_event::kind::commit );
       v_reset();
    }
 
    void transaction::rollback()
    {
       check_current_transaction();
+      // settings like the application_name are reverted by the server
+      m_connection->m_application_name.clear();
       try {
          v_rollback();
       }
       // LCOV_EXCL_START
       catch( ... ) {
+         notify_observer( transaction_event::kind::rollback );
          v_reset();
          throw;
       }
       // LCOV_EXCL_STOP
+      notify_observer( transaction_event::kind::rollback );
       v_reset();
    }
 
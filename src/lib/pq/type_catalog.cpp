@@ -0,0 +1,112 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include <tao/pq/type_catalog.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+
+#include <tao/pq/internal/copy_format.hpp>
+#include <tao/pq/internal/parameter_binary_traits.hpp>
+#include <tao/pq/internal/parameter_text_traits.hpp>
+
+#include <tao/pq/result.hpp>
+#include <tao/pq/transaction.hpp>
+
+namespace tao::pq
+{
+   namespace internal
+   {
+      namespace
+      {
+         void append_hstore_text( std::string& s, const std::string& v )
+         {
+            s += '"';
+            for( const char c : v ) {
+               if( ( c == '"' ) || ( c == '\\' ) ) {
+                  s += '\\';
+               }
+               s += c;
+            }
+            s += '"';
+         }
+
+      }  // namespace
+
+      auto hstore_text( const hstore& v ) -> std::string
+      {
+         std::string nrv;
+         for( const auto& [ key, value ] : v.values ) {
+            if( !nrv.empty() ) {
+               nrv += ", ";
+            }
+            append_hstore_text( nrv, key );
+            nrv += "=>";
+            if( value ) {
+               append_hstore_text( nrv, *value );
+            }
+            else {
+               nrv += "NULL";
+            }
+         }
+         return nrv;
+      }
+
+      // the number of pairs, followed by the length and the bytes of each key
+      // and value, the length of a null value is -1
+      auto hstore_binary( const hstore& v ) -> std::string
+      {
+         std::string nrv;
+         const auto n = static_cast< std::uint32_t >( v.values.size() );
+         for( int shift = 24; shift >= 0; shift -= 8 ) {
+            nrv += static_cast< char >( ( n >> shift ) & 0xff );
+         }
+         for( const auto& [ key, value ] : v.values ) {
+            append_copy_binary_field( nrv, key.data(), static_cast< int >( key.size() ) );
+            append_copy_binary_field( nrv, value ? value->data() : nullptr, value ? static_cast< int >( value->size() ) : 0 );
+         }
+         return nrv;
+      }
+
+   }  // namespace internal
+
+   auto type_catalog::at( const std::string_view name ) const -> const entry&
+   {
+      const auto it = m_types.find( name );
+      if( it == m_types.end() ) {
+         throw std::out_of_range( "type '" + std::string( name ) + "' not in the type catalog" );
+      }
+      return it->second;
+   }
+
+   auto type_catalog::load( const std::shared_ptr< transaction >& tr, const std::vector< std::string >& names ) -> std::shared_ptr< const type_catalog >
+   {
+      auto nrv = std::make_shared< type_catalog >();
+      if( names.empty() ) {
+         return nrv;
+      }
+      const auto r = tr->execute( "SELECT n, t.oid, t.typarray FROM unnest( $1::TEXT[] ) AS n LEFT JOIN pg_type t ON t.oid = to_regtype( n )", names );
+      for( const auto& row : r ) {
+         if( !row.is_null( 1 ) ) {
+            nrv->m_types[ row.get< std::string >( 0 ) ] = { row.get< Oid >( 1 ), row.get< Oid >( 2 ) };
+         }
+      }
+      return nrv;
+   }
+
+   auto type_catalog::contains( const std::string_view name ) const -> bool
+   {
+      return m_types.find( name ) != m_types.end();
+   }
+
+   auto type_catalog::oid( const std::string_view name ) const -> Oid
+   {
+      return at( name ).oid;
+   }
+
+   auto type_catalog::array_oid( const std::string_view name ) const -> Oid
+   {
+      return at( name ).array;
+   }
+
+}  // namespace tao::pq
@@ -0,0 +1,147 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include "../macros.hpp"
+#include "../server.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <tao/pq.hpp>
+#include <tao/pq/connection_pool.hpp>
+
+#if !defined( _WIN32 )
+
+namespace
+{
+   using tao::pq::internal::canned_result;
+
+   std::atomic< int > executed( 0 );
+
+   auto handler( const std::string& statement, const std::vector< std::optional< std::string > >& parameters ) -> canned_result
+   {
+      ++executed;
+      if( statement == "FAIL" ) {
+         canned_result nrv;
+         nrv.error = "division by zero";
+         nrv.sqlstate = "22012";
+         return nrv;
+      }
+      return tao::pq::internal::default_canned_result( statement, parameters );
+   }
+
+   template< typename F >
+   void concurrently( const int n, const F& f )
+   {
+      std::atomic< int > ready( 0 );
+      std::vector< std::thread > threads;
+      for( int t = 0; t < n; ++t ) {
+         threads.emplace_back( [ &, t ] {
+            ++ready;
+            while( ready.load() < n ) {
+               std::this_thread::yield();
+            }
+            f( t );
+         } );
+      }
+      for( auto& t : threads ) {
+         t.join();
+      }
+   }
+
+   void basics()
+   {
+      const tao::pq::internal::test_server server( tao::pq::internal::test_server_options(), handler );
+      const auto pool = tao::pq::connection_pool::create( server.connection_info() );
+
+      TEST_ASSERT( pool->execute_coalesced( "SELECT 1" ).as< int >() == 1 );
+      TEST_ASSERT( pool->execute_coalesced( "SELECT $1", 42 ).as< int >() == 42 );
+      TEST_ASSERT( pool->execute_coalesced( std::string( "SELECT $1" ), "foo" ).as< std::string >() == "foo" );
+      TEST_ASSERT( pool->execute_coalesced< tao::pq::parameter_binary_traits >( "SELECT $1", "binary" ).as< std::string >() == "binary" );
+      TEST_ASSERT( pool->execute_coalesced( "SELECT $1", tao::pq::null )[ 0 ][ 0 ].is_null() );
+      TEST_THROWS( pool->execute_coalesced( "FAIL" ) );
+
+      // nothing was shared, sequential calls execute separately
+      TEST_ASSERT( pool->coalesced() == 0 );
+      TEST_ASSERT( server.connections() == 1 );
+   }
+
+   void shared()
+   {
+      tao::pq::internal::test_server_options options;
+      options.latency = std::chrono::milliseconds( 50 );
+      const tao::pq::internal::test_server server( options, handler );
+      const auto pool = tao::pq::connection_pool::create( server.connection_info() );
+
+      executed = 0;
+      std::atomic< int > errors( 0 );
+      concurrently( 16, [ & ]( const int /*unused*/ ) {
+         if( pool->execute_coalesced( "SELECT $1", 42 ).as< int >() != 42 ) {
+            ++errors;
+         }
+      } );
+      TEST_ASSERT( errors == 0 );
+      TEST_ASSERT( executed < 16 );
+      TEST_ASSERT( pool->coalesced() == static_cast< std::uint64_t >( 16 - executed ) );
+
+      // followers do not check out connections
+      TEST_ASSERT( server.connections() <= static_cast< std::size_t >( executed.load() ) );
+
+      // an error is shared as well
+      concurrently( 8, [ & ]( const int /*unused*/ ) {
+         try {
+            (void)pool->execute_coalesced( "FAIL" );
+            ++errors;
+         }
+         catch( const std::exception& ) {
+         }
+      } );
+      TEST_ASSERT( errors == 0 );
+
+      // different parameters are never shared
+      const auto before = pool->coalesced();
+      concurrently( 8, [ & ]( const int t ) {
+         if( pool->execute_coalesced( "SELECT $1", t ).as< int >() != t ) {
+            ++errors;
+         }
+      } );
+      TEST_ASSERT( errors == 0 );
+      TEST_ASSERT( pool->coalesced() == before );
+   }
+
+}  // namespace
+
+void run()
+{
+   basics();
+   shared();
+}
+
+#else
+
+void run()
+{
+}
+
+#endif
+
+auto main() -> int  // NOLINT(bugprone-exception-escape)
+{
+   try {
+      run();
+   }
+   catch( const std::exception& e ) {
+      std::cerr << "exception: " << e.what() << std::endl;
+      throw;
+   }
+   catch( ... ) {
+      std::cerr << "unknown exception" << std::endl;
+      throw;
+   }
+}
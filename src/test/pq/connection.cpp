@@ -82,6 +82,26 @@ void run()
 
    // read data
    TEST_ASSERT( connection->execute( "SELECT b FROM tao_connection_test WHERE a = 1" )[ 0 ][ 0 ].get() == std::string( "42" ) );
+
+   // each statement is one round-trip
+   const auto before = connection->wire_counters();
+   TEST_ASSERT( before.round_trips > 0 );
+   connection->execute( "SELECT 42" );
+   const auto one = connection->wire_counters() - before;
+   TEST_ASSERT( one.round_trips == 1 );
+   TEST_ASSERT( one.results == 1 );
+   TEST_ASSERT( one.estimated_bytes_sent == 55 );
+   TEST_ASSERT( one.estimated_bytes_received > 0 );
+
+   // a transaction adds the round-trips for starting and committing it
+   {
+      const auto tr = connection->transaction();
+      tr->execute( "SELECT 42" );
+      tr->commit();
+   }
+   const auto three = connection->wire_counters() - before - one;
+   TEST_ASSERT( three.round_trips == 3 );
+   TEST_ASSERT( three.results == 3 );
 }
 
 auto main() -> int
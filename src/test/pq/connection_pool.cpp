@@ -25,6 +25,13 @@ void run()
    TEST_ASSERT( pool2->connection()->execute( "SELECT 4" ).as< int >() == 4 );
    TEST_ASSERT( conn->execute( "SELECT 5" ).as< int >() == 5 );
    TEST_ASSERT( pool2->connection()->execute( "SELECT 6" ).as< int >() == 6 );
+
+   const auto metrics = pool->metrics();
+   TEST_ASSERT( metrics.in_use == 1 );
+   TEST_ASSERT( metrics.creations == metrics.idle + metrics.in_use );
+   TEST_ASSERT( metrics.checkouts == 5 );
+   TEST_ASSERT( metrics.checkout_latency.count() == 5 );
+   TEST_ASSERT( metrics.to_prometheus().find( "taopq_pool_checkouts_total 5\n" ) != std::string::npos );
 }
 
 auto main() -> int  // NOLINT(bugprone-exception-escape)
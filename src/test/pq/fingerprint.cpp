@@ -0,0 +1,41 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include "../macros.hpp"
+
+#include <tao/pq/internal/fingerprint.hpp>
+
+using tao::pq::internal::fingerprint;
+
+void run()
+{
+   TEST_ASSERT( fingerprint( "" ).empty() );
+   TEST_ASSERT( fingerprint( "SELECT 1" ) == "SELECT ?" );
+   TEST_ASSERT( fingerprint( "  SELECT\n\t1 ,  2  " ) == "SELECT ? , ?" );
+   TEST_ASSERT( fingerprint( "SELECT * FROM t WHERE a = 42 AND b = 'foo'" ) == "SELECT * FROM t WHERE a = ? AND b = ?" );
+   TEST_ASSERT( fingerprint( "SELECT * FROM t WHERE a = 43 AND b = 'bar'" ) == fingerprint( "SELECT * FROM t WHERE a = 42 AND b = 'foo'" ) );
+   TEST_ASSERT( fingerprint( "SELECT 'it''s'" ) == "SELECT ?" );
+   TEST_ASSERT( fingerprint( "SELECT E'a\\'b', e'c'" ) == "SELECT ?, ?" );
+   TEST_ASSERT( fingerprint( "SELECT 1.5e-3, 0x1F, .5" ) == "SELECT ?, ?, .?" );
+   TEST_ASSERT( fingerprint( "SELECT $$foo$$, $tag$b'a'r$tag$" ) == "SELECT ?, ?" );
+   TEST_ASSERT( fingerprint( "SELECT $1, $2" ) == "SELECT $1, $2" );
+   TEST_ASSERT( fingerprint( "SELECT t1.c2 FROM t1" ) == "SELECT t1.c2 FROM t1" );
+   TEST_ASSERT( fingerprint( "SELECT \"a 1\" FROM \"T\"\"2\"" ) == "SELECT \"a 1\" FROM \"T\"\"2\"" );
+   TEST_ASSERT( fingerprint( "SELECT 1 -- comment\n, /* other */ 2" ) == "SELECT ? , ?" );
+   TEST_ASSERT( fingerprint( "SELECT 'unterminated" ) == "SELECT ?" );
+}
+
+auto main() -> int
+{
+   try {
+      run();
+   }
+   catch( const std::exception& e ) {
+      std::cerr << "exception: " << e.what() << std::endl;
+      throw;
+   }
+   catch( ... ) {
+      std::cerr << "unknown exception" << std::endl;
+      throw;
+   }
+}
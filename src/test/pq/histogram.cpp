@@ -0,0 +1,80 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include "../macros.hpp"
+
+#include <cstdint>
+
+#include <tao/pq/internal/histogram.hpp>
+
+using tao::pq::internal::histogram;
+using tao::pq::internal::histogram_buckets;
+
+void run()
+{
+   // bucket boundaries are consistent
+   for( std::size_t i = 0; i + 1 < histogram_buckets::size; ++i ) {
+      TEST_ASSERT( histogram_buckets::index( histogram_buckets::lower_bound( i ) ) == i );
+      TEST_ASSERT( histogram_buckets::index( histogram_buckets::lower_bound( i + 1 ) - 1 ) == i );
+   }
+   TEST_ASSERT( histogram_buckets::index( 0 ) == 0 );
+   TEST_ASSERT( histogram_buckets::index( 31 ) == 31 );
+   TEST_ASSERT( histogram_buckets::index( UINT64_MAX ) == histogram_buckets::size - 1 );
+
+   // relative error stays below 1/16
+   for( std::uint64_t v = 1; v < ( std::uint64_t( 1 ) << 40 ); v = v * 3 + 1 ) {
+      const auto lower = histogram_buckets::lower_bound( histogram_buckets::index( v ) );
+      TEST_ASSERT( lower <= v );
+      TEST_ASSERT( ( v - lower ) * 16 <= v );
+   }
+
+   histogram h;
+   TEST_ASSERT( h.snapshot().count() == 0 );
+   TEST_ASSERT( h.snapshot().percentile( 0.5 ) == 0 );
+
+   for( std::uint64_t v = 1; v <= 1000; ++v ) {
+      h.record( v * 1000 );
+   }
+   const auto s = h.snapshot();
+   TEST_ASSERT( s.count() == 1000 );
+   TEST_ASSERT( s.max() == 1000000 );
+   TEST_ASSERT( s.sum() == 500500000 );
+   TEST_ASSERT( s.mean() == 500500 );
+   TEST_ASSERT( s.percentile( 0.5 ) > 500000 * 15 / 16 );
+   TEST_ASSERT( s.percentile( 0.5 ) < 500000 * 17 / 16 );
+   TEST_ASSERT( s.percentile( 0.99 ) > 990000 * 15 / 16 );
+   TEST_ASSERT( s.percentile( 0.99 ) <= 1000000 );
+   TEST_ASSERT( s.percentile( 1.0 ) <= 1000000 );
+   TEST_ASSERT( s.count_below( 0 ) == 0 );
+   TEST_ASSERT( s.count_below( 2000000 ) == 1000 );
+   TEST_ASSERT( s.count_below( 500000 ) <= 500 );
+   TEST_ASSERT( s.count_below( 500000 ) >= 500 * 15 / 16 );
+
+   // a bucket is only counted when all of its values are within the bound
+   histogram b;
+   b.record( 41 );
+   TEST_ASSERT( histogram_buckets::index( 40 ) == histogram_buckets::index( 41 ) );
+   TEST_ASSERT( b.snapshot().count_below( 40 ) == 0 );
+   TEST_ASSERT( b.snapshot().count_below( 41 ) == 1 );
+
+   auto sum = s;
+   sum += s;
+   TEST_ASSERT( sum.count() == 2000 );
+   TEST_ASSERT( sum.max() == 1000000 );
+   TEST_ASSERT( sum.percentile( 0.5 ) == s.percentile( 0.5 ) );
+}
+
+auto main() -> int
+{
+   try {
+      run();
+   }
+   catch( const std::exception& e ) {
+      std::cerr << "exception: " << e.what() << std::endl;
+      throw;
+   }
+   catch( ... ) {
+      std::cerr << "unknown exception" << std::endl;
+      throw;
+   }
+}
@@ -0,0 +1,200 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include "../macros.hpp"
+#include "../server.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <tao/pq.hpp>
+#include <tao/pq/connection_pool.hpp>
+#include <tao/pq/job_queue.hpp>
+
+#if !defined( _WIN32 )
+
+namespace
+{
+   using tao::pq::internal::canned_result;
+
+   // the stand-in server does not see the COPY data, the jobs handed out
+   // by the dequeue statement are set up by the test instead
+   std::mutex mutex;
+   std::vector< std::string > statements;
+   std::deque< std::pair< std::string, std::string > > pending;
+   std::vector< std::string > acknowledged;
+
+   auto handler( const std::string& statement, const std::vector< std::optional< std::string > >& parameters ) -> canned_result
+   {
+      const std::lock_guard lock( mutex );
+      statements.push_back( statement );
+      if( statement.find( "SKIP LOCKED" ) != std::string::npos ) {
+         canned_result nrv;
+         nrv.columns = { "id", "payload" };
+         const auto n = std::min( pending.size(), static_cast< std::size_t >( std::stoul( *parameters.at( 0 ) ) ) );
+         for( std::size_t i = 0; i < n; ++i ) {
+            nrv.rows.push_back( { pending.front().first, pending.front().second } );
+            pending.pop_front();
+         }
+         return nrv;
+      }
+      if( statement.compare( 0, 6, "DELETE" ) == 0 ) {
+         acknowledged.push_back( *parameters.at( 0 ) );
+      }
+      return tao::pq::internal::default_canned_result( statement, parameters );
+   }
+
+   [[nodiscard]] auto count( const std::string& statement ) -> std::size_t
+   {
+      const std::lock_guard lock( mutex );
+      return static_cast< std::size_t >( std::count( statements.begin(), statements.end(), statement ) );
+   }
+
+   void set_pending( std::deque< std::pair< std::string, std::string > > jobs )
+   {
+      const std::lock_guard lock( mutex );
+      pending = std::move( jobs );
+   }
+
+   void basics()
+   {
+      const tao::pq::internal::test_server server( tao::pq::internal::test_server_options(), handler );
+      const auto pool = tao::pq::connection_pool::create( server.connection_info() );
+
+      tao::pq::job_queue_options options;
+      options.batch_size = 2;
+      const auto queue = tao::pq::job_queue::create( pool, options );
+      TEST_ASSERT( queue->listening() );
+
+      queue->enqueue( std::vector< std::string >{ "a", "b\tc", "d" } );
+      TEST_ASSERT( server.copied_rows() == 3 );
+      queue->enqueue( "e" );
+      TEST_ASSERT( count( "INSERT INTO taopq_jobs ( payload ) VALUES ( $1 )" ) == 1 );
+      TEST_ASSERT( queue->enqueued() == 4 );
+
+      set_pending( { { "1", "a" }, { "2", "b" }, { "3", "c" } } );
+      auto batch = queue->dequeue();
+      TEST_ASSERT( batch.size() == 2 );
+      TEST_ASSERT( batch.jobs()[ 0 ].id == 1 );
+      TEST_ASSERT( batch.jobs()[ 1 ].payload == "b" );
+      batch.acknowledge();
+      TEST_ASSERT( acknowledged.back() == "{\"1\",\"2\"}" );
+      TEST_THROWS( batch.acknowledge() );
+
+      batch = queue->dequeue();
+      TEST_ASSERT( batch.size() == 1 );
+      batch.acknowledge( {} );
+      TEST_ASSERT( acknowledged.size() == 1 );
+
+      TEST_ASSERT( queue->dequeue().empty() );
+      TEST_ASSERT( queue->dequeued() == 3 );
+
+      // the statements are prepared once per connection
+      TEST_ASSERT( count( "SELECT id, payload FROM taopq_jobs ORDER BY id LIMIT $1 FOR UPDATE SKIP LOCKED" ) == 3 );
+      TEST_ASSERT( server.connections() <= 3 );
+
+      set_pending( { { "4", "x" } } );
+      batch = queue->dequeue();
+      batch.release();
+      TEST_ASSERT( acknowledged.size() == 1 );
+
+      // enqueued as part of a transaction
+      const auto tr = pool->connection()->transaction();
+      queue->enqueue( tr, { "f", "g" } );
+      tr->commit();
+      TEST_ASSERT( server.copied_rows() == 5 );
+
+      options.batch_size = 0;
+      TEST_THROWS( tao::pq::job_queue::create( pool, options ) );
+   }
+
+   void wakeup()
+   {
+      const tao::pq::internal::test_server server( tao::pq::internal::test_server_options(), handler );
+      const auto pool = tao::pq::connection_pool::create( server.connection_info() );
+
+      tao::pq::job_queue_options options;
+      options.poll_interval = std::chrono::seconds( 60 );
+      const auto queue = tao::pq::job_queue::create( pool, options );
+
+      // a waiting worker is woken by the notification of enqueue()
+      set_pending( {} );
+      const auto start = std::chrono::steady_clock::now();
+      std::thread worker( [ & ] {
+         const auto batch = queue->dequeue( std::chrono::seconds( 30 ) );
+         TEST_ASSERT( batch.size() == 1 );
+      } );
+      std::this_thread::sleep_for( std::chrono::milliseconds( 50 ) );
+      set_pending( { { "1", "a" } } );
+      queue->enqueue( "a" );
+      worker.join();
+      TEST_ASSERT( std::chrono::steady_clock::now() - start < std::chrono::seconds( 10 ) );
+
+      // without a notification, the worker waits for the timeout
+      const auto before = std::chrono::steady_clock::now();
+      TEST_ASSERT( queue->dequeue( std::chrono::milliseconds( 50 ) ).empty() );
+      TEST_ASSERT( std::chrono::steady_clock::now() - before >= std::chrono::milliseconds( 50 ) );
+   }
+
+   void polling()
+   {
+      const tao::pq::internal::test_server server( tao::pq::internal::test_server_options(), handler );
+      const auto pool = tao::pq::connection_pool::create( server.connection_info() );
+
+      tao::pq::job_queue_options options;
+      options.channel.clear();
+      options.poll_interval = std::chrono::milliseconds( 10 );
+      const auto queue = tao::pq::job_queue::create( pool, options );
+      TEST_ASSERT( !queue->listening() );
+
+      set_pending( {} );
+      std::thread producer( [] {
+         std::this_thread::sleep_for( std::chrono::milliseconds( 50 ) );
+         set_pending( { { "1", "a" } } );
+      } );
+      const auto batch = queue->dequeue( std::chrono::seconds( 30 ) );
+      producer.join();
+      TEST_ASSERT( batch.size() == 1 );
+      queue->enqueue( "b" );
+      TEST_ASSERT( queue->enqueued() == 1 );
+   }
+
+}  // namespace
+
+void run()
+{
+   basics();
+   wakeup();
+   polling();
+}
+
+#else
+
+void run()
+{
+}
+
+#endif
+
+auto main() -> int  // NOLINT(bugprone-exception-escape)
+{
+   try {
+      run();
+   }
+   catch( const std::exception& e ) {
+      std::cerr << "exception: " << e.what() << std::endl;
+      throw;
+   }
+   catch( ... ) {
+      std::cerr << "unknown exception" << std::endl;
+      throw;
+   }
+}
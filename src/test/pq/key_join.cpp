@@ -0,0 +1,159 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include "../macros.hpp"
+#include "../server.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <tao/pq.hpp>
+#include <tao/pq/key_join.hpp>
+
+#if !defined( _WIN32 )
+
+namespace
+{
+   using tao::pq::internal::canned_result;
+
+   std::vector< std::string > statements;
+   std::vector< std::optional< std::string > > last_parameters;
+
+   auto handler( const std::string& statement, const std::vector< std::optional< std::string > >& parameters ) -> canned_result
+   {
+      statements.push_back( statement );
+      if( statement.find( "fail" ) != std::string::npos ) {
+         canned_result nrv;
+         nrv.error = "relation \"fail\" does not exist";
+         nrv.sqlstate = "42P01";
+         return nrv;
+      }
+      if( statement.find( "JOIN" ) != std::string::npos ) {
+         last_parameters = parameters;
+         canned_result nrv;
+         nrv.columns = { "id" };
+         nrv.rows = { { "1" }, { "2" } };
+         return nrv;
+      }
+      return tao::pq::internal::default_canned_result( statement, parameters );
+   }
+
+   [[nodiscard]] auto executed( const std::string& statement ) -> bool
+   {
+      return std::find( statements.begin(), statements.end(), statement ) != statements.end();
+   }
+
+   void array()
+   {
+      const tao::pq::internal::test_server server( tao::pq::internal::test_server_options(), handler );
+      const auto connection = tao::pq::connection::create( server.connection_info() );
+
+      statements.clear();
+      const auto r = tao::pq::key_join( connection->direct(), "SELECT u.id FROM users u JOIN {keys} k ON u.id = k.key", std::vector< int >{ 1, 2, 3 } );
+      TEST_ASSERT( r.size() == 2 );
+      TEST_ASSERT( statements.size() == 1 );
+      TEST_ASSERT( statements[ 0 ] == "SELECT u.id FROM users u JOIN ( SELECT unnest( $1::INTEGER[] ) AS key ) k ON u.id = k.key" );
+      TEST_ASSERT( last_parameters.size() == 1 );
+      TEST_ASSERT( last_parameters[ 0 ] == "{\"1\",\"2\",\"3\"}" );
+
+      tao::pq::key_join_options options;
+      options.type = "UUID";
+      (void)tao::pq::key_join( connection->direct(), "SELECT * FROM t JOIN {keys} k USING ( key )", std::vector< std::string >{ "a" }, options );
+      TEST_ASSERT( statements.back() == "SELECT * FROM t JOIN ( SELECT unnest( $1::UUID[] ) AS key ) k USING ( key )" );
+
+      TEST_THROWS( (void)tao::pq::key_join( connection->direct(), "SELECT * FROM t", std::vector< int >{ 1 } ) );
+      TEST_THROWS( (void)tao::pq::key_join( connection->direct(), "SELECT * FROM t JOIN {keys} k USING ( key )", std::vector< const char* >{ "a" } ) );
+
+      // the type is restricted to names and modifiers
+      options.type = "NUMERIC( 10, 2 )";
+      (void)tao::pq::key_join( connection->direct(), "SELECT * FROM t JOIN {keys} k USING ( key )", std::vector< std::string >{ "1.5" }, options );
+      TEST_ASSERT( statements.back() == "SELECT * FROM t JOIN ( SELECT unnest( $1::NUMERIC( 10, 2 )[] ) AS key ) k USING ( key )" );
+      for( const auto* type : { "INT[]); DROP TABLE users; --", "TEXT'", "NUMERIC( 10", "INT )(" } ) {
+         options.type = type;
+         TEST_THROWS( (void)tao::pq::key_join( connection->direct(), "SELECT * FROM t JOIN {keys} k USING ( key )", std::vector< std::string >{ "a" }, options ) );
+      }
+   }
+
+   void temporary_table()
+   {
+      const tao::pq::internal::test_server server( tao::pq::internal::test_server_options(), handler );
+      const auto connection = tao::pq::connection::create( server.connection_info() );
+
+      std::vector< int > keys;
+      for( int i = 0; i < 20000; ++i ) {
+         keys.push_back( i );
+      }
+
+      // text format with an explicit type
+      statements.clear();
+      tao::pq::key_join_options options;
+      options.type = "BIGINT";
+      const auto r = tao::pq::key_join( connection->direct(), "SELECT u.id FROM users u JOIN {keys} k ON u.id = k.key", keys, options );
+      TEST_ASSERT( r.size() == 2 );
+      TEST_ASSERT( executed( "CREATE TEMPORARY TABLE \"taopq_keys\" ( key BIGINT )" ) );
+      TEST_ASSERT( executed( "ANALYZE \"taopq_keys\"" ) );
+      TEST_ASSERT( executed( "SELECT u.id FROM users u JOIN \"taopq_keys\" k ON u.id = k.key" ) );
+      TEST_ASSERT( executed( "DROP TABLE \"taopq_keys\"" ) );
+      TEST_ASSERT( executed( "COMMIT TRANSACTION" ) );
+      TEST_ASSERT( server.copied_rows() == keys.size() );
+
+      // binary format with a derived type
+      statements.clear();
+      options = tao::pq::key_join_options();
+      options.analyze = false;
+      options.table = "my_keys";
+      const std::vector< long long > big( keys.begin(), keys.end() );
+      (void)tao::pq::key_join( connection->direct(), "SELECT u.id FROM users u JOIN {keys} k ON u.id = k.key", big, options );
+      TEST_ASSERT( executed( "CREATE TEMPORARY TABLE \"my_keys\" ( key BIGINT )" ) );
+      TEST_ASSERT( !executed( "ANALYZE \"my_keys\"" ) );
+      TEST_ASSERT( executed( "DROP TABLE \"my_keys\"" ) );
+
+      // the table is quoted as an identifier
+      statements.clear();
+      options.table = "my\"keys";
+      (void)tao::pq::key_join( connection->direct(), "SELECT u.id FROM users u JOIN {keys} k ON u.id = k.key", big, options );
+      TEST_ASSERT( executed( "CREATE TEMPORARY TABLE \"my\"\"keys\" ( key BIGINT )" ) );
+      TEST_ASSERT( executed( "SELECT u.id FROM users u JOIN \"my\"\"keys\" k ON u.id = k.key" ) );
+      TEST_ASSERT( executed( "DROP TABLE \"my\"\"keys\"" ) );
+
+      // the temporary table is rolled back with the statement
+      statements.clear();
+      const auto tr = connection->transaction();
+      TEST_THROWS( (void)tao::pq::key_join( tr, "SELECT * FROM fail JOIN {keys} k USING ( key )", keys ) );
+      TEST_ASSERT( !executed( "DROP TABLE \"taopq_keys\"" ) );
+      TEST_ASSERT( statements.back().find( "ROLLBACK TO" ) == 0 );
+      tr->commit();
+   }
+
+}  // namespace
+
+void run()
+{
+   array();
+   temporary_table();
+}
+
+#else
+
+void run()
+{
+}
+
+#endif
+
+auto main() -> int  // NOLINT(bugprone-exception-escape)
+{
+   try {
+      run();
+   }
+   catch( const std::exception& e ) {
+      std::cerr << "exception: " << e.what() << std::endl;
+      throw;
+   }
+   catch( ... ) {
+      std::cerr << "unknown exception" << std::endl;
+      throw;
+   }
+}
@@ -0,0 +1,148 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include "../macros.hpp"
+#include "../server.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <tao/pq.hpp>
+#include <tao/pq/connection_pool.hpp>
+#include <tao/pq/lookup_batcher.hpp>
+
+#if !defined( _WIN32 )
+
+namespace
+{
+   using tao::pq::internal::canned_result;
+
+   std::atomic< int > batches( 0 );
+
+   // answers "... = ANY( $1 )" with a row per key, except for the key 13,
+   // the array literal is parsed just enough for the keys sent by the test
+   auto handler( const std::string& statement, const std::vector< std::optional< std::string > >& parameters ) -> canned_result
+   {
+      if( statement.find( "ANY" ) == std::string::npos ) {
+         return tao::pq::internal::default_canned_result( statement, parameters );
+      }
+      ++batches;
+      if( statement.find( "fail" ) != std::string::npos ) {
+         canned_result nrv;
+         nrv.error = "relation \"fail\" does not exist";
+         nrv.sqlstate = "42P01";
+         return nrv;
+      }
+      canned_result nrv;
+      nrv.columns = { "id", "name" };
+      std::string key;
+      for( const char c : *parameters.at( 0 ) ) {
+         if( ( c == ',' ) || ( c == '}' ) ) {
+            if( key != "13" ) {
+               nrv.rows.push_back( { key, "user" + key } );
+            }
+            key.clear();
+         }
+         else if( ( c != '{' ) && ( c != '"' ) ) {
+            key += c;
+         }
+      }
+      return nrv;
+   }
+
+   void arrays()
+   {
+      const tao::pq::internal::test_server server;
+      const auto connection = tao::pq::connection::create( server.connection_info() );
+
+      TEST_ASSERT( connection->execute( "SELECT $1", std::vector< int >{ 1, 2, 3 } ).as< std::string >() == "{\"1\",\"2\",\"3\"}" );
+      TEST_ASSERT( connection->execute( "SELECT $1", std::vector< int >() ).as< std::string >() == "{}" );
+      const std::vector< std::optional< std::string > > strings = { "a\"b", std::nullopt, "c\\d", "" };
+      TEST_ASSERT( connection->execute( "SELECT $1", strings ).as< std::string >() == "{\"a\\\"b\",NULL,\"c\\\\d\",\"\"}" );
+      TEST_ASSERT( connection->execute< tao::pq::parameter_binary_traits >( "SELECT $1", std::vector< bool >{ true, false } ).as< std::string >() == "{\"true\",\"false\"}" );
+   }
+
+   void basics()
+   {
+      const tao::pq::internal::test_server server( tao::pq::internal::test_server_options(), handler );
+      const auto pool = tao::pq::connection_pool::create( server.connection_info() );
+      const auto batcher = tao::pq::lookup_batcher< int, std::string >::create( pool, "SELECT id, name FROM users WHERE id = ANY( $1 )" );
+
+      batches = 0;
+      TEST_ASSERT( batcher->get( 1 ) == "user1" );
+      TEST_ASSERT( !batcher->get( 13 ) );
+      TEST_ASSERT( batches == 2 );
+      TEST_ASSERT( batcher->lookups() == 2 );
+      TEST_ASSERT( batcher->batches() == 2 );
+
+      const auto failing = tao::pq::lookup_batcher< int, std::string >::create( pool, "SELECT id, name FROM fail WHERE id = ANY( $1 )" );
+      TEST_THROWS( failing->get( 1 ) );
+   }
+
+   void concurrent()
+   {
+      tao::pq::internal::test_server_options options;
+      options.latency = std::chrono::milliseconds( 5 );
+      const tao::pq::internal::test_server server( options, handler );
+      const auto pool = tao::pq::connection_pool::create( server.connection_info() );
+      tao::pq::lookup_batcher_options batcher_options;
+      batcher_options.window = std::chrono::milliseconds( 20 );
+      batcher_options.max_keys = 16;
+      const auto batcher = tao::pq::lookup_batcher< int, std::string >::create( pool, "SELECT id, name FROM users WHERE id = ANY( $1 )", batcher_options );
+
+      batches = 0;
+      std::atomic< int > errors( 0 );
+      std::vector< std::thread > threads;
+      for( int t = 0; t < 64; ++t ) {
+         threads.emplace_back( [ &, t ] {
+            const int key = t % 40;
+            const auto value = batcher->get( key );
+            if( ( key == 13 ) ? value.has_value() : ( value != "user" + std::to_string( key ) ) ) {
+               ++errors;
+            }
+         } );
+      }
+      for( auto& t : threads ) {
+         t.join();
+      }
+      TEST_ASSERT( errors == 0 );
+      TEST_ASSERT( batcher->lookups() == 64 );
+      TEST_ASSERT( batcher->batches() == static_cast< std::uint64_t >( batches.load() ) );
+      TEST_ASSERT( batches < 64 );
+   }
+
+}  // namespace
+
+void run()
+{
+   arrays();
+   basics();
+   concurrent();
+}
+
+#else
+
+void run()
+{
+}
+
+#endif
+
+auto main() -> int  // NOLINT(bugprone-exception-escape)
+{
+   try {
+      run();
+   }
+   catch( const std::exception& e ) {
+      std::cerr << "exception: " << e.what() << std::endl;
+      throw;
+   }
+   catch( ... ) {
+      std::cerr << "unknown exception" << std::endl;
+      throw;
+   }
+}
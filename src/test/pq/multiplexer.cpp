@@ -0,0 +1,150 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include "../macros.hpp"
+#include "../server.hpp"
+
+#include <future>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <tao/pq.hpp>
+#include <tao/pq/multiplexer.hpp>
+
+#if defined( LIBPQ_HAS_PIPELINING ) && !defined( _WIN32 )
+
+namespace
+{
+   using tao::pq::internal::canned_result;
+
+   auto handler( const std::string& statement, const std::vector< std::optional< std::string > >& parameters ) -> canned_result
+   {
+      if( statement == "FAIL" ) {
+         canned_result nrv;
+         nrv.error = "division by zero";
+         nrv.sqlstate = "22012";
+         return nrv;
+      }
+      return tao::pq::internal::default_canned_result( statement, parameters );
+   }
+
+   void basics()
+   {
+      const tao::pq::internal::test_server server( tao::pq::internal::test_server_options(), handler );
+      const auto multiplexer = tao::pq::multiplexer::create( server.connection_info() );
+
+      auto a = multiplexer->execute( "SELECT $1", 1 );
+      auto b = multiplexer->execute( "FAIL" );
+      auto c = multiplexer->execute( "SELECT $1, $2", "foo", tao::pq::null );
+      auto d = multiplexer->execute< tao::pq::parameter_binary_traits >( "SELECT $1", "binary" );
+
+      // the error does not affect the other statements
+      TEST_ASSERT( a.get().as< int >() == 1 );
+      TEST_THROWS( b.get() );
+      const auto r = c.get();
+      TEST_ASSERT( r[ 0 ][ 0 ].as< std::string >() == "foo" );
+      TEST_ASSERT( r[ 0 ][ 1 ].is_null() );
+      TEST_ASSERT( d.get().as< std::string >() == "binary" );
+
+      // the arguments need not outlive the call
+      std::future< tao::pq::result > temporary;
+      {
+         const std::string value = "temporary";
+         temporary = multiplexer->execute( "SELECT $1", value );
+      }
+      TEST_ASSERT( temporary.get().as< std::string >() == "temporary" );
+
+      multiplexer->prepare( "p", "SELECT $1" );
+      TEST_ASSERT( multiplexer->execute( "p", 7 ).get().as< int >() == 7 );
+      TEST_THROWS( multiplexer->prepare( "invalid name", "SELECT 1" ) );
+
+      TEST_ASSERT( multiplexer->execute( "INSERT INTO t VALUES ( $1 )", 1 ).get().rows_affected() == 1 );
+      TEST_ASSERT( server.connections() == 1 );
+   }
+
+   void threads()
+   {
+      tao::pq::internal::test_server_options options;
+      options.latency = std::chrono::milliseconds( 1 );
+      const tao::pq::internal::test_server server( options, handler );
+      const auto multiplexer = tao::pq::multiplexer::create( server.connection_info() );
+
+      std::vector< std::thread > threads;
+      std::vector< int > errors( 16 );
+      for( int t = 0; t < 16; ++t ) {
+         threads.emplace_back( [ &, t ] {
+            std::vector< std::future< tao::pq::result > > results;
+            for( int i = 0; i < 20; ++i ) {
+               results.push_back( multiplexer->execute( ( i % 5 == 4 ) ? "FAIL" : "SELECT $1", t * 100 + i ) );
+            }
+            for( int i = 0; i < 20; ++i ) {
+               try {
+                  if( results[ i ].get().as< int >() != t * 100 + i ) {
+                     ++errors[ t ];
+                  }
+               }
+               catch( const std::exception& ) {
+                  if( i % 5 != 4 ) {
+                     ++errors[ t ];
+                  }
+               }
+            }
+         } );
+      }
+      for( auto& t : threads ) {
+         t.join();
+      }
+      for( const auto e : errors ) {
+         TEST_ASSERT( e == 0 );
+      }
+      TEST_ASSERT( multiplexer->pending() == 0 );
+      TEST_ASSERT( server.connections() == 1 );
+   }
+
+   void shutdown()
+   {
+      std::future< tao::pq::result > f;
+      {
+         tao::pq::internal::test_server_options options;
+         options.latency = std::chrono::milliseconds( 10 );
+         const tao::pq::internal::test_server server( options );
+         const auto multiplexer = tao::pq::multiplexer::create( server.connection_info() );
+         f = multiplexer->execute( "SELECT 1" );
+      }
+      // completed when the multiplexer is destroyed
+      TEST_ASSERT( f.get().as< int >() == 1 );
+   }
+
+}  // namespace
+
+void run()
+{
+   basics();
+   threads();
+   shutdown();
+}
+
+#else
+
+void run()
+{
+}
+
+#endif
+
+auto main() -> int  // NOLINT(bugprone-exception-escape)
+{
+   try {
+      run();
+   }
+   catch( const std::exception& e ) {
+      std::cerr << "exception: " << e.what() << std::endl;
+      throw;
+   }
+   catch( ... ) {
+      std::cerr << "unknown exception" << std::endl;
+      throw;
+   }
+}
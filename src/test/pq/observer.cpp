@@ -0,0 +1,145 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include "../getenv.hpp"
+#include "../macros.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <tao/pq/connection.hpp>
+#include <tao/pq/connection_pool.hpp>
+#include <tao/pq/tracing.hpp>
+
+class recording_observer
+   : public tao::pq::observer
+{
+public:
+   struct record
+   {
+      std::string statement;
+      bool prepared;
+      int parameters;
+      std::size_t bytes_sent;
+      std::size_t rows;
+      bool failed;
+      bool ordered;
+   };
+
+   std::vector< record > records;
+
+   void on_statement( const tao::pq::statement_event& e ) noexcept override
+   {
+      const bool ordered = ( e.started <= e.encoded ) && ( e.encoded <= e.sent ) && ( e.sent <= e.responded ) && ( e.responded <= e.received ) && ( e.received <= e.decoded );
+      records.push_back( { e.statement, e.prepared, e.parameters, e.bytes_sent, e.rows, e.error != nullptr, ordered } );
+   }
+};
+
+void run()
+{
+   // overwrite the default with an environment variable if needed
+   const auto connection_string = tao::pq::internal::getenv( "TAOPQ_TEST_DATABASE", "dbname=template1" );
+
+   const auto connection = tao::pq::connection::create( connection_string );
+   TEST_ASSERT( !connection->observer() );
+
+   // nothing is recorded without an observer
+   const auto observer = std::make_shared< recording_observer >();
+   TEST_EXECUTE( connection->execute( "SELECT 1" ) );
+   TEST_ASSERT( observer->records.empty() );
+
+   connection->set_observer( observer );
+   TEST_ASSERT( connection->observer() == observer );
+
+   TEST_ASSERT( connection->execute( "SELECT 42" ).as< int >() == 42 );
+   TEST_ASSERT( observer->records.size() == 1 );
+   TEST_ASSERT( observer->records[ 0 ].statement == "SELECT 42" );
+   TEST_ASSERT( !observer->records[ 0 ].prepared );
+   TEST_ASSERT( observer->records[ 0 ].parameters == 0 );
+   TEST_ASSERT( observer->records[ 0 ].bytes_sent > 0 );
+   TEST_ASSERT( observer->records[ 0 ].rows == 1 );
+   TEST_ASSERT( !observer->records[ 0 ].failed );
+   TEST_ASSERT( observer->records[ 0 ].ordered );
+
+   TEST_ASSERT( connection->execute( "SELECT * FROM generate_series( $1::INTEGER, $2::INTEGER )", 1, 5 ).size() == 5 );
+   TEST_ASSERT( observer->records.size() == 2 );
+   TEST_ASSERT( observer->records[ 1 ].parameters == 2 );
+   TEST_ASSERT( observer->records[ 1 ].rows == 5 );
+   TEST_ASSERT( observer->records[ 1 ].bytes_sent > observer->records[ 0 ].bytes_sent );
+   TEST_ASSERT( observer->records[ 1 ].ordered );
+
+   connection->prepare( "observed", "SELECT $1::INTEGER" );
+   TEST_ASSERT( connection->execute( "observed", 7 ).as< int >() == 7 );
+   TEST_ASSERT( observer->records.size() == 3 );
+   TEST_ASSERT( observer->records[ 2 ].prepared );
+
+   // failed statements are reported as well
+   TEST_THROWS( connection->execute( "FOO BAR BAZ" ) );
+   TEST_ASSERT( observer->records.size() == 4 );
+   TEST_ASSERT( observer->records[ 3 ].failed );
+   TEST_ASSERT( observer->records[ 3 ].ordered );
+
+   // transactions report their control statements, too
+   {
+      const auto tr = connection->transaction();
+      tr->execute( "SELECT 1" );
+      tr->commit();
+   }
+   TEST_ASSERT( observer->records.size() == 7 );
+
+   connection->set_observer( nullptr );
+   TEST_EXECUTE( connection->execute( "SELECT 1" ) );
+   TEST_ASSERT( observer->records.size() == 7 );
+
+   // pools install their observer on each connection handed out
+   const auto pool = tao::pq::connection_pool::create( connection_string );
+   const auto pool_observer = std::make_shared< recording_observer >();
+   pool->set_observer( pool_observer );
+   TEST_ASSERT( pool->observer() == pool_observer );
+   TEST_ASSERT( pool->execute( "SELECT 1" ).as< int >() == 1 );
+   TEST_ASSERT( pool->connection()->execute( "SELECT 2" ).as< int >() == 2 );
+   TEST_ASSERT( pool_observer->records.size() == 2 );
+
+   pool->set_observer( nullptr );
+   TEST_ASSERT( pool->execute( "SELECT 3" ).as< int >() == 3 );
+   TEST_ASSERT( pool_observer->records.size() == 2 );
+
+   // the trace context is visible to the server
+   const auto sink = std::make_shared< tao::pq::memory_span_sink >();
+   connection->set_observer( std::make_shared< tao::pq::tracer >( sink, tao::pq::tracer::propagation::comment ) );
+   const auto query = connection->execute( "SELECT query FROM pg_stat_activity WHERE pid = pg_backend_pid()" ).as< std::string >();
+   TEST_ASSERT( sink->spans().size() == 1 );
+   TEST_ASSERT( sink->spans()[ 0 ].backend_pid == connection->execute( "SELECT pg_backend_pid()" ).as< int >() );
+   TEST_ASSERT( query.find( sink->spans()[ 0 ].span_id ) != std::string::npos );
+
+   const tao::pq::trace_scope scope( tao::pq::trace_context::generate() );
+   connection->set_observer( std::make_shared< tao::pq::tracer >( sink, tao::pq::tracer::propagation::application_name ) );
+   TEST_ASSERT( connection->execute( "SHOW application_name" ).as< std::string >() == tao::pq::trace_scope::current()->traceparent() );
+   {
+      const auto tr = connection->transaction();
+      TEST_ASSERT( tr->execute( "SHOW application_name" ).as< std::string >() != tao::pq::trace_scope::current()->traceparent() );
+      tr->commit();
+   }
+   connection->set_observer( std::make_shared< tao::pq::observer_list >( std::vector< std::shared_ptr< tao::pq::observer > >{ observer, std::make_shared< tao::pq::tracer >( sink ) } ) );
+   sink->clear();
+   const auto before = observer->records.size();
+   TEST_EXECUTE( connection->execute( "SELECT 1" ) );
+   TEST_ASSERT( observer->records.size() == before + 1 );
+   TEST_ASSERT( sink->spans().size() == 1 );
+}
+
+auto main() -> int  // NOLINT(bugprone-exception-escape)
+{
+   try {
+      run();
+   }
+   catch( const std::exception& e ) {
+      std::cerr << "exception: " << e.what() << std::endl;
+      throw;
+   }
+   catch( ... ) {
+      std::cerr << "unknown exception" << std::endl;
+      throw;
+   }
+}
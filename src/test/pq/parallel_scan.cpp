@@ -0,0 +1,227 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include "../macros.hpp"
+#include "../server.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <tao/pq.hpp>
+#include <tao/pq/connection_pool.hpp>
+#include <tao/pq/parallel_scan.hpp>
+
+#if !defined( _WIN32 )
+
+namespace
+{
+   using tao::pq::internal::canned_result;
+
+   std::mutex mutex;
+   std::vector< std::string > statements;
+
+   // the rows left in the session's cursor, each session has its own thread
+   thread_local int cursor_next = 0;
+   thread_local int cursor_end = 0;
+
+   // a cursor is declared over the ids from the lower to the upper bound
+   auto handler( const std::string& statement, const std::vector< std::optional< std::string > >& parameters ) -> canned_result
+   {
+      {
+         const std::lock_guard lock( mutex );
+         statements.push_back( statement );
+      }
+      if( statement == "SELECT pg_export_snapshot()" ) {
+         canned_result nrv;
+         nrv.columns = { "pg_export_snapshot" };
+         nrv.rows = { { "00000003-0000001B-1" } };
+         return nrv;
+      }
+      if( statement.find( "pg_relation_size" ) != std::string::npos ) {
+         canned_result nrv;
+         nrv.columns = { "?column?" };
+         nrv.rows = { { "10" } };
+         return nrv;
+      }
+      if( statement.find( "fail" ) != std::string::npos ) {
+         canned_result nrv;
+         nrv.error = "relation \"fail\" does not exist";
+         nrv.sqlstate = "42P01";
+         return nrv;
+      }
+      if( statement.find( "DECLARE taopq_scan NO SCROLL CURSOR FOR " ) == 0 ) {
+         cursor_next = std::stoi( *parameters.at( 0 ) );
+         cursor_end = std::stoi( *parameters.at( 1 ) );
+         canned_result nrv;
+         nrv.command = "DECLARE CURSOR";
+         return nrv;
+      }
+      if( statement.find( "FETCH FORWARD " ) == 0 ) {
+         const int n = std::stoi( statement.substr( 14 ) );
+         canned_result nrv;
+         nrv.columns = { "id" };
+         for( int i = 0; ( i < n ) && ( cursor_next < cursor_end ); ++i ) {
+            nrv.rows.push_back( { std::to_string( cursor_next++ ) } );
+         }
+         nrv.command = "FETCH " + std::to_string( nrv.rows.size() );
+         return nrv;
+      }
+      return tao::pq::internal::default_canned_result( statement, parameters );
+   }
+
+   [[nodiscard]] auto count( const std::string& statement ) -> std::size_t
+   {
+      const std::lock_guard lock( mutex );
+      return static_cast< std::size_t >( std::count( statements.begin(), statements.end(), statement ) );
+   }
+
+   void scan()
+   {
+      const tao::pq::internal::test_server server( tao::pq::internal::test_server_options(), handler );
+      const auto pool = tao::pq::connection_pool::create( server.connection_info() );
+
+      std::vector< std::pair< int, int > > partitions;
+      for( int i = 0; i < 10; ++i ) {
+         partitions.emplace_back( i * 100, ( i + 1 ) * 100 );
+      }
+
+      statements.clear();
+      std::mutex results_mutex;
+      std::set< std::pair< std::size_t, int > > results;
+      std::size_t chunks = 0;
+      tao::pq::parallel_scan( pool, "SELECT * FROM events WHERE id >= $1 AND id < $2", partitions, [ & ]( const std::size_t i, const tao::pq::result& r ) {
+         const std::lock_guard lock( results_mutex );
+         TEST_ASSERT( r.size() == 100 );
+         for( const auto& row : r ) {
+            results.emplace( i, row.get< int >( 0 ) );
+         }
+         ++chunks;
+      } );
+      TEST_ASSERT( results.size() == 1000 );
+      for( std::size_t i = 0; i < 10; ++i ) {
+         TEST_ASSERT( results.count( { i, static_cast< int >( i * 100 ) } ) == 1 );
+         TEST_ASSERT( results.count( { i, static_cast< int >( i * 100 + 99 ) } ) == 1 );
+      }
+      TEST_ASSERT( chunks == 10 );
+      TEST_ASSERT( count( "DECLARE taopq_scan NO SCROLL CURSOR FOR SELECT * FROM events WHERE id >= $1 AND id < $2" ) == 10 );
+      TEST_ASSERT( count( "FETCH FORWARD 10000 FROM taopq_scan" ) == 10 );
+      TEST_ASSERT( count( "CLOSE taopq_scan" ) == 10 );
+      TEST_ASSERT( count( "SELECT pg_export_snapshot()" ) == 1 );
+      TEST_ASSERT( count( "SET TRANSACTION SNAPSHOT '00000003-0000001B-1'" ) == 4 );
+      TEST_ASSERT( count( "START TRANSACTION ISOLATION LEVEL REPEATABLE READ" ) == 5 );
+      TEST_ASSERT( count( "COMMIT TRANSACTION" ) == 5 );
+
+      // partitions larger than a chunk are fetched in several chunks, the memory
+      // used is bounded by the chunk size instead of the partition size
+      statements.clear();
+      results.clear();
+      tao::pq::parallel_scan_options options;
+      options.fetch_rows = 30;
+      std::vector< std::size_t > sizes;
+      tao::pq::parallel_scan( pool, "SELECT * FROM events WHERE id >= $1 AND id < $2", partitions, [ & ]( const std::size_t i, const tao::pq::result& r ) {
+         const std::lock_guard lock( results_mutex );
+         sizes.push_back( r.size() );
+         for( const auto& row : r ) {
+            results.emplace( i, row.get< int >( 0 ) );
+         }
+      }, options );
+      TEST_ASSERT( results.size() == 1000 );
+      TEST_ASSERT( sizes.size() == 40 );
+      TEST_ASSERT( *std::max_element( sizes.begin(), sizes.end() ) == 30 );
+      TEST_ASSERT( std::count( sizes.begin(), sizes.end(), 10 ) == 10 );
+      TEST_ASSERT( count( "FETCH FORWARD 30 FROM taopq_scan" ) == 40 );
+
+      // a full last chunk needs one more fetch, empty chunks are not passed on
+      statements.clear();
+      sizes.clear();
+      options.fetch_rows = 50;
+      tao::pq::parallel_scan( pool, "SELECT * FROM events WHERE id >= $1 AND id < $2", partitions, [ & ]( const std::size_t /*unused*/, const tao::pq::result& r ) {
+         const std::lock_guard lock( results_mutex );
+         sizes.push_back( r.size() );
+      }, options );
+      TEST_ASSERT( sizes.size() == 20 );
+      TEST_ASSERT( count( "FETCH FORWARD 50 FROM taopq_scan" ) == 30 );
+
+      options.fetch_rows = 0;
+      TEST_THROWS( tao::pq::parallel_scan( pool, "SELECT * FROM events WHERE id >= $1 AND id < $2", partitions, [ & ]( const std::size_t /*unused*/, const tao::pq::result& /*unused*/ ) {}, options ) );
+      options = tao::pq::parallel_scan_options();
+
+      // fewer partitions than workers
+      statements.clear();
+      options.workers = 8;
+      std::atomic< int > calls( 0 );
+      tao::pq::parallel_scan( pool, "SELECT * FROM events WHERE id >= $1 AND id < $2", std::vector< std::pair< int, int > >{ { 1, 2 }, { 2, 3 } }, [ & ]( const std::size_t /*unused*/, const tao::pq::result& /*unused*/ ) { ++calls; }, options );
+      TEST_ASSERT( calls == 2 );
+      TEST_ASSERT( count( "SET TRANSACTION SNAPSHOT '00000003-0000001B-1'" ) <= 2 );
+
+      options.workers = 0;
+      TEST_THROWS( tao::pq::parallel_scan( pool, "SELECT * FROM events WHERE id >= $1 AND id < $2", partitions, [ & ]( const std::size_t /*unused*/, const tao::pq::result& /*unused*/ ) {}, options ) );
+   }
+
+   void failure()
+   {
+      const tao::pq::internal::test_server server( tao::pq::internal::test_server_options(), handler );
+      const auto pool = tao::pq::connection_pool::create( server.connection_info() );
+
+      const std::vector< std::pair< int, int > > partitions = { { 0, 1 }, { 1, 2 }, { 2, 3 } };
+      TEST_THROWS( tao::pq::parallel_scan( pool, "SELECT * FROM fail WHERE id >= $1 AND id < $2", partitions, [ & ]( const std::size_t /*unused*/, const tao::pq::result& /*unused*/ ) {} ) );
+
+      int calls = 0;
+      TEST_THROWS( tao::pq::parallel_scan( pool, "SELECT * FROM events WHERE id >= $1 AND id < $2", partitions, [ & ]( const std::size_t /*unused*/, const tao::pq::result& /*unused*/ ) {
+         ++calls;
+         throw std::runtime_error( "callback failed" );
+      }, tao::pq::parallel_scan_options{ 1 } ) );
+      TEST_ASSERT( calls == 1 );
+   }
+
+   void ctids()
+   {
+      const tao::pq::internal::test_server server( tao::pq::internal::test_server_options(), handler );
+      const auto connection = tao::pq::connection::create( server.connection_info() );
+
+      const auto partitions = tao::pq::ctid_partitions( connection->direct(), "events", 3 );
+      TEST_ASSERT( partitions.size() == 3 );
+      TEST_ASSERT( partitions[ 0 ] == std::make_pair( std::string( "(0,0)" ), std::string( "(3,0)" ) ) );
+      TEST_ASSERT( partitions[ 1 ] == std::make_pair( std::string( "(3,0)" ), std::string( "(6,0)" ) ) );
+      TEST_ASSERT( partitions[ 2 ] == std::make_pair( std::string( "(6,0)" ), std::string( "(4294967295,0)" ) ) );
+      TEST_THROWS( tao::pq::ctid_partitions( connection->direct(), "events", 0 ) );
+   }
+
+}  // namespace
+
+void run()
+{
+   scan();
+   failure();
+   ctids();
+}
+
+#else
+
+void run()
+{
+}
+
+#endif
+
+auto main() -> int  // NOLINT(bugprone-exception-escape)
+{
+   try {
+      run();
+   }
+   catch( const std::exception& e ) {
+      std::cerr << "exception: " << e.what() << std::endl;
+      throw;
+   }
+   catch( ... ) {
+      std::cerr << "unknown exception" << std::endl;
+      throw;
+   }
+}
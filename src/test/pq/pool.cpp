@@ -0,0 +1,115 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include "../macros.hpp"
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <tao/pq/internal/pool.hpp>
+
+namespace
+{
+   struct item
+   {
+      bool valid = true;
+   };
+
+   class item_pool
+      : public tao::pq::internal::pool< item >
+   {
+   public:
+      bool fail = false;
+
+   private:
+      [[nodiscard]] auto v_create() const -> std::unique_ptr< item > override
+      {
+         if( fail ) {
+            throw std::runtime_error( "creation failed" );
+         }
+         return std::make_unique< item >();
+      }
+
+      [[nodiscard]] auto v_is_valid( item& i ) const noexcept -> bool override
+      {
+         return i.valid;
+      }
+   };
+
+}  // namespace
+
+void run()
+{
+   const auto pool = std::make_shared< item_pool >();
+   TEST_ASSERT( pool->metrics().idle == 0 );
+   TEST_ASSERT( pool->metrics().in_use == 0 );
+   {
+      const auto i1 = pool->get();
+      const auto i2 = pool->get();
+      const auto m = pool->metrics();
+      TEST_ASSERT( m.idle == 0 );
+      TEST_ASSERT( m.in_use == 2 );
+      TEST_ASSERT( m.checkouts == 2 );
+      TEST_ASSERT( m.creations == 2 );
+      TEST_ASSERT( m.checkout_latency.count() == 2 );
+   }
+   {
+      const auto m = pool->metrics();
+      TEST_ASSERT( m.idle == 2 );
+      TEST_ASSERT( m.in_use == 0 );
+   }
+   {
+      // reuses an idle item
+      const auto i = pool->get();
+      const auto m = pool->metrics();
+      TEST_ASSERT( m.idle == 1 );
+      TEST_ASSERT( m.in_use == 1 );
+      TEST_ASSERT( m.creations == 2 );
+      TEST_ASSERT( m.connection_age.count() == 3 );
+
+      // invalid items are not returned to the pool
+      i->valid = false;
+   }
+   TEST_ASSERT( pool->metrics().idle == 1 );
+   TEST_ASSERT( pool->metrics().invalidated == 1 );
+   {
+      // detached items are no longer accounted as in use
+      const auto i = pool->get();
+      TEST_ASSERT( pool->metrics().in_use == 1 );
+      item_pool::detach( i );
+      TEST_ASSERT( pool->metrics().in_use == 0 );
+   }
+   TEST_ASSERT( pool->metrics().idle == 0 );
+
+   pool->fail = true;
+   TEST_THROWS( pool->get() );
+   TEST_ASSERT( pool->metrics().creation_failures == 1 );
+   TEST_ASSERT( pool->metrics().checkouts == 4 );
+   TEST_ASSERT( pool->metrics().in_use == 0 );
+
+   const auto text = pool->metrics().to_prometheus( "test_pool" );
+   TEST_ASSERT( text.find( "# TYPE test_pool_idle_connections gauge\ntest_pool_idle_connections 0\n" ) != std::string::npos );
+   TEST_ASSERT( text.find( "test_pool_checkouts_total 4\n" ) != std::string::npos );
+   TEST_ASSERT( text.find( "test_pool_creation_failures_total 1\n" ) != std::string::npos );
+   TEST_ASSERT( text.find( "test_pool_invalidated_total 1\n" ) != std::string::npos );
+   TEST_ASSERT( text.find( "# TYPE test_pool_checkout_seconds histogram\n" ) != std::string::npos );
+   TEST_ASSERT( text.find( "test_pool_checkout_seconds_bucket{le=\"+Inf\"} 4\n" ) != std::string::npos );
+   TEST_ASSERT( text.find( "test_pool_connection_age_seconds_bucket{le=\"1\"} 4\n" ) != std::string::npos );
+   TEST_ASSERT( text.find( "test_pool_checkout_seconds_count 4\n" ) != std::string::npos );
+}
+
+auto main() -> int
+{
+   try {
+      run();
+   }
+   catch( const std::exception& e ) {
+      std::cerr << "exception: " << e.what() << std::endl;
+      throw;
+   }
+   catch( ... ) {
+      std::cerr << "unknown exception" << std::endl;
+      throw;
+   }
+}
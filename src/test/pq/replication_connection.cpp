@@ -0,0 +1,298 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include "../macros.hpp"
+#include "../server.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <tao/pq.hpp>
+#include <tao/pq/replication_connection.hpp>
+
+#if !defined( _WIN32 )
+
+namespace
+{
+   using tao::pq::internal::canned_result;
+   using tao::pq::change_event;
+
+   std::mutex mutex;
+   std::vector< std::string > statements;
+
+   auto handler( const std::string& statement, const std::vector< std::optional< std::string > >& parameters ) -> canned_result
+   {
+      {
+         const std::lock_guard lock( mutex );
+         statements.push_back( statement );
+      }
+      if( ( statement.compare( 0, 23, "CREATE_REPLICATION_SLOT" ) == 0 ) && ( statement.find( "\"existing\"" ) != std::string::npos ) ) {
+         canned_result nrv;
+         nrv.error = "replication slot \"existing\" already exists";
+         nrv.sqlstate = "42710";
+         return nrv;
+      }
+      if( statement.find( "\"missing\"" ) != std::string::npos ) {
+         canned_result nrv;
+         nrv.error = "replication slot \"missing\" does not exist";
+         nrv.sqlstate = "42704";
+         return nrv;
+      }
+      return tao::pq::internal::default_canned_result( statement, parameters );
+   }
+
+   [[nodiscard]] auto executed( const std::string& statement ) -> bool
+   {
+      const std::lock_guard lock( mutex );
+      return std::find( statements.begin(), statements.end(), statement ) != statements.end();
+   }
+
+   // builds pgoutput messages
+   struct message
+   {
+      std::string data;
+
+      explicit message( const char type )
+         : data( 1, type )
+      {}
+
+      auto u8( const char v ) -> message&
+      {
+         data += v;
+         return *this;
+      }
+
+      auto u16( const int v ) -> message&
+      {
+         return bytes( static_cast< std::uint64_t >( v ), 2 );
+      }
+
+      auto u32( const std::uint32_t v ) -> message&
+      {
+         return bytes( v, 4 );
+      }
+
+      auto u64( const std::uint64_t v ) -> message&
+      {
+         return bytes( v, 8 );
+      }
+
+      auto bytes( const std::uint64_t v, const int size ) -> message&
+      {
+         for( int shift = ( size - 1 ) * 8; shift >= 0; shift -= 8 ) {
+            data += static_cast< char >( ( v >> shift ) & 0xff );
+         }
+         return *this;
+      }
+
+      auto string( const std::string& v ) -> message&
+      {
+         data += v;
+         data += '\0';
+         return *this;
+      }
+
+      auto text( const std::string& v ) -> message&
+      {
+         u8( 't' ).u32( static_cast< std::uint32_t >( v.size() ) );
+         data += v;
+         return *this;
+      }
+   };
+
+   [[nodiscard]] auto values( const std::vector< std::optional< std::string > >& v ) -> std::string
+   {
+      std::string nrv;
+      for( const auto& e : v ) {
+         nrv += e ? *e : "NULL";
+         nrv += ';';
+      }
+      return nrv;
+   }
+
+   void lsn()
+   {
+      TEST_ASSERT( tao::pq::format_lsn( 0 ) == "0/0" );
+      TEST_ASSERT( tao::pq::format_lsn( 0x16B374D848 ) == "16/B374D848" );
+      TEST_ASSERT( tao::pq::parse_lsn( "16/B374D848" ) == 0x16B374D848 );
+      TEST_THROWS( tao::pq::parse_lsn( "16" ) );
+      TEST_THROWS( tao::pq::parse_lsn( "16/B374D848x" ) );
+   }
+
+   void pgoutput()
+   {
+      tao::pq::internal::test_server server( tao::pq::internal::test_server_options(), handler );
+      server.stream( { message( 'R' ).u32( 16384 ).string( "public" ).string( "users" ).u8( 'd' ).u16( 2 ).u8( 1 ).string( "id" ).u32( 23 ).u32( 0xffffffff ).u8( 0 ).string( "name" ).u32( 25 ).u32( 0xffffffff ).data,
+                       message( 'B' ).u64( 0x2000 ).u64( 0 ).u32( 700 ).data,
+                       message( 'I' ).u32( 16384 ).u8( 'N' ).u16( 2 ).text( "1" ).u8( 'n' ).data,
+                       message( 'U' ).u32( 16384 ).u8( 'K' ).u16( 2 ).text( "1" ).u8( 'n' ).u8( 'N' ).u16( 2 ).text( "2" ).u8( 'u' ).data,
+                       message( 'U' ).u32( 16384 ).u8( 'N' ).u16( 2 ).text( "2" ).text( "bob" ).data,
+                       message( 'D' ).u32( 16384 ).u8( 'K' ).u16( 2 ).text( "2" ).u8( 'n' ).data,
+                       message( 'T' ).u32( 1 ).u8( 0 ).u32( 16384 ).data,
+                       message( 'C' ).u8( 0 ).u64( 0x2000 ).u64( 0x2100 ).u64( 0 ).data } );
+
+      tao::pq::replication_options options;
+      options.publications = { "pub" };
+      const auto c = tao::pq::replication_connection::create( server.connection_info(), options );
+      TEST_ASSERT( executed( "CREATE_REPLICATION_SLOT \"taopq\" LOGICAL \"pgoutput\" NOEXPORT_SNAPSHOT" ) );
+      TEST_ASSERT( executed( "START_REPLICATION SLOT \"taopq\" LOGICAL 0/0 ( proto_version '1', publication_names '\"pub\"' )" ) );
+
+      std::vector< change_event > events;
+      while( const auto e = c->next( std::chrono::seconds( 10 ) ) ) {
+         events.push_back( *e );
+         if( e->type == change_event::kind::commit ) {
+            break;
+         }
+      }
+      TEST_ASSERT( events.size() == 7 );
+      TEST_ASSERT( events[ 0 ].type == change_event::kind::begin );
+      TEST_ASSERT( events[ 0 ].xid == 700 );
+      TEST_ASSERT( events[ 1 ].type == change_event::kind::insert );
+      TEST_ASSERT( events[ 1 ].schema == "public" );
+      TEST_ASSERT( events[ 1 ].table == "users" );
+      TEST_ASSERT( events[ 1 ].columns == std::vector< std::string >{ "id", "name" } );
+      TEST_ASSERT( values( events[ 1 ].values ) == "1;NULL;" );
+      TEST_ASSERT( events[ 1 ].unchanged == std::vector< bool >{ false, false } );
+      TEST_ASSERT( events[ 1 ].old_values.empty() );
+      TEST_ASSERT( events[ 1 ].xid == 700 );
+      TEST_ASSERT( events[ 2 ].type == change_event::kind::update );
+      TEST_ASSERT( values( events[ 2 ].old_values ) == "1;NULL;" );
+      TEST_ASSERT( values( events[ 2 ].values ) == "2;NULL;" );
+      // the NULL old value was set, the new value was not changed
+      TEST_ASSERT( events[ 2 ].unchanged == std::vector< bool >{ false, true } );
+      TEST_ASSERT( events[ 3 ].old_values.empty() );
+      TEST_ASSERT( values( events[ 3 ].values ) == "2;bob;" );
+      TEST_ASSERT( events[ 3 ].unchanged == std::vector< bool >{ false, false } );
+      TEST_ASSERT( events[ 4 ].type == change_event::kind::delete_ );
+      TEST_ASSERT( values( events[ 4 ].old_values ) == "2;NULL;" );
+      TEST_ASSERT( events[ 4 ].unchanged.empty() );
+      TEST_ASSERT( events[ 5 ].type == change_event::kind::truncate );
+      TEST_ASSERT( events[ 5 ].table == "users" );
+      TEST_ASSERT( events[ 6 ].type == change_event::kind::commit );
+      TEST_ASSERT( events[ 6 ].lsn == 0x2100 );
+      TEST_ASSERT( c->received() == 0x8000 );
+
+      // the keepalive requests a status update, acknowledgements are sent with the next one
+      TEST_ASSERT( !c->next( std::chrono::milliseconds( 50 ) ) );
+      TEST_ASSERT( server.status_updates() >= 1 );
+      TEST_ASSERT( server.flushed_lsn() == 0 );
+      c->acknowledge( events[ 6 ].lsn );
+      c->acknowledge( 0x1000 );
+      TEST_ASSERT( c->acknowledged() == 0x2100 );
+      c->send_status();
+      for( int i = 0; ( i < 1000 ) && ( server.flushed_lsn() != 0x2100 ); ++i ) {
+         std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+      }
+      TEST_ASSERT( server.flushed_lsn() == 0x2100 );
+   }
+
+   void test_decoding()
+   {
+      tao::pq::internal::test_server server( tao::pq::internal::test_server_options(), handler );
+      server.stream( { "BEGIN 529",
+                       "table public.data: INSERT: id[integer]:1 data[text]:'it''s' note[character varying]:null",
+                       "table public.\"odd \"\"name\"\"\": UPDATE: old-key: id[integer]:1 new-tuple: id[integer]:2 tags[text[]]:'{a,b}'",
+                       "table public.data: UPDATE: id[integer]:2 data[text]:unchanged-toast-datum",
+                       "table public.data: DELETE: id[integer]:2",
+                       "table public.data: TRUNCATE: (no-flags)",
+                       "COMMIT 529" } );
+
+      tao::pq::replication_options options;
+      options.slot = "existing";
+      options.plugin = "test_decoding";
+      options.start = 0x1000;
+      options.status_interval = std::chrono::milliseconds( 10 );
+      const auto c = tao::pq::replication_connection::create( server.connection_info(), options );
+      TEST_ASSERT( executed( "START_REPLICATION SLOT \"existing\" LOGICAL 0/1000" ) );
+
+      std::vector< change_event > events;
+      for( int i = 0; i < 7; ++i ) {
+         const auto e = c->next( std::chrono::seconds( 10 ) );
+         TEST_ASSERT( e );
+         events.push_back( *e );
+      }
+      TEST_ASSERT( events[ 0 ].type == change_event::kind::begin );
+      TEST_ASSERT( events[ 0 ].xid == 529 );
+      TEST_ASSERT( events[ 1 ].type == change_event::kind::insert );
+      TEST_ASSERT( events[ 1 ].schema == "public" );
+      TEST_ASSERT( events[ 1 ].table == "data" );
+      TEST_ASSERT( events[ 1 ].xid == 529 );
+      TEST_ASSERT( events[ 1 ].columns == std::vector< std::string >{ "id", "data", "note" } );
+      TEST_ASSERT( values( events[ 1 ].values ) == "1;it's;NULL;" );
+      TEST_ASSERT( events[ 1 ].unchanged == std::vector< bool >{ false, false, false } );
+      TEST_ASSERT( events[ 2 ].type == change_event::kind::update );
+      TEST_ASSERT( events[ 2 ].table == "odd \"name\"" );
+      TEST_ASSERT( values( events[ 2 ].old_values ) == "1;" );
+      TEST_ASSERT( events[ 2 ].columns == std::vector< std::string >{ "id", "tags" } );
+      TEST_ASSERT( values( events[ 2 ].values ) == "2;{a,b};" );
+      TEST_ASSERT( values( events[ 3 ].values ) == "2;NULL;" );
+      TEST_ASSERT( events[ 3 ].unchanged == std::vector< bool >{ false, true } );
+      TEST_ASSERT( events[ 4 ].type == change_event::kind::delete_ );
+      TEST_ASSERT( events[ 4 ].columns == std::vector< std::string >{ "id" } );
+      TEST_ASSERT( values( events[ 4 ].old_values ) == "2;" );
+      TEST_ASSERT( events[ 5 ].type == change_event::kind::truncate );
+      TEST_ASSERT( events[ 6 ].type == change_event::kind::commit );
+      TEST_ASSERT( events[ 6 ].lsn == 0x7000 );
+
+      // status updates are sent periodically
+      c->acknowledge( events[ 6 ].lsn );
+      const auto updates = server.status_updates();
+      TEST_ASSERT( !c->next( std::chrono::milliseconds( 100 ) ) );
+      TEST_ASSERT( server.status_updates() > updates + 1 );
+      TEST_ASSERT( server.flushed_lsn() == 0x7000 );
+   }
+
+   void errors()
+   {
+      const tao::pq::internal::test_server server( tao::pq::internal::test_server_options(), handler );
+
+      tao::pq::replication_options options;
+      options.plugin = "wal2json";
+      TEST_THROWS( tao::pq::replication_connection::create( server.connection_info(), options ) );
+
+      options = tao::pq::replication_options();
+      options.slot = "missing";
+      options.create_slot = false;
+      TEST_THROWS( tao::pq::replication_connection::create( server.connection_info(), options ) );
+
+      TEST_THROWS( tao::pq::replication_connection::create( "host=127.0.0.1 port=1 connect_timeout=1" ) );
+   }
+
+}  // namespace
+
+void run()
+{
+   lsn();
+   pgoutput();
+   test_decoding();
+   errors();
+}
+
+#else
+
+void run()
+{
+}
+
+#endif
+
+auto main() -> int  // NOLINT(bugprone-exception-escape)
+{
+   try {
+      run();
+   }
+   catch( const std::exception& e ) {
+      std::cerr << "exception: " << e.what() << std::endl;
+      throw;
+   }
+   catch( ... ) {
+      std::cerr << "unknown exception" << std::endl;
+      throw;
+   }
+}
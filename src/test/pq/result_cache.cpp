@@ -0,0 +1,208 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include "../macros.hpp"
+#include "../server.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <tao/pq.hpp>
+#include <tao/pq/connection_pool.hpp>
+#include <tao/pq/result_cache.hpp>
+
+#if !defined( _WIN32 )
+
+namespace
+{
+   using tao::pq::internal::canned_result;
+
+   std::atomic< int > executed( 0 );
+
+   auto handler( const std::string& statement, const std::vector< std::optional< std::string > >& parameters ) -> canned_result
+   {
+      if( statement.rfind( "SELECT", 0 ) == 0 ) {
+         ++executed;
+      }
+      return tao::pq::internal::default_canned_result( statement, parameters );
+   }
+
+   // notifications arrive asynchronously
+   template< typename F >
+   [[nodiscard]] auto eventually( const F& f ) -> bool
+   {
+      const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds( 5 );
+      while( !f() ) {
+         if( std::chrono::steady_clock::now() > deadline ) {
+            return false;
+         }
+         std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+      }
+      return true;
+   }
+
+   void basics()
+   {
+      const tao::pq::internal::test_server server( tao::pq::internal::test_server_options(), handler );
+      const auto pool = tao::pq::connection_pool::create( server.connection_info() );
+      const auto cache = tao::pq::result_cache::create( pool );
+      TEST_ASSERT( cache->listening() );
+
+      executed = 0;
+      TEST_ASSERT( cache->execute( "SELECT $1", 1 ).as< int >() == 1 );
+      TEST_ASSERT( cache->execute( "SELECT $1", 1 ).as< int >() == 1 );
+      TEST_ASSERT( cache->execute( std::string( "SELECT $1" ), 1 ).as< int >() == 1 );
+      TEST_ASSERT( executed == 1 );
+
+      // the key is made from the encoded parameters, not from the arguments
+      TEST_ASSERT( cache->execute( "SELECT $1", "1" ).as< int >() == 1 );
+      TEST_ASSERT( executed == 1 );
+
+      // different statements or parameters are different entries
+      TEST_ASSERT( cache->execute( "SELECT $1", 2 ).as< int >() == 2 );
+      TEST_ASSERT( cache->execute( "SELECT $1, $2", 1, 2 )[ 0 ][ 1 ].as< int >() == 2 );
+      TEST_ASSERT( cache->execute( "SELECT $1", tao::pq::null )[ 0 ][ 0 ].is_null() );
+      TEST_ASSERT( cache->execute( "SELECT 1" ).as< int >() == 1 );
+      TEST_ASSERT( executed == 5 );
+
+      const auto m = cache->metrics();
+      TEST_ASSERT( m.hits == 3 );
+      TEST_ASSERT( m.misses == 5 );
+      TEST_ASSERT( m.entries == 5 );
+      TEST_ASSERT( m.bytes > 0 );
+
+      cache->clear();
+      TEST_ASSERT( cache->metrics().entries == 0 );
+      TEST_ASSERT( cache->metrics().bytes == 0 );
+      TEST_ASSERT( cache->execute( "SELECT $1", 1 ).as< int >() == 1 );
+      TEST_ASSERT( executed == 6 );
+   }
+
+   void expiration()
+   {
+      const tao::pq::internal::test_server server( tao::pq::internal::test_server_options(), handler );
+      const auto pool = tao::pq::connection_pool::create( server.connection_info() );
+      const auto cache = tao::pq::result_cache::create( pool );
+
+      executed = 0;
+      tao::pq::cache_policy policy;
+      policy.ttl = std::chrono::milliseconds( 20 );
+      TEST_ASSERT( cache->execute( policy, "SELECT $1", 1 ).as< int >() == 1 );
+      TEST_ASSERT( cache->execute( policy, "SELECT $1", 1 ).as< int >() == 1 );
+      TEST_ASSERT( executed == 1 );
+      std::this_thread::sleep_for( std::chrono::milliseconds( 50 ) );
+      TEST_ASSERT( cache->execute( policy, "SELECT $1", 1 ).as< int >() == 1 );
+      TEST_ASSERT( executed == 2 );
+      TEST_ASSERT( cache->metrics().expired == 1 );
+   }
+
+   void tags()
+   {
+      const tao::pq::internal::test_server server( tao::pq::internal::test_server_options(), handler );
+      const auto pool = tao::pq::connection_pool::create( server.connection_info() );
+      const auto cache = tao::pq::result_cache::create( pool );
+
+      const tao::pq::cache_policy users{ std::chrono::milliseconds( 0 ), { "users" } };
+      const tao::pq::cache_policy both{ std::chrono::milliseconds( 0 ), { "users", "groups" } };
+      const tao::pq::cache_policy groups{ std::chrono::milliseconds( 0 ), { "groups" } };
+
+      executed = 0;
+      (void)cache->execute( users, "SELECT $1", "u" );
+      (void)cache->execute( both, "SELECT $1", "ug" );
+      (void)cache->execute( groups, "SELECT $1", "g" );
+      TEST_ASSERT( cache->metrics().entries == 3 );
+
+      // locally
+      cache->invalidate( "users" );
+      TEST_ASSERT( cache->metrics().entries == 1 );
+      TEST_ASSERT( cache->metrics().invalidated == 2 );
+      (void)cache->execute( groups, "SELECT $1", "g" );
+      TEST_ASSERT( executed == 3 );
+      cache->invalidate( "unknown" );
+      TEST_ASSERT( cache->metrics().entries == 1 );
+
+      // by a notification, e.g. sent by another process
+      (void)cache->execute( both, "SELECT $1", "ug" );
+      TEST_ASSERT( cache->metrics().entries == 2 );
+      pool->execute( "NOTIFY taopq_result_cache, 'groups'" );
+      TEST_ASSERT( eventually( [ & ] { return cache->metrics().entries == 0; } ) );
+      TEST_ASSERT( cache->metrics().notifications == 1 );
+
+      // an empty payload invalidates everything
+      (void)cache->execute( "SELECT $1", 1 );
+      (void)cache->execute( users, "SELECT $1", "u" );
+      TEST_ASSERT( cache->metrics().entries == 2 );
+      cache->notify();
+      TEST_ASSERT( eventually( [ & ] { return cache->metrics().entries == 0; } ) );
+
+      // reaches all caches listening on the channel
+      const auto other = tao::pq::result_cache::create( pool );
+      (void)other->execute( users, "SELECT $1", "u" );
+      cache->notify( "users" );
+      TEST_ASSERT( eventually( [ & ] { return other->metrics().entries == 0; } ) );
+   }
+
+   void eviction()
+   {
+      const tao::pq::internal::test_server server( tao::pq::internal::test_server_options(), handler );
+      const auto pool = tao::pq::connection_pool::create( server.connection_info() );
+      tao::pq::result_cache_options options;
+      options.max_bytes = 4096;
+      options.channel.clear();
+      const auto cache = tao::pq::result_cache::create( pool, options );
+      TEST_ASSERT( !cache->listening() );
+
+      for( int i = 0; i < 100; ++i ) {
+         TEST_ASSERT( cache->execute( "SELECT $1", i ).as< int >() == i );
+      }
+      const auto m = cache->metrics();
+      TEST_ASSERT( m.bytes <= options.max_bytes );
+      TEST_ASSERT( m.evicted > 0 );
+      TEST_ASSERT( m.entries + m.evicted == 100 );
+
+      // the least recently used entries were evicted
+      executed = 0;
+      (void)cache->execute( "SELECT $1", 99 );
+      TEST_ASSERT( executed == 0 );
+      (void)cache->execute( "SELECT $1", 0 );
+      TEST_ASSERT( executed == 1 );
+
+      TEST_THROWS( cache->notify() );
+   }
+
+}  // namespace
+
+void run()
+{
+   basics();
+   expiration();
+   tags();
+   eviction();
+}
+
+#else
+
+void run()
+{
+}
+
+#endif
+
+auto main() -> int  // NOLINT(bugprone-exception-escape)
+{
+   try {
+      run();
+   }
+   catch( const std::exception& e ) {
+      std::cerr << "exception: " << e.what() << std::endl;
+      throw;
+   }
+   catch( ... ) {
+      std::cerr << "unknown exception" << std::endl;
+      throw;
+   }
+}
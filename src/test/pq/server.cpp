@@ -0,0 +1,241 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include "../macros.hpp"
+#include "../server.hpp"
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <tao/pq.hpp>
+#include <tao/pq/connection_pool.hpp>
+#include <tao/pq/table_writer.hpp>
+
+#if !defined( _WIN32 )
+
+namespace
+{
+   using tao::pq::internal::canned_result;
+
+   auto handler( const std::string& statement, const std::vector< std::optional< std::string > >& parameters ) -> canned_result
+   {
+      if( statement == "SELECT n FROM numbers" ) {
+         canned_result nrv;
+         nrv.columns = { "n" };
+         nrv.rows = { { "1" }, { "2" }, { std::nullopt } };
+         return nrv;
+      }
+      if( statement == "FAIL" ) {
+         canned_result nrv;
+         nrv.error = "division by zero";
+         nrv.sqlstate = "22012";
+         return nrv;
+      }
+      if( statement == "LARGE" ) {
+         canned_result nrv;
+         nrv.columns = { "data" };
+         nrv.rows = { { std::string( 2000, 'x' ) } };
+         return nrv;
+      }
+      return tao::pq::internal::default_canned_result( statement, parameters );
+   }
+
+   void basics()
+   {
+      const tao::pq::internal::test_server server;
+      const auto connection = tao::pq::connection::create( server.connection_info() );
+      TEST_ASSERT( server.connections() == 1 );
+
+      TEST_ASSERT( connection->execute( "SELECT 42" ).as< int >() == 42 );
+      TEST_ASSERT( connection->execute( "SELECT 'a', 'b'" ).pair< std::string, std::string >() == std::pair< std::string, std::string >( "a", "b" ) );
+      TEST_ASSERT( connection->execute( "SELECT $1, $2", 1, "foo" ).tuple< int, std::string >() == std::tuple< int, std::string >( 1, "foo" ) );
+      TEST_ASSERT( !connection->execute( "SELECT $1", tao::pq::null ).as< std::optional< int > >() );
+      TEST_ASSERT( connection->execute< tao::pq::parameter_binary_traits >( "SELECT $1", "binary" ).as< std::string >() == "binary" );
+      TEST_ASSERT( connection->execute( "INSERT INTO t VALUES ( $1 )", 1 ).rows_affected() == 1 );
+      TEST_THROWS( connection->execute( "" ) );
+
+      connection->prepare( "p", "SELECT $1" );
+      TEST_ASSERT( connection->execute( "p", 7 ).as< int >() == 7 );
+      connection->deallocate( "p" );
+
+      {
+         const auto tr = connection->transaction();
+         TEST_ASSERT( PQtransactionStatus( connection->underlying_raw_ptr() ) == PQTRANS_INTRANS );
+         const auto sub = tr->subtransaction();
+         TEST_ASSERT( sub->execute( "SELECT 1" ).as< int >() == 1 );
+         sub->rollback();
+         tr->commit();
+         TEST_ASSERT( PQtransactionStatus( connection->underlying_raw_ptr() ) == PQTRANS_IDLE );
+      }
+
+      {
+         tao::pq::table_writer tw( connection->direct(), "COPY t ( a ) FROM STDIN" );
+         tw.insert( "1\n2\n" );
+         tw.insert( "3\n" );
+         TEST_ASSERT( tw.finish() == 3 );
+         TEST_ASSERT( server.copied_rows() == 3 );
+      }
+      TEST_ASSERT( connection->execute( "SELECT 1" ).as< int >() == 1 );
+      TEST_ASSERT( server.statements() > 10 );
+   }
+
+   void canned_results()
+   {
+      const tao::pq::internal::test_server server( tao::pq::internal::test_server_options(), handler );
+      const auto connection = tao::pq::connection::create( server.connection_info() );
+
+      const auto result = connection->execute( "SELECT n FROM numbers" );
+      TEST_ASSERT( result.name( 0 ) == "n" );
+      TEST_ASSERT( result.vector< std::optional< int > >() == std::vector< std::optional< int > >{ 1, 2, std::nullopt } );
+
+      TEST_THROWS( connection->execute( "FAIL" ) );
+      TEST_ASSERT( connection->execute( "SELECT 1" ).as< int >() == 1 );
+
+      {
+         const auto tr = connection->transaction();
+         TEST_THROWS( tr->execute( "FAIL" ) );
+         TEST_ASSERT( PQtransactionStatus( connection->underlying_raw_ptr() ) == PQTRANS_INERROR );
+         TEST_THROWS( tr->execute( "SELECT 1" ) );
+         tr->rollback();
+      }
+      TEST_ASSERT( PQtransactionStatus( connection->underlying_raw_ptr() ) == PQTRANS_IDLE );
+   }
+
+   struct counting_observer final
+      : tao::pq::observer
+   {
+      std::size_t statements = 0;
+
+      void on_statement( const tao::pq::statement_event& /*unused*/ ) noexcept override
+      {
+         ++statements;
+      }
+   };
+
+   // a COPY which is not finished must not leave the connection busy
+   void unfinished_copy()
+   {
+      const tao::pq::internal::test_server server;
+      const auto observer = std::make_shared< counting_observer >();
+      for( const bool observed : { false, true } ) {
+         const auto connection = tao::pq::connection::create( server.connection_info() );
+         if( observed ) {
+            connection->set_observer( observer );
+         }
+         {
+            tao::pq::table_writer tw( connection->direct(), "COPY t ( a ) FROM STDIN" );
+            tw.insert( "1\n" );
+         }
+         TEST_ASSERT( connection->execute( "SELECT 1" ).as< int >() == 1 );
+
+         try {
+            (void)connection->execute( "COPY t ( a ) FROM STDIN" );
+         }
+         catch( const std::exception& ) {
+         }
+         TEST_ASSERT( connection->execute( "SELECT 2" ).as< int >() == 2 );
+
+         {
+            tao::pq::table_writer tw( connection->direct(), "COPY t ( a ) FROM STDIN" );
+            tw.insert( "1\n" );
+            TEST_ASSERT( tw.finish() == 1 );
+         }
+         TEST_ASSERT( connection->execute( "SELECT 3" ).as< int >() == 3 );
+      }
+      TEST_ASSERT( observer->statements >= 4 );
+   }
+
+   // with and without an observer, a statement is one round-trip, a table writer two
+   void round_trips()
+   {
+      const tao::pq::internal::test_server server;
+      for( const bool observed : { false, true } ) {
+         const auto connection = tao::pq::connection::create( server.connection_info() );
+         if( observed ) {
+            connection->set_observer( std::make_shared< counting_observer >() );
+         }
+         const auto before = connection->wire_counters();
+         TEST_ASSERT( connection->execute( "SELECT 1" ).as< int >() == 1 );
+         const auto one = connection->wire_counters() - before;
+         TEST_ASSERT( one.round_trips == 1 );
+         TEST_ASSERT( one.results == 1 );
+         TEST_ASSERT( one.estimated_bytes_sent == 54 );
+         {
+            tao::pq::table_writer tw( connection->direct(), "COPY t ( a ) FROM STDIN" );
+            tw.insert( "1\n" );
+            TEST_ASSERT( tw.finish() == 1 );
+         }
+         TEST_ASSERT( ( connection->wire_counters() - before - one ).round_trips == 2 );
+      }
+   }
+
+   void network()
+   {
+      using std::chrono::milliseconds;
+      using std::chrono::steady_clock;
+      {
+         tao::pq::internal::test_server_options options;
+         options.latency = milliseconds( 20 );
+         const tao::pq::internal::test_server server( options );
+         const auto connection = tao::pq::connection::create( server.connection_info() );
+         const auto start = steady_clock::now();
+         TEST_ASSERT( connection->execute( "SELECT 1" ).as< int >() == 1 );
+         TEST_ASSERT( steady_clock::now() - start >= milliseconds( 20 ) );
+      }
+      {
+         tao::pq::internal::test_server_options options;
+         options.bandwidth = 100000;
+         const tao::pq::internal::test_server server( options, handler );
+         const auto connection = tao::pq::connection::create( server.connection_info() );
+         const auto start = steady_clock::now();
+         TEST_ASSERT( connection->execute( "LARGE" ).as< std::string >().size() == 2000 );
+         TEST_ASSERT( steady_clock::now() - start >= milliseconds( 20 ) );
+      }
+      {
+         const tao::pq::internal::test_server server;
+         const auto pool = tao::pq::connection_pool::create( server.connection_info() );
+         const auto c1 = pool->connection();
+         const auto c2 = pool->connection();
+         TEST_ASSERT( c1->execute( "SELECT 1" ).as< int >() == 1 );
+         TEST_ASSERT( c2->execute( "SELECT 2" ).as< int >() == 2 );
+         TEST_ASSERT( server.connections() == 2 );
+      }
+   }
+
+}  // namespace
+
+void run()
+{
+   basics();
+   canned_results();
+   unfinished_copy();
+   round_trips();
+   network();
+}
+
+#else
+
+void run()
+{
+}
+
+#endif
+
+auto main() -> int  // NOLINT(bugprone-exception-escape)
+{
+   try {
+      run();
+   }
+   catch( const std::exception& e ) {
+      std::cerr << "exception: " << e.what() << std::endl;
+      throw;
+   }
+   catch( ... ) {
+      std::cerr << "unknown exception" << std::endl;
+      throw;
+   }
+}
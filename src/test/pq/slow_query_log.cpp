@@ -0,0 +1,165 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include "../macros.hpp"
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <tao/pq/slow_query_log.hpp>
+
+namespace
+{
+   const char* const values[] = { "42", "it's", nullptr, "\x01\x02\xff", "\xc3\xa4\xc3\xa4\xc3\xa4" };
+   const int lengths[] = { 2, 4, 0, 3, 6 };
+   const int formats[] = { 0, 0, 0, 1, 0 };
+
+   auto event( const std::chrono::milliseconds elapsed, const int parameters = 0 ) -> tao::pq::statement_event
+   {
+      tao::pq::statement_event e;
+      e.statement = "SELECT $1, $2, $3, $4, $5";
+      e.parameters = parameters;
+      if( parameters != 0 ) {
+         e.values = values;
+         e.lengths = lengths;
+         e.formats = formats;
+      }
+      e.rows = 1;
+      e.started = tao::pq::statement_event::clock::now();
+      e.encoded = e.started + std::chrono::milliseconds( 1 );
+      e.sent = e.encoded;
+      e.responded = e.started + elapsed - std::chrono::milliseconds( 1 );
+      e.received = e.responded;
+      e.decoded = e.started + elapsed;
+      return e;
+   }
+
+   struct collector
+   {
+      std::mutex mutex;
+      std::vector< tao::pq::slow_query > entries;
+
+      auto sink()
+      {
+         return [ this ]( const tao::pq::slow_query& q ) {
+            const std::lock_guard lock( mutex );
+            entries.push_back( q );
+         };
+      }
+
+      auto size() -> std::size_t
+      {
+         const std::lock_guard lock( mutex );
+         return entries.size();
+      }
+   };
+
+}  // namespace
+
+void run()
+{
+   {
+      tao::pq::internal::ring_buffer< int > rb( 3 );
+      TEST_ASSERT( rb.capacity() == 4 );
+      for( int i = 0; i < 4; ++i ) {
+         TEST_ASSERT( rb.try_push( int( i ) ) );
+      }
+      TEST_ASSERT( !rb.try_push( 4 ) );
+      int v = -1;
+      TEST_ASSERT( rb.try_pop( v ) && ( v == 0 ) );
+      TEST_ASSERT( rb.try_push( 4 ) );
+      for( int i = 1; i < 5; ++i ) {
+         TEST_ASSERT( rb.try_pop( v ) && ( v == i ) );
+      }
+      TEST_ASSERT( !rb.try_pop( v ) );
+   }
+
+   collector c;
+   {
+      tao::pq::slow_query_options options;
+      options.threshold = std::chrono::milliseconds( 10 );
+      options.max_parameters = 4;
+      options.max_parameter_length = 4;
+      tao::pq::slow_query_log log( c.sink(), options );
+
+      // below the threshold
+      log.on_statement( event( std::chrono::milliseconds( 5 ), 5 ) );
+      log.flush();
+      TEST_ASSERT( c.size() == 0 );
+
+      log.on_statement( event( std::chrono::milliseconds( 20 ), 5 ) );
+      log.flush();
+      TEST_ASSERT( c.size() == 1 );
+
+      const auto& q = c.entries[ 0 ];
+      TEST_ASSERT( q.statement == "SELECT $1, $2, $3, $4, $5" );
+      TEST_ASSERT( q.total == std::chrono::milliseconds( 20 ) );
+      TEST_ASSERT( q.encoding == std::chrono::milliseconds( 1 ) );
+      TEST_ASSERT( q.waiting == std::chrono::milliseconds( 18 ) );
+      TEST_ASSERT( q.rows == 1 );
+      TEST_ASSERT( q.parameters.size() == 4 );
+      TEST_ASSERT( q.parameters[ 0 ] == "'42'" );
+      TEST_ASSERT( q.parameters[ 1 ] == "'it''s'" );
+      TEST_ASSERT( q.parameters[ 2 ] == "NULL" );
+      TEST_ASSERT( q.parameters[ 3 ] == "'\\x0102...'" );
+      TEST_ASSERT( q.omitted_parameters == 1 );
+      TEST_ASSERT( q.to_text().find( "$2='it''s' $3=NULL" ) != std::string::npos );
+      TEST_ASSERT( q.to_json().find( "\"total_ns\":20000000," ) != std::string::npos );
+
+      // text values are not truncated within a UTF-8 sequence
+      options.max_parameters = 5;
+      options.max_parameter_length = 5;
+      tao::pq::slow_query_log utf8( c.sink(), options );
+      utf8.on_statement( event( std::chrono::milliseconds( 20 ), 5 ) );
+      utf8.flush();
+      TEST_ASSERT( c.size() == 2 );
+      TEST_ASSERT( c.entries[ 1 ].parameters[ 4 ] == "'\xc3\xa4\xc3\xa4...'" );
+
+      // drained by the background thread
+      std::vector< std::thread > threads;
+      for( int i = 0; i < 4; ++i ) {
+         threads.emplace_back( [ & ] {
+            for( int j = 0; j < 100; ++j ) {
+               log.on_statement( event( std::chrono::milliseconds( 50 ) ) );
+            }
+         } );
+      }
+      for( auto& t : threads ) {
+         t.join();
+      }
+   }
+   TEST_ASSERT( c.size() == 402 );
+
+   // entries are dropped when the buffer is full
+   collector d;
+   {
+      tao::pq::slow_query_options options;
+      options.threshold = std::chrono::milliseconds( 10 );
+      options.buffer_size = 8;
+      options.flush_interval = std::chrono::hours( 1 );
+      tao::pq::slow_query_log log( d.sink(), options );
+      for( int i = 0; i < 10; ++i ) {
+         log.on_statement( event( std::chrono::milliseconds( 20 ) ) );
+      }
+      TEST_ASSERT( log.dropped() == 2 );
+   }
+   TEST_ASSERT( d.size() == 8 );
+}
+
+auto main() -> int  // NOLINT(bugprone-exception-escape)
+{
+   try {
+      run();
+   }
+   catch( const std::exception& e ) {
+      std::cerr << "exception: " << e.what() << std::endl;
+      throw;
+   }
+   catch( ... ) {
+      std::cerr << "unknown exception" << std::endl;
+      throw;
+   }
+}
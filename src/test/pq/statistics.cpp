@@ -0,0 +1,104 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include "../macros.hpp"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <tao/pq/statistics.hpp>
+
+namespace
+{
+   auto event( const char* statement, const std::chrono::microseconds elapsed, const bool failed = false ) -> tao::pq::statement_event
+   {
+      tao::pq::statement_event e;
+      e.statement = statement;
+      e.rows = 2;
+      e.bytes_sent = 100;
+      e.error = failed ? "failed" : nullptr;
+      e.started = tao::pq::statement_event::clock::now();
+      e.encoded = e.sent = e.responded = e.received = e.started;
+      e.decoded = e.started + elapsed;
+      return e;
+   }
+
+}  // namespace
+
+void run()
+{
+   tao::pq::statistics stats;
+   TEST_ASSERT( stats.snapshot().empty() );
+   TEST_ASSERT( stats.to_json() == "[\n]\n" );
+
+   // statements with different literals share one entry
+   stats.on_statement( event( "SELECT * FROM t WHERE id = 1", std::chrono::microseconds( 100 ) ) );
+   stats.on_statement( event( "SELECT * FROM t WHERE id = 2", std::chrono::microseconds( 200 ) ) );
+   stats.on_statement( event( "SELECT * FROM t WHERE id = 2", std::chrono::microseconds( 300 ), true ) );
+
+   // recorded from other threads, merged when reading
+   std::vector< std::thread > threads;
+   for( int i = 0; i < 4; ++i ) {
+      threads.emplace_back( [ & ] {
+         for( int j = 0; j < 100; ++j ) {
+            stats.on_statement( event( "UPDATE t SET a = 'x'", std::chrono::microseconds( 1000 ) ) );
+         }
+      } );
+   }
+   for( auto& t : threads ) {
+      t.join();
+   }
+
+   const auto s = stats.snapshot();
+   TEST_ASSERT( s.size() == 2 );
+
+   TEST_ASSERT( s[ 0 ].statement == "UPDATE t SET a = ?" );
+   TEST_ASSERT( s[ 0 ].calls == 400 );
+   TEST_ASSERT( s[ 0 ].errors == 0 );
+   TEST_ASSERT( s[ 0 ].rows == 800 );
+   TEST_ASSERT( s[ 0 ].bytes_sent == 40000 );
+   TEST_ASSERT( s[ 0 ].total == std::chrono::milliseconds( 400 ) );
+   TEST_ASSERT( s[ 0 ].max == std::chrono::milliseconds( 1 ) );
+   TEST_ASSERT( s[ 0 ].p50 <= s[ 0 ].max );
+
+   TEST_ASSERT( s[ 1 ].statement == "SELECT * FROM t WHERE id = ?" );
+   TEST_ASSERT( s[ 1 ].calls == 3 );
+   TEST_ASSERT( s[ 1 ].errors == 1 );
+   TEST_ASSERT( s[ 1 ].mean == std::chrono::microseconds( 200 ) );
+   TEST_ASSERT( s[ 1 ].p50 >= std::chrono::microseconds( 190 ) );
+   TEST_ASSERT( s[ 1 ].p50 <= std::chrono::microseconds( 210 ) );
+   TEST_ASSERT( s[ 1 ].p999 == std::chrono::microseconds( 300 ) );
+
+   const auto text = stats.to_text();
+   TEST_ASSERT( text.find( "UPDATE t SET a = ?\n" ) != std::string::npos );
+   TEST_ASSERT( text.find( "p999" ) != std::string::npos );
+
+   const auto json = stats.to_json();
+   TEST_ASSERT( json.find( "{\"statement\":\"UPDATE t SET a = ?\",\"calls\":400,\"errors\":0,\"rows\":800," ) != std::string::npos );
+
+   // the number of distinct statements is limited
+   tao::pq::statistics limited( 1 );
+   limited.on_statement( event( "SELECT 1", std::chrono::microseconds( 1 ) ) );
+   limited.on_statement( event( "SELECT a FROM b", std::chrono::microseconds( 1 ) ) );
+   limited.on_statement( event( "SELECT c FROM d", std::chrono::microseconds( 1 ) ) );
+   const auto l = limited.snapshot();
+   TEST_ASSERT( l.size() == 2 );
+   TEST_ASSERT( ( l[ 0 ].statement == "?" ) || ( l[ 1 ].statement == "?" ) );
+}
+
+auto main() -> int
+{
+   try {
+      run();
+   }
+   catch( const std::exception& e ) {
+      std::cerr << "exception: " << e.what() << std::endl;
+      throw;
+   }
+   catch( ... ) {
+      std::cerr << "unknown exception" << std::endl;
+      throw;
+   }
+}
@@ -0,0 +1,168 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include "../macros.hpp"
+#include "../server.hpp"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <tao/pq.hpp>
+#include <tao/pq/tracing.hpp>
+
+namespace
+{
+   auto statement( const char* text, const char* error = nullptr ) -> tao::pq::statement_event
+   {
+      tao::pq::statement_event e;
+      e.statement = text;
+      e.rows = 3;
+      e.error = error;
+      e.started = tao::pq::statement_event::clock::now();
+      e.encoded = e.sent = e.responded = e.received = e.decoded = e.started;
+      return e;
+   }
+
+   auto transaction( const tao::pq::transaction_event::kind what, const bool nested = false ) -> tao::pq::transaction_event
+   {
+      tao::pq::transaction_event e;
+      e.what = what;
+      e.nested = nested;
+      return e;
+   }
+
+#if !defined( _WIN32 )
+   std::vector< std::string > statements;
+
+   auto handler( const std::string& statement, const std::vector< std::optional< std::string > >& parameters ) -> tao::pq::internal::canned_result
+   {
+      statements.push_back( statement );
+      return tao::pq::internal::default_canned_result( statement, parameters );
+   }
+
+   // the traceparent sent to the server identifies the exported statement span
+   void comment_propagation()
+   {
+      const tao::pq::internal::test_server server( tao::pq::internal::test_server_options(), handler );
+      const auto connection = tao::pq::connection::create( server.connection_info() );
+      const auto sink = std::make_shared< tao::pq::memory_span_sink >();
+      connection->set_observer( std::make_shared< tao::pq::tracer >( sink, tao::pq::tracer::propagation::comment ) );
+
+      const auto check = [ & ]( const std::string& parent_span_id ) {
+         statements.clear();
+         sink->clear();
+         (void)connection->execute( "SELECT 1" );
+         const auto spans = sink->spans();
+         TEST_ASSERT( spans.size() == 1 );
+         TEST_ASSERT( spans[ 0 ].parent_span_id == parent_span_id );
+         TEST_ASSERT( statements.size() == 1 );
+         TEST_ASSERT( statements[ 0 ] == "/* traceparent='00-" + spans[ 0 ].trace_id + '-' + spans[ 0 ].span_id + "-01' */ SELECT 1" );
+      };
+
+      // a new trace for a statement outside of a transaction and scope
+      check( "" );
+
+      const auto ctx = tao::pq::trace_context::generate();
+      const tao::pq::trace_scope scope( ctx );
+      check( ctx.span_id );
+   }
+#endif
+
+}  // namespace
+
+void run()
+{
+   using kind = tao::pq::transaction_event::kind;
+
+   const auto ctx = tao::pq::trace_context::generate();
+   TEST_ASSERT( ctx.trace_id.size() == 32 );
+   TEST_ASSERT( ctx.span_id.size() == 16 );
+   TEST_ASSERT( ctx.traceparent() == "00-" + ctx.trace_id + '-' + ctx.span_id + "-01" );
+
+   const auto parsed = tao::pq::trace_context::from_traceparent( "00-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-01" );
+   TEST_ASSERT( parsed.trace_id == "0af7651916cd43dd8448eb211c80319c" );
+   TEST_ASSERT( parsed.span_id == "b7ad6b7169203331" );
+   TEST_THROWS( tao::pq::trace_context::from_traceparent( "00-0af7651916cd43dd8448eb211c80319c" ) );
+   TEST_THROWS( tao::pq::trace_context::from_traceparent( "00-0af7651916cd43dd8448eb211c80319x-b7ad6b7169203331-01" ) );
+
+   TEST_ASSERT( tao::pq::trace_scope::current() == nullptr );
+   {
+      const tao::pq::trace_scope outer( parsed );
+      TEST_ASSERT( tao::pq::trace_scope::current()->span_id == "b7ad6b7169203331" );
+      {
+         const tao::pq::trace_scope inner( ctx );
+         TEST_ASSERT( tao::pq::trace_scope::current()->span_id == ctx.span_id );
+      }
+      TEST_ASSERT( tao::pq::trace_scope::current()->span_id == "b7ad6b7169203331" );
+   }
+   TEST_ASSERT( tao::pq::trace_scope::current() == nullptr );
+
+   const auto sink = std::make_shared< tao::pq::memory_span_sink >();
+   {
+      tao::pq::tracer t( sink );
+
+      // a statement outside of a transaction starts a new trace
+      t.on_statement( statement( "SELECT 42" ) );
+      auto spans = sink->spans();
+      TEST_ASSERT( spans.size() == 1 );
+      TEST_ASSERT( spans[ 0 ].name == "statement" );
+      TEST_ASSERT( spans[ 0 ].statement == "SELECT ?" );
+      TEST_ASSERT( spans[ 0 ].parent_span_id.empty() );
+      TEST_ASSERT( spans[ 0 ].trace_id.size() == 32 );
+      TEST_ASSERT( spans[ 0 ].rows == 3 );
+      TEST_ASSERT( spans[ 0 ].error.empty() );
+      sink->clear();
+
+      // transaction -> savepoint -> statement, within the caller's trace
+      {
+         const tao::pq::trace_scope scope( parsed );
+         t.on_transaction( transaction( kind::begin ) );
+         t.on_transaction( transaction( kind::begin, true ) );
+         t.on_statement( statement( "UPDATE t SET a = 'x'", "failed" ) );
+         t.on_transaction( transaction( kind::rollback ) );
+         t.on_transaction( transaction( kind::commit ) );
+      }
+      spans = sink->spans();
+      TEST_ASSERT( spans.size() == 3 );
+      TEST_ASSERT( spans[ 0 ].name == "statement" );
+      TEST_ASSERT( spans[ 0 ].error == "failed" );
+      TEST_ASSERT( spans[ 1 ].name == "savepoint" );
+      TEST_ASSERT( spans[ 1 ].error == "rollback" );
+      TEST_ASSERT( spans[ 2 ].name == "transaction" );
+      TEST_ASSERT( spans[ 2 ].error.empty() );
+      TEST_ASSERT( spans[ 0 ].parent_span_id == spans[ 1 ].span_id );
+      TEST_ASSERT( spans[ 1 ].parent_span_id == spans[ 2 ].span_id );
+      TEST_ASSERT( spans[ 2 ].parent_span_id == "b7ad6b7169203331" );
+      for( const auto& s : spans ) {
+         TEST_ASSERT( s.trace_id == "0af7651916cd43dd8448eb211c80319c" );
+         TEST_ASSERT( s.start <= s.end );
+      }
+      TEST_ASSERT( spans[ 0 ].to_json().find( "\"statement\":\"UPDATE t SET a = ?\"" ) != std::string::npos );
+      sink->clear();
+
+      // unmatched ends are ignored
+      t.on_transaction( transaction( kind::commit ) );
+      TEST_ASSERT( sink->spans().empty() );
+   }
+
+#if !defined( _WIN32 )
+   comment_propagation();
+#endif
+}
+
+auto main() -> int  // NOLINT(bugprone-exception-escape)
+{
+   try {
+      run();
+   }
+   catch( const std::exception& e ) {
+      std::cerr << "exception: " << e.what() << std::endl;
+      throw;
+   }
+   catch( ... ) {
+      std::cerr << "unknown exception" << std::endl;
+      throw;
+   }
+}
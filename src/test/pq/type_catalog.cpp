@@ -0,0 +1,141 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include "../macros.hpp"
+#include "../server.hpp"
+
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <tao/pq.hpp>
+#include <tao/pq/connection_pool.hpp>
+#include <tao/pq/type_catalog.hpp>
+
+#if !defined( _WIN32 )
+
+namespace
+{
+   using tao::pq::internal::canned_result;
+
+   std::mutex mutex;
+   std::size_t loads = 0;
+   std::vector< std::optional< std::string > > last;
+
+   auto handler( const std::string& statement, const std::vector< std::optional< std::string > >& parameters ) -> canned_result
+   {
+      const std::lock_guard lock( mutex );
+      if( statement.find( "pg_type" ) != std::string::npos ) {
+         ++loads;
+         TEST_ASSERT( parameters.at( 0 ) == "{\"mood\",\"hstore\",\"missing\"}" );
+         canned_result nrv;
+         nrv.columns = { "n", "oid", "typarray" };
+         nrv.rows = { { "mood", "16390", "16389" }, { "hstore", "16400", "16405" }, { "missing", std::nullopt, std::nullopt } };
+         return nrv;
+      }
+      last = parameters;
+      return tao::pq::internal::default_canned_result( statement, parameters );
+   }
+
+   void catalog()
+   {
+      const tao::pq::internal::test_server server( tao::pq::internal::test_server_options(), handler );
+      const auto conn = tao::pq::connection::create( server.connection_info() );
+      TEST_ASSERT( conn->types().empty() );
+
+      conn->load_types( { "mood", "hstore", "missing" } );
+      const auto& types = conn->types();
+      TEST_ASSERT( types.size() == 2 );
+      TEST_ASSERT( types.contains( "mood" ) );
+      TEST_ASSERT( !types.contains( "missing" ) );
+      TEST_ASSERT( types.oid( "mood" ) == 16390 );
+      TEST_ASSERT( types.array_oid( "hstore" ) == 16405 );
+      TEST_THROWS( (void)types.oid( "missing" ) );
+
+      // the traits resolve their type from the catalog
+      const tao::pq::parameter_binary_traits< tao::pq::typed_text > label( types, tao::pq::typed_text{ "mood", "happy" } );
+      TEST_ASSERT( label.type< 0 >() == 16390 );
+      TEST_ASSERT( label.format< 0 >() == 1 );
+      TEST_ASSERT( std::string( label.value< 0 >(), label.length< 0 >() ) == "happy" );
+
+      const tao::pq::parameter_binary_traits< std::optional< tao::pq::typed_text > > none( types, std::optional< tao::pq::typed_text >() );
+      TEST_ASSERT( none.type< 0 >() == 0 );
+      TEST_ASSERT( none.value< 0 >() == nullptr );
+      const tao::pq::parameter_binary_traits< std::optional< int > > number( std::optional< int >{} );
+      TEST_ASSERT( number.type< 0 >() == 23 );
+      TEST_ASSERT( number.format< 0 >() == 1 );
+
+      TEST_THROWS( tao::pq::parameter_text_traits< tao::pq::typed_text >( types, tao::pq::typed_text{ "missing", "x" } ) );
+
+      conn->execute< tao::pq::parameter_binary_traits >( "SELECT $1, $2, $3", tao::pq::typed_text{ "mood", "sad" }, std::optional< tao::pq::typed_text >(), 42 );
+      TEST_ASSERT( last.size() == 3 );
+      TEST_ASSERT( last[ 0 ] == "sad" );
+      TEST_ASSERT( !last[ 1 ] );
+
+      tao::pq::hstore h;
+      h.values[ "a" ] = "1";
+      h.values[ "b\"" ] = std::nullopt;
+      conn->execute( "SELECT $1", h );
+      TEST_ASSERT( last.at( 0 ) == "\"a\"=>\"1\", \"b\\\"\"=>NULL" );
+      conn->execute< tao::pq::parameter_binary_traits >( "SELECT $1", h );
+      TEST_ASSERT( last.at( 0 ) == std::string( "\0\0\0\2\0\0\0\1a\0\0\0\0011\0\0\0\2b\"\377\377\377\377", 24 ) );
+   }
+
+   void pool()
+   {
+      loads = 0;
+      const tao::pq::internal::test_server server( tao::pq::internal::test_server_options(), handler );
+      const auto pool = tao::pq::connection_pool::create( server.connection_info() );
+      TEST_ASSERT( !pool->types() );
+
+      // the catalog is installed when a connection is handed out
+      const auto before = pool->connection();
+      pool->load_types( { "mood", "hstore", "missing" } );
+      TEST_ASSERT( loads == 1 );
+      TEST_ASSERT( pool->types()->size() == 2 );
+
+      const auto a = pool->connection();
+      const auto b = pool->connection();
+      TEST_ASSERT( a->types().oid( "hstore" ) == 16400 );
+      TEST_ASSERT( b->types().oid( "mood" ) == 16390 );
+      TEST_ASSERT( before->types().empty() );
+
+      // no catalog lookups per statement
+      pool->execute( "SELECT $1", tao::pq::typed_text{ "mood", "ok" } );
+      (void)pool->execute_coalesced( "SELECT $1", tao::pq::typed_text{ "mood", "ok" } );
+      a->execute< tao::pq::parameter_binary_traits >( "SELECT $1", tao::pq::typed_text{ "mood", "ok" } );
+      TEST_ASSERT( loads == 1 );
+      TEST_ASSERT( last.at( 0 ) == "ok" );
+   }
+
+}  // namespace
+
+void run()
+{
+   catalog();
+   pool();
+}
+
+#else
+
+void run()
+{
+}
+
+#endif
+
+auto main() -> int  // NOLINT(bugprone-exception-escape)
+{
+   try {
+      run();
+   }
+   catch( const std::exception& e ) {
+      std::cerr << "exception: " << e.what() << std::endl;
+      throw;
+   }
+   catch( ... ) {
+      std::cerr << "unknown exception" << std::endl;
+      throw;
+   }
+}
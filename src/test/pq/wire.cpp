@@ -0,0 +1,73 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include "../macros.hpp"
+
+#include <memory>
+
+#include <tao/pq/internal/wire.hpp>
+
+namespace
+{
+   auto empty( const ExecStatusType status ) -> std::unique_ptr< PGresult, decltype( &PQclear ) >
+   {
+      return { PQmakeEmptyPGresult( nullptr, status ), &PQclear };
+   }
+
+}  // namespace
+
+void run()
+{
+   // Parse (18), Bind (15), Describe (7), Execute (10) and Sync (5)
+   TEST_ASSERT( tao::pq::internal::statement_wire_size( "SELECT 42", false, 0, nullptr, nullptr, nullptr ) == 55 );
+
+   // prepared statements skip the Parse message
+   TEST_ASSERT( tao::pq::internal::statement_wire_size( "name", true, 0, nullptr, nullptr, nullptr ) == 41 );
+
+   // text parameters are sent without their terminating zero, binary ones with their length
+   const char* const values[] = { "1234", nullptr, "\x01\x02" };
+   const int lengths[] = { 0, 0, 2 };
+   const int formats[] = { 0, 0, 1 };
+   TEST_ASSERT( tao::pq::internal::statement_wire_size( "SELECT $1, $2, $3", false, 3, values, lengths, formats ) == 99 );
+
+   TEST_ASSERT( tao::pq::internal::result_wire_size( nullptr ) == 0 );
+   TEST_ASSERT( tao::pq::internal::result_wire_size( empty( PGRES_EMPTY_QUERY ).get() ) == 5 );
+   TEST_ASSERT( tao::pq::internal::result_wire_size( empty( PGRES_COMMAND_OK ).get() ) == 0 );
+   TEST_ASSERT( tao::pq::internal::result_wire_size( empty( PGRES_COPY_IN ).get() ) == 8 );
+   TEST_ASSERT( tao::pq::internal::result_wire_size( empty( PGRES_TUPLES_OK ).get() ) == 7 );
+
+   // sending does not count as a round-trip, waiting for the response does
+   tao::pq::internal::wire_recorder recorder;
+   recorder.exchanged( 55, 16 );
+   recorder.exchanged( 55, 16 );
+   TEST_ASSERT( recorder.snapshot().round_trips == 0 );
+   recorder.round_trip();
+   recorder.result( empty( PGRES_EMPTY_QUERY ).get() );
+   recorder.sent( 10 );
+   const auto c = recorder.snapshot();
+   TEST_ASSERT( c.round_trips == 1 );
+   TEST_ASSERT( c.estimated_bytes_sent == 120 );
+   TEST_ASSERT( c.estimated_bytes_received == 37 );
+   TEST_ASSERT( c.results == 1 );
+
+   const auto d = c + c - c;
+   TEST_ASSERT( d.round_trips == c.round_trips );
+   TEST_ASSERT( d.estimated_bytes_sent == c.estimated_bytes_sent );
+   TEST_ASSERT( d.estimated_bytes_received == c.estimated_bytes_received );
+   TEST_ASSERT( d.results == c.results );
+}
+
+auto main() -> int  // NOLINT(bugprone-exception-escape)
+{
+   try {
+      run();
+   }
+   catch( const std::exception& e ) {
+      std::cerr << "exception: " << e.what() << std::endl;
+      throw;
+   }
+   catch( ... ) {
+      std::cerr << "unknown exception" << std::endl;
+      throw;
+   }
+}
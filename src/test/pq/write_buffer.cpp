@@ -0,0 +1,157 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#include "../macros.hpp"
+#include "../server.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <optional>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <tao/pq.hpp>
+#include <tao/pq/connection_pool.hpp>
+#include <tao/pq/write_buffer.hpp>
+
+#if !defined( _WIN32 )
+
+namespace
+{
+   using tao::pq::internal::canned_result;
+
+   std::atomic< bool > failing( false );
+
+   auto handler( const std::string& statement, const std::vector< std::optional< std::string > >& parameters ) -> canned_result
+   {
+      if( failing && ( statement == "START TRANSACTION" ) ) {
+         canned_result nrv;
+         nrv.error = "cannot execute COPY in a read-only transaction";
+         nrv.sqlstate = "25006";
+         return nrv;
+      }
+      return tao::pq::internal::default_canned_result( statement, parameters );
+   }
+
+   using row = std::tuple< int, std::string, std::optional< std::string > >;
+
+   void basics()
+   {
+      const tao::pq::internal::test_server server( tao::pq::internal::test_server_options(), handler );
+      const auto pool = tao::pq::connection_pool::create( server.connection_info() );
+
+      tao::pq::write_buffer_options options;
+      options.flush_rows = 4;
+      options.flush_interval = std::chrono::seconds( 60 );
+      const auto buffer = tao::pq::write_buffer< row >::create( pool, "audit_log ( id, action, detail )", options );
+
+      std::vector< std::shared_future< void > > futures;
+      for( int i = 0; i < 10; ++i ) {
+         futures.push_back( buffer->append( row( i, "tab\tand\nnewline", ( i % 2 == 0 ) ? std::optional< std::string >( "x" ) : std::nullopt ) ) );
+      }
+      futures[ 7 ].get();
+      TEST_ASSERT( server.copied_rows() == 8 );
+      TEST_ASSERT( futures[ 8 ].wait_for( std::chrono::milliseconds( 50 ) ) == std::future_status::timeout );
+      buffer->flush().get();
+      futures[ 9 ].get();
+      TEST_ASSERT( server.copied_rows() == 10 );
+      TEST_ASSERT( buffer->rows() == 10 );
+      TEST_ASSERT( buffer->flushes() == 3 );
+      TEST_ASSERT( buffer->failures() == 0 );
+      TEST_ASSERT( buffer->buffered_bytes() == 0 );
+      buffer->flush().get();
+   }
+
+   void interval()
+   {
+      const tao::pq::internal::test_server server( tao::pq::internal::test_server_options(), handler );
+      const auto pool = tao::pq::connection_pool::create( server.connection_info() );
+
+      tao::pq::write_buffer_options options;
+      options.flush_interval = std::chrono::milliseconds( 20 );
+      {
+         const auto buffer = tao::pq::write_buffer< int >::create( pool, "metrics", options );
+         TEST_ASSERT( buffer->append( 1 ).wait_for( std::chrono::seconds( 10 ) ) == std::future_status::ready );
+         TEST_ASSERT( server.copied_rows() == 1 );
+         (void)buffer->append( 2 );
+         (void)buffer->append( 3 );
+      }
+      // the destructor flushes the remaining rows
+      TEST_ASSERT( server.copied_rows() == 3 );
+   }
+
+   void backpressure()
+   {
+      tao::pq::internal::test_server_options server_options;
+      server_options.latency = std::chrono::milliseconds( 20 );
+      const tao::pq::internal::test_server server( server_options, handler );
+      const auto pool = tao::pq::connection_pool::create( server.connection_info() );
+
+      tao::pq::write_buffer_options options;
+      options.flush_interval = std::chrono::milliseconds( 1 );
+      options.max_bytes = 1;
+      const auto buffer = tao::pq::write_buffer< int >::create( pool, "metrics", options );
+
+      const auto start = std::chrono::steady_clock::now();
+      (void)buffer->append( 1 );
+      (void)buffer->append( 2 );
+      buffer->append( 3 ).get();
+      TEST_ASSERT( std::chrono::steady_clock::now() - start >= std::chrono::milliseconds( 40 ) );
+      TEST_ASSERT( server.copied_rows() == 3 );
+      TEST_ASSERT( buffer->flushes() == 3 );
+   }
+
+   void failure()
+   {
+      const tao::pq::internal::test_server server( tao::pq::internal::test_server_options(), handler );
+      const auto pool = tao::pq::connection_pool::create( server.connection_info() );
+      const auto buffer = tao::pq::write_buffer< int >::create( pool, "metrics" );
+
+      failing = true;
+      const auto f = buffer->append( 1 );
+      (void)buffer->flush();
+      TEST_THROWS( f.get() );
+      TEST_ASSERT( buffer->failures() == 1 );
+
+      failing = false;
+      buffer->append( 2 );
+      buffer->flush().get();
+      TEST_ASSERT( buffer->flushes() == 1 );
+      TEST_ASSERT( server.copied_rows() == 1 );
+   }
+
+}  // namespace
+
+void run()
+{
+   basics();
+   interval();
+   backpressure();
+   failure();
+}
+
+#else
+
+void run()
+{
+}
+
+#endif
+
+auto main() -> int  // NOLINT(bugprone-exception-escape)
+{
+   try {
+      run();
+   }
+   catch( const std::exception& e ) {
+      std::cerr << "exception: " << e.what() << std::endl;
+      throw;
+   }
+   catch( ... ) {
+      std::cerr << "unknown exception" << std::endl;
+      throw;
+   }
+}
@@ -0,0 +1,947 @@
+// Copyright (c) 2020 Daniel Frey and Dr. Colin Hirsch
+// Please see LICENSE for license or visit https://github.com/taocpp/taopq/
+
+#ifndef SRC_TEST_SERVER_HPP  // NOLINT(llvm-header-guard)
+#define SRC_TEST_SERVER_HPP
+
+// This is an internal header used for unit-tests and benchmarks. It provides
+// a stand-in server on the loopback interface which speaks enough of the
+// PostgreSQL v3 protocol for libpq: startup without authentication, simple
+// queries, the extended query protocol, COPY FROM STDIN, LISTEN/NOTIFY and
+// logical replication streams. It answers with canned results, after an
+// injected latency. Only available on POSIX systems.
+
+#if !defined( _WIN32 )
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace tao::pq::internal
+{
+   // the answer to a statement, all columns are of type text
+   struct canned_result
+   {
+      std::vector< std::string > columns;  // no columns means no result set
+      std::vector< std::vector< std::optional< std::string > > > rows;
+      std::string command;  // the command tag, defaults to "SELECT <rows>" for result sets
+
+      std::string error;  // if set, the statement fails with this message
+      std::string sqlstate = "XX000";
+   };
+
+   // answers SELECT with a single row, made from the parameters if there are
+   // any, otherwise from the comma separated (and unquoted) select list, other
+   // statements with a command tag from their first word
+   [[nodiscard]] inline auto default_canned_result( const std::string& statement, const std::vector< std::optional< std::string > >& parameters ) -> canned_result
+   {
+      canned_result nrv;
+      std::string word;
+      for( const char c : statement ) {
+         if( std::isalpha( static_cast< unsigned char >( c ) ) != 0 ) {
+            word += static_cast< char >( std::toupper( static_cast< unsigned char >( c ) ) );
+         }
+         else if( !word.empty() ) {
+            break;
+         }
+      }
+      if( word == "SELECT" ) {
+         std::vector< std::optional< std::string > > row = parameters;
+         if( parameters.empty() ) {
+            std::string list = statement.substr( statement.find_first_not_of( " \t\n" ) + 6 );
+            std::size_t pos = 0;
+            while( pos <= list.size() ) {
+               const auto end = std::min( list.find( ',', pos ), list.size() );
+               auto value = list.substr( pos, end - pos );
+               value.erase( 0, value.find_first_not_of( " \t\n'" ) );
+               value.erase( value.find_last_not_of( " \t\n';" ) + 1 );
+               row.emplace_back( std::move( value ) );
+               pos = end + 1;
+            }
+         }
+         nrv.columns.assign( row.size(), "?column?" );
+         nrv.rows.push_back( std::move( row ) );
+      }
+      else if( word == "INSERT" ) {
+         nrv.command = "INSERT 0 1";
+      }
+      else if( ( word == "UPDATE" ) || ( word == "DELETE" ) ) {
+         nrv.command = word + " 1";
+      }
+      else {
+         nrv.command = word;
+      }
+      return nrv;
+   }
+
+   struct test_server_options
+   {
+      std::chrono::microseconds latency{ 0 };  // added before each response is sent
+      std::chrono::microseconds jitter{ 0 };   // the latency varies uniformly by up to +/- jitter
+      std::uint64_t bandwidth = 0;             // of responses, in bytes per second, 0 is unlimited
+      std::uint32_t seed = 42;                 // for the jitter, combined with the connection number
+   };
+
+   using test_server_handler = std::function< canned_result( const std::string& statement, const std::vector< std::optional< std::string > >& parameters ) >;
+
+   class test_server
+   {
+   private:
+      const test_server_options m_options;
+      const test_server_handler m_handler;
+
+      int m_listen = -1;
+      std::uint16_t m_port = 0;
+      std::thread m_acceptor;
+
+      std::mutex m_mutex;
+      std::list< std::pair< int, std::thread > > m_sessions;
+
+      std::atomic< std::size_t > m_connections{ 0 };
+      std::atomic< std::size_t > m_statements{ 0 };
+      std::atomic< std::size_t > m_copied_rows{ 0 };
+
+      // the messages streamed after START_REPLICATION, and the status updates received
+      std::mutex m_wal_mutex;
+      std::vector< std::string > m_wal;
+      std::atomic< std::uint64_t > m_flushed_lsn{ 0 };
+      std::atomic< std::size_t > m_status_updates{ 0 };
+
+      // notifications are sent to the listening session's socket directly,
+      // the session's mutex serializes them with the session's own output
+      struct listener
+      {
+         std::string channel;
+         int socket;
+         std::shared_ptr< std::mutex > mutex;
+      };
+      std::mutex m_listeners_mutex;
+      std::list< listener > m_listeners;
+
+      void listen( const std::string& channel, const int socket, const std::shared_ptr< std::mutex >& mutex )
+      {
+         const std::lock_guard lock( m_listeners_mutex );
+         for( const auto& l : m_listeners ) {
+            if( ( l.socket == socket ) && ( l.channel == channel ) ) {
+               return;
+            }
+         }
+         m_listeners.push_back( { channel, socket, mutex } );
+      }
+
+      // an empty channel stops listening on all channels
+      void unlisten( const std::string& channel, const int socket )
+      {
+         const std::lock_guard lock( m_listeners_mutex );
+         m_listeners.remove_if( [ & ]( const listener& l ) {
+            return ( l.socket == socket ) && ( channel.empty() || ( l.channel == channel ) );
+         } );
+      }
+
+      void notify( const std::string& channel, const std::string& message )
+      {
+         const std::lock_guard lock( m_listeners_mutex );
+         for( const auto& l : m_listeners ) {
+            if( l.channel == channel ) {
+               const std::lock_guard send_lock( *l.mutex );
+               (void)::send( l.socket, message.data(), message.size(), MSG_NOSIGNAL );
+            }
+         }
+      }
+
+      class session
+      {
+      private:
+         test_server& m_server;
+         const int m_socket;
+         const std::int32_t m_pid;
+         const std::shared_ptr< std::mutex > m_send_mutex = std::make_shared< std::mutex >();
+         std::mt19937 m_rng;
+         std::string m_in;
+         std::string m_out;
+         char m_status = 'I';
+
+         struct portal
+         {
+            std::string statement;
+            std::vector< std::optional< std::string > > parameters;
+            std::optional< canned_result > result;
+         };
+         std::map< std::string, std::string > m_prepared;
+         std::map< std::string, portal > m_portals;
+         bool m_skip_to_sync = false;
+         bool m_extended_copy = false;
+         std::size_t m_copy_rows = 0;
+         bool m_replicating = false;
+
+         static void put16( std::string& s, const int v )
+         {
+            s += static_cast< char >( ( v >> 8 ) & 0xff );
+            s += static_cast< char >( v & 0xff );
+         }
+
+         static void put32( std::string& s, const std::int32_t v )
+         {
+            const auto u = static_cast< std::uint32_t >( v );
+            for( int shift = 24; shift >= 0; shift -= 8 ) {
+               s += static_cast< char >( ( u >> shift ) & 0xff );
+            }
+         }
+
+         static void put64( std::string& s, const std::uint64_t v )
+         {
+            for( int shift = 56; shift >= 0; shift -= 8 ) {
+               s += static_cast< char >( ( v >> shift ) & 0xff );
+            }
+         }
+
+         [[nodiscard]] static auto get16( const char* p ) noexcept -> int
+         {
+            return static_cast< std::int16_t >( ( static_cast< unsigned char >( p[ 0 ] ) << 8 ) | static_cast< unsigned char >( p[ 1 ] ) );
+         }
+
+         [[nodiscard]] static auto get32( const char* p ) noexcept -> std::int32_t
+         {
+            std::uint32_t u = 0;
+            for( int i = 0; i < 4; ++i ) {
+               u = ( u << 8 ) | static_cast< unsigned char >( p[ i ] );
+            }
+            return static_cast< std::int32_t >( u );
+         }
+
+         void message( const char type, const std::string& body = std::string() )
+         {
+            m_out += type;
+            put32( m_out, static_cast< std::int32_t >( body.size() + 4 ) );
+            m_out += body;
+         }
+
+         [[nodiscard]] auto read( const std::size_t size ) -> bool
+         {
+            char buffer[ 65536 ];
+            while( m_in.size() < size ) {
+               const auto r = ::recv( m_socket, buffer, sizeof( buffer ), 0 );
+               if( r <= 0 ) {
+                  return false;
+               }
+               m_in.append( buffer, static_cast< std::size_t >( r ) );
+            }
+            return true;
+         }
+
+         // sends the pending output after the injected latency
+         void flush()
+         {
+            if( m_out.empty() ) {
+               return;
+            }
+            const auto& o = m_server.m_options;
+            auto delay = std::chrono::duration_cast< std::chrono::nanoseconds >( o.latency );
+            if( o.jitter.count() > 0 ) {
+               const auto j = std::chrono::duration_cast< std::chrono::nanoseconds >( o.jitter ).count();
+               delay += std::chrono::nanoseconds( std::uniform_int_distribution< std::int64_t >( -j, j )( m_rng ) );
+            }
+            if( o.bandwidth > 0 ) {
+               delay += std::chrono::nanoseconds( static_cast< std::int64_t >( m_out.size() * 1000000000ULL / o.bandwidth ) );
+            }
+            if( delay.count() > 0 ) {
+               std::this_thread::sleep_for( delay );
+            }
+            const std::lock_guard lock( *m_send_mutex );
+            std::size_t sent = 0;
+            while( sent < m_out.size() ) {
+               const auto r = ::send( m_socket, m_out.data() + sent, m_out.size() - sent, MSG_NOSIGNAL );
+               if( r <= 0 ) {
+                  break;
+               }
+               sent += static_cast< std::size_t >( r );
+            }
+            m_out.clear();
+         }
+
+         void error( const std::string& sqlstate, const std::string& text )
+         {
+            std::string body;
+            body += "SERROR";
+            body += '\0';
+            body += "VERROR";
+            body += '\0';
+            body += 'C' + sqlstate;
+            body += '\0';
+            body += 'M' + text;
+            body += '\0';
+            body += '\0';
+            message( 'E', body );
+            if( m_status == 'T' ) {
+               m_status = 'E';
+            }
+         }
+
+         void ready()
+         {
+            message( 'Z', std::string( 1, m_status ) );
+            flush();
+         }
+
+         void row_description( const canned_result& r )
+         {
+            if( r.columns.empty() ) {
+               message( 'n' );
+               return;
+            }
+            std::string body;
+            put16( body, static_cast< int >( r.columns.size() ) );
+            for( const auto& c : r.columns ) {
+               body += c;
+               body += '\0';
+               put32( body, 0 );   // table
+               put16( body, 0 );   // column
+               put32( body, 25 );  // text
+               put16( body, -1 );  // size
+               put32( body, -1 );  // modifier
+               put16( body, 0 );   // text format
+            }
+            message( 'T', body );
+         }
+
+         void data_rows( const canned_result& r )
+         {
+            for( const auto& row : r.rows ) {
+               std::string body;
+               put16( body, static_cast< int >( row.size() ) );
+               for( const auto& v : row ) {
+                  if( v ) {
+                     put32( body, static_cast< std::int32_t >( v->size() ) );
+                     body += *v;
+                  }
+                  else {
+                     put32( body, -1 );
+                  }
+               }
+               message( 'D', body );
+            }
+         }
+
+         [[nodiscard]] static auto words( const std::string& statement ) -> std::vector< std::string >
+         {
+            std::vector< std::string > nrv( 1 );
+            for( const char c : statement ) {
+               if( std::isalpha( static_cast< unsigned char >( c ) ) != 0 ) {
+                  nrv.back() += static_cast< char >( std::toupper( static_cast< unsigned char >( c ) ) );
+               }
+               else if( !nrv.back().empty() ) {
+                  if( nrv.size() == 3 ) {
+                     break;
+                  }
+                  nrv.emplace_back();
+               }
+            }
+            return nrv;
+         }
+
+         // reads a (possibly quoted) identifier starting at or after pos
+         [[nodiscard]] static auto identifier( const std::string& statement, std::size_t pos ) -> std::string
+         {
+            pos = statement.find_first_not_of( " \t\n", pos );
+            std::string nrv;
+            if( pos == std::string::npos ) {
+               return nrv;
+            }
+            if( statement[ pos ] == '"' ) {
+               while( ++pos < statement.size() ) {
+                  if( statement[ pos ] == '"' ) {
+                     if( ( pos + 1 < statement.size() ) && ( statement[ pos + 1 ] == '"' ) ) {
+                        ++pos;
+                     }
+                     else {
+                        break;
+                     }
+                  }
+                  nrv += statement[ pos ];
+               }
+               return nrv;
+            }
+            while( ( pos < statement.size() ) && ( ( std::isalnum( static_cast< unsigned char >( statement[ pos ] ) ) != 0 ) || ( statement[ pos ] == '_' ) ) ) {
+               nrv += static_cast< char >( std::tolower( static_cast< unsigned char >( statement[ pos++ ] ) ) );
+            }
+            return nrv;
+         }
+
+         void notify( const std::string& channel, const std::string& payload )
+         {
+            std::string body;
+            put32( body, m_pid );
+            body += channel;
+            body += '\0';
+            body += payload;
+            body += '\0';
+            std::string message;
+            message += 'A';
+            put32( message, static_cast< std::int32_t >( body.size() + 4 ) );
+            message += body;
+            m_server.notify( channel, message );
+         }
+
+         // LISTEN, UNLISTEN, NOTIFY without a payload and SELECT pg_notify( $1, $2 )
+         [[nodiscard]] auto notification( const std::vector< std::string >& w, const std::string& statement, const std::vector< std::optional< std::string > >& parameters ) -> std::optional< canned_result >
+         {
+            const auto& first = w.front();
+            if( ( first == "LISTEN" ) || ( first == "UNLISTEN" ) || ( first == "NOTIFY" ) ) {
+               const auto channel = identifier( statement, statement.find_first_of( " \t\n" ) );
+               if( first == "LISTEN" ) {
+                  m_server.listen( channel, m_socket, m_send_mutex );
+               }
+               else if( first == "UNLISTEN" ) {
+                  m_server.unlisten( channel, m_socket );
+               }
+               else {
+                  notify( channel, std::string() );
+               }
+               canned_result nrv;
+               nrv.command = first;
+               return nrv;
+            }
+            if( ( statement.find( "pg_notify" ) != std::string::npos ) && ( parameters.size() == 2 ) && parameters[ 0 ] ) {
+               notify( *parameters[ 0 ], parameters[ 1 ].value_or( std::string() ) );
+               canned_result nrv;
+               nrv.columns = { "pg_notify" };
+               nrv.rows = { { std::string() } };
+               return nrv;
+            }
+            return std::nullopt;
+         }
+
+         [[nodiscard]] static auto is_copy_in( const std::vector< std::string >& w, const std::string& statement ) -> bool
+         {
+            if( w.front() != "COPY" ) {
+               return false;
+            }
+            std::string upper;
+            for( const char c : statement ) {
+               upper += static_cast< char >( std::toupper( static_cast< unsigned char >( c ) ) );
+            }
+            return upper.find( "FROM STDIN" ) != std::string::npos;
+         }
+
+         // returns the result, or an error result, also tracks the transaction status
+         [[nodiscard]] auto evaluate( const std::string& statement, const std::vector< std::optional< std::string > >& parameters ) -> canned_result
+         {
+            const auto w = words( statement );
+            const auto& first = w.front();
+            const bool rollback = ( first == "ROLLBACK" ) || ( first == "ABORT" );
+            const bool savepoint = ( w.size() > 1 ) && ( w[ 1 ] == "TO" );
+            if( ( m_status == 'E' ) && !rollback && ( first != "COMMIT" ) && ( first != "END" ) ) {
+               canned_result nrv;
+               nrv.error = "current transaction is aborted, commands ignored until end of transaction block";
+               nrv.sqlstate = "25P02";
+               return nrv;
+            }
+            if( auto n = notification( w, statement, parameters ) ) {
+               return *n;
+            }
+            auto nrv = m_server.m_handler( statement, parameters );
+            if( !nrv.error.empty() ) {
+               return nrv;
+            }
+            if( !nrv.columns.empty() && nrv.command.empty() ) {
+               nrv.command = "SELECT " + std::to_string( nrv.rows.size() );
+            }
+            if( ( first == "BEGIN" ) || ( first == "START" ) ) {
+               m_status = 'T';
+            }
+            else if( ( first == "COMMIT" ) || ( first == "END" ) || ( rollback && !savepoint ) ) {
+               if( m_status == 'E' ) {
+                  nrv.command = "ROLLBACK";
+               }
+               m_status = 'I';
+            }
+            else if( rollback && savepoint && ( m_status == 'E' ) ) {
+               m_status = 'T';
+            }
+            return nrv;
+         }
+
+         [[nodiscard]] auto complete( const canned_result& r ) -> bool
+         {
+            if( !r.error.empty() ) {
+               error( r.sqlstate, r.error );
+               return false;
+            }
+            data_rows( r );
+            message( 'C', r.command + '\0' );
+            return true;
+         }
+
+         void copy_in()
+         {
+            std::string body;
+            body += '\0';  // text format
+            put16( body, 0 );
+            message( 'G', body );
+            m_copy_rows = 0;
+            flush();
+         }
+
+         // streams the messages as XLogData, the n-th at the position n * 0x1000,
+         // followed by a keepalive which requests a status update
+         void start_replication( const std::string& statement )
+         {
+            const auto r = m_server.m_handler( statement, {} );
+            if( !r.error.empty() ) {
+               error( r.sqlstate, r.error );
+               ready();
+               return;
+            }
+            std::string body;
+            body += '\0';  // text format
+            put16( body, 0 );
+            message( 'W', body );
+            m_replicating = true;
+            std::uint64_t lsn = 0;
+            const std::lock_guard lock( m_server.m_wal_mutex );
+            for( const auto& wal : m_server.m_wal ) {
+               lsn += 0x1000;
+               body = "w";
+               put64( body, lsn );
+               put64( body, lsn );
+               put64( body, 0 );
+               message( 'd', body + wal );
+            }
+            body = "k";
+            put64( body, lsn );
+            put64( body, 0 );
+            body += '\1';
+            message( 'd', body );
+            flush();
+         }
+
+         void query( const std::string& statement )
+         {
+            m_server.m_statements.fetch_add( 1, std::memory_order_relaxed );
+            if( statement.find_first_not_of( " \t\n;" ) == std::string::npos ) {
+               message( 'I' );
+               ready();
+               return;
+            }
+            if( is_copy_in( words( statement ), statement ) ) {
+               m_extended_copy = false;
+               copy_in();
+               return;
+            }
+            if( statement.compare( 0, 17, "START_REPLICATION" ) == 0 ) {
+               start_replication( statement );
+               return;
+            }
+            const auto r = evaluate( statement, {} );
+            if( r.error.empty() ) {
+               row_description( r );
+            }
+            (void)complete( r );
+            ready();
+         }
+
+         void parse( const char* p )
+         {
+            const std::string name = p;
+            p += name.size() + 1;
+            m_prepared[ name ] = p;
+            message( '1' );
+         }
+
+         void bind( const char* p )
+         {
+            const std::string name = p;
+            p += name.size() + 1;
+            portal& target = m_portals[ name ];
+            target.statement = m_prepared.at( p );
+            p += std::strlen( p ) + 1;
+            p += 2 + 2 * get16( p );
+            const int n = get16( p );
+            p += 2;
+            target.parameters.clear();
+            for( int i = 0; i < n; ++i ) {
+               const auto size = get32( p );
+               p += 4;
+               if( size < 0 ) {
+                  target.parameters.emplace_back();
+               }
+               else {
+                  target.parameters.emplace_back( std::string( p, static_cast< std::size_t >( size ) ) );
+                  p += size;
+               }
+            }
+            target.result.reset();
+            message( '2' );
+         }
+
+         [[nodiscard]] auto describe( const char* p ) -> bool
+         {
+            if( *p == 'S' ) {
+               const auto& statement = m_prepared.at( p + 1 );
+               int n = 0;
+               for( std::size_t pos = statement.find( '$' ); pos != std::string::npos; pos = statement.find( '$', pos + 1 ) ) {
+                  n = std::max( n, std::atoi( statement.c_str() + pos + 1 ) );
+               }
+               std::string body;
+               put16( body, n );
+               for( int i = 0; i < n; ++i ) {
+                  put32( body, 25 );
+               }
+               message( 't', body );
+               message( 'n' );
+               return true;
+            }
+            auto& current = m_portals.at( p + 1 );
+            if( is_copy_in( words( current.statement ), current.statement ) ) {
+               message( 'n' );
+               return true;
+            }
+            current.result = evaluate( current.statement, current.parameters );
+            if( !current.result->error.empty() ) {
+               error( current.result->sqlstate, current.result->error );
+               return false;
+            }
+            row_description( *current.result );
+            return true;
+         }
+
+         [[nodiscard]] auto execute( const char* p ) -> bool
+         {
+            auto& current = m_portals.at( p );
+            m_server.m_statements.fetch_add( 1, std::memory_order_relaxed );
+            if( current.statement.find_first_not_of( " \t\n;" ) == std::string::npos ) {
+               message( 'I' );
+               return true;
+            }
+            if( is_copy_in( words( current.statement ), current.statement ) ) {
+               m_extended_copy = true;
+               copy_in();
+               return true;
+            }
+            if( !current.result ) {
+               current.result = evaluate( current.statement, current.parameters );
+            }
+            const bool nrv = complete( *current.result );
+            current.result.reset();
+            return nrv;
+         }
+
+         [[nodiscard]] auto startup() -> bool
+         {
+            while( true ) {
+               if( !read( 4 ) ) {
+                  return false;
+               }
+               const auto size = static_cast< std::size_t >( get32( m_in.data() ) );
+               if( ( size < 8 ) || !read( size ) ) {
+                  return false;
+               }
+               const auto code = get32( m_in.data() + 4 );
+               m_in.erase( 0, size );
+               if( ( code == 80877103 ) || ( code == 80877104 ) ) {
+                  // no SSL and no GSSAPI encryption
+                  if( ::send( m_socket, "N", 1, MSG_NOSIGNAL ) != 1 ) {
+                     return false;
+                  }
+                  continue;
+               }
+               if( code != 196608 ) {
+                  return false;  // e.g. a cancel request
+               }
+               break;
+            }
+            std::string body;
+            put32( body, 0 );
+            message( 'R', body );
+            for( const auto& [ name, value ] : { std::pair( "server_version", "15.0" ),
+                                                 std::pair( "server_encoding", "UTF8" ),
+                                                 std::pair( "client_encoding", "UTF8" ),
+                                                 std::pair( "DateStyle", "ISO, MDY" ),
+                                                 std::pair( "TimeZone", "UTC" ),
+                                                 std::pair( "integer_datetimes", "on" ),
+                                                 std::pair( "standard_conforming_strings", "on" ) } ) {
+               message( 'S', std::string( name ) + '\0' + value + '\0' );
+            }
+            body.clear();
+            put32( body, m_pid );
+            put32( body, 42 );
+            message( 'K', body );
+            ready();
+            return true;
+         }
+
+      public:
+         session( test_server& server, const int socket, const std::size_t number )
+            : m_server( server ),
+              m_socket( socket ),
+              m_pid( static_cast< std::int32_t >( 4711 + number ) ),
+              m_rng( server.m_options.seed + static_cast< std::uint32_t >( number ) )
+         {}
+
+         session( const session& ) = delete;
+         session( session&& ) = delete;
+         void operator=( const session& ) = delete;
+         void operator=( session&& ) = delete;
+
+         ~session()
+         {
+            m_server.unlisten( std::string(), m_socket );
+         }
+
+         void run()
+         {
+            if( !startup() ) {
+               return;
+            }
+            while( read( 5 ) ) {
+               const char type = m_in[ 0 ];
+               const auto size = static_cast< std::size_t >( get32( m_in.data() + 1 ) );
+               if( ( size < 4 ) || !read( 1 + size ) ) {
+                  return;
+               }
+               const std::string body = m_in.substr( 5, size - 4 );
+               m_in.erase( 0, 1 + size );
+               const char* p = body.c_str();
+
+               switch( type ) {
+                  case 'X':
+                     return;
+
+                  case 'Q':
+                     query( p );
+                     break;
+
+                  case 'd':
+                     if( m_replicating ) {
+                        // a standby status update, with the written, flushed and applied positions
+                        if( ( body.size() >= 34 ) && ( body[ 0 ] == 'r' ) ) {
+                           std::uint64_t flushed = 0;
+                           for( std::size_t i = 9; i < 17; ++i ) {
+                              flushed = ( flushed << 8 ) | static_cast< unsigned char >( body[ i ] );
+                           }
+                           m_server.m_flushed_lsn.store( flushed, std::memory_order_relaxed );
+                           m_server.m_status_updates.fetch_add( 1, std::memory_order_relaxed );
+                        }
+                        break;
+                     }
+                     m_copy_rows += static_cast< std::size_t >( std::count( body.begin(), body.end(), '\n' ) );
+                     break;
+
+                  case 'c':
+                     if( m_replicating ) {
+                        m_replicating = false;
+                        message( 'c' );
+                        message( 'C', std::string( "START_REPLICATION" ) + '\0' );
+                        ready();
+                        break;
+                     }
+                     m_server.m_copied_rows.fetch_add( m_copy_rows, std::memory_order_relaxed );
+                     message( 'C', "COPY " + std::to_string( m_copy_rows ) + '\0' );
+                     if( m_extended_copy ) {
+                        m_extended_copy = false;
+                        m_skip_to_sync = false;
+                     }
+                     else {
+                        ready();
+                     }
+                     break;
+
+                  case 'f':
+                     error( "57014", "COPY from stdin failed: " + body );
+                     if( m_extended_copy ) {
+                        m_extended_copy = false;
+                        m_skip_to_sync = true;
+                     }
+                     else {
+                        ready();
+                     }
+                     break;
+
+                  case 'S':
+                     // a Sync sent before the COPY data is ignored
+                     if( !m_extended_copy ) {
+                        m_skip_to_sync = false;
+                        m_portals.erase( std::string() );
+                        ready();
+                     }
+                     break;
+
+                  case 'H':
+                     flush();
+                     break;
+
+                  default:
+                     if( m_skip_to_sync ) {
+                        break;
+                     }
+                     switch( type ) {
+                        case 'P':
+                           parse( p );
+                           break;
+
+                        case 'B':
+                           bind( p );
+                           break;
+
+                        case 'D':
+                           m_skip_to_sync = !describe( p );
+                           break;
+
+                        case 'E':
+                           m_skip_to_sync = !execute( p );
+                           break;
+
+                        case 'C':
+                           if( *p == 'S' ) {
+                              m_prepared.erase( p + 1 );
+                           }
+                           else {
+                              m_portals.erase( p + 1 );
+                           }
+                           message( '3' );
+                           break;
+
+                        default:
+                           error( "08P01", std::string( "unsupported message type " ) + type );
+                           m_skip_to_sync = true;
+                     }
+               }
+            }
+         }
+      };
+
+      void accept()
+      {
+         while( true ) {
+            const int socket = ::accept( m_listen, nullptr, nullptr );
+            if( socket < 0 ) {
+               return;
+            }
+            const int one = 1;
+            (void)::setsockopt( socket, IPPROTO_TCP, TCP_NODELAY, &one, sizeof( one ) );
+            const auto number = m_connections.fetch_add( 1, std::memory_order_relaxed );
+            const std::lock_guard lock( m_mutex );
+            m_sessions.emplace_back( socket, std::thread( [ this, socket, number ] {
+                                        try {
+                                           session( *this, socket, number ).run();
+                                        }
+                                        catch( ... ) {
+                                           // malformed input, drop the connection
+                                        }
+                                        ::shutdown( socket, SHUT_RDWR );
+                                     } ) );
+         }
+      }
+
+   public:
+      explicit test_server( const test_server_options& options = test_server_options(), test_server_handler handler = default_canned_result )
+         : m_options( options ),
+           m_handler( std::move( handler ) )
+      {
+         m_listen = ::socket( AF_INET, SOCK_STREAM, 0 );
+         if( m_listen < 0 ) {
+            throw std::runtime_error( "socket() failed" );
+         }
+         sockaddr_in address{};
+         address.sin_family = AF_INET;
+         address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+         address.sin_port = 0;
+         socklen_t length = sizeof( address );
+         if( ( ::bind( m_listen, reinterpret_cast< sockaddr* >( &address ), sizeof( address ) ) != 0 ) ||  // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+             ( ::listen( m_listen, 128 ) != 0 ) ||
+             ( ::getsockname( m_listen, reinterpret_cast< sockaddr* >( &address ), &length ) != 0 ) ) {  // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+            ::close( m_listen );
+            throw std::runtime_error( "unable to listen on the loopback interface" );
+         }
+         m_port = ntohs( address.sin_port );
+         m_acceptor = std::thread( [ this ] { accept(); } );
+      }
+
+      test_server( const test_server& ) = delete;
+      test_server( test_server&& ) = delete;
+      void operator=( const test_server& ) = delete;
+      void operator=( test_server&& ) = delete;
+
+      ~test_server()
+      {
+         ::shutdown( m_listen, SHUT_RDWR );
+         m_acceptor.join();
+         ::close( m_listen );
+         for( auto& [ socket, thread ] : m_sessions ) {
+            ::shutdown( socket, SHUT_RDWR );
+            thread.join();
+            ::close( socket );
+         }
+      }
+
+      [[nodiscard]] auto port() const noexcept -> std::uint16_t
+      {
+         return m_port;
+      }
+
+      [[nodiscard]] auto connection_info() const -> std::string
+      {
+         return "host=127.0.0.1 port=" + std::to_string( m_port ) + " user=test dbname=test connect_timeout=5";
+      }
+
+      [[nodiscard]] auto connections() const noexcept -> std::size_t
+      {
+         return m_connections.load( std::memory_order_relaxed );
+      }
+
+      // statements executed, including those that failed
+      [[nodiscard]] auto statements() const noexcept -> std::size_t
+      {
+         return m_statements.load( std::memory_order_relaxed );
+      }
+
+      [[nodiscard]] auto copied_rows() const noexcept -> std::size_t
+      {
+         return m_copied_rows.load( std::memory_order_relaxed );
+      }
+
+      // the messages streamed by sessions which start replicating afterwards
+      void stream( std::vector< std::string > wal )
+      {
+         const std::lock_guard lock( m_wal_mutex );
+         m_wal = std::move( wal );
+      }
+
+      // the flushed position of the last standby status update
+      [[nodiscard]] auto flushed_lsn() const noexcept -> std::uint64_t
+      {
+         return m_flushed_lsn.load( std::memory_order_relaxed );
+      }
+
+      [[nodiscard]] auto status_updates() const noexcept -> std::size_t
+      {
+         return m_status_updates.load( std::memory_order_relaxed );
+      }
+   };
+
+}  // namespace tao::pq::internal
+
+#endif
+
+#endif